@@ -54,6 +54,25 @@ esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t
  */
 esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+/**
+ * @brief Set a range of pixels from an array of colors
+ *
+ * @note One call for a whole strip: the range is checked once and the colors are reordered into the wire
+ *       order of the strip several pixels at a time, instead of a `led_strip_set_pixel` call per pixel
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param colors: count pixels, 3 bytes each (red, green, blue) or 4 bytes each (red, green, blue, white)
+ * @param format: layout of colors, LED_STRIP_COLOR_RGBW only on strips with a white component
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set the pixels failed because of invalid parameters
+ *      - ESP_FAIL: Set the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *colors, led_strip_color_format_t format);
+
 /**
  * @brief Set HSV for a specific pixel
  *
@@ -70,6 +89,23 @@ esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uin
  */
 esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value);
 
+/**
+ * @brief Set a range of pixels from an array of HSV colors
+ *
+ * @note Same colors as `led_strip_set_pixel_hsv`, converted with integer arithmetic only and set with `led_strip_set_pixels`
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param colors: count HSV colors
+ *
+ * @return
+ *      - ESP_OK: Set the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set the pixels failed because of invalid parameters
+ *      - ESP_FAIL: Set the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_strip_hsv_t *colors);
+
 /**
  * @brief Refresh memory colors to LEDs
  *
@@ -84,6 +120,34 @@ esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint
  */
 esp_err_t led_strip_refresh(led_strip_handle_t strip);
 
+/**
+ * @brief Start sending memory colors to LEDs, without waiting for the end of the transmission
+ *
+ * @note With a RMT strip created with `flags.async_refresh` the colors are handed to the RMT driver and the
+ *       pixels can be set again right away for the next refresh: they go to the second pixel buffer, which
+ *       starts as a copy of the colors being sent. A previous refresh still in progress is waited for first.
+ *       Backends without asynchronous refresh do a blocking `led_strip_refresh`.
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh started successfully
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+
+/**
+ * @brief Wait for the end of the refresh started by `led_strip_refresh_async`
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: how long to wait, -1 for ever
+ *
+ * @return
+ *      - ESP_OK: The LEDs show the last colors sent
+ *      - ESP_ERR_TIMEOUT: The refresh is still going on
+ */
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int timeout_ms);
+
 /**
  * @brief Clear LED strip (turn off all LEDs)
  *
@@ -29,8 +29,16 @@ typedef struct {
     uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
 #endif
     size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    led_strip_refresh_done_cb_t on_refresh_done; /*!< Called from ISR at the end of each refresh, optional */
+    void *user_ctx;             /*!< User data passed to on_refresh_done */
+#endif
     struct {
         uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t async_refresh: 1; /*!< Two pixel buffers: `led_strip_refresh_async` returns while the previous colors go out,
+                                        and the RMT channel stays enabled (IDF v5 driver only) */
+        uint32_t symbol_cache: 1;  /*!< Keep the RMT symbols of every pixel, rebuilt only for the pixels set since the last refresh,
+                                        so a refresh is a plain copy. Costs 32 bytes per color byte (IDF v5 driver only) */
     } flags;                    /*!< Extra driver flags */
 } led_strip_rmt_config_t;
 
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -20,6 +21,23 @@ typedef enum {
     LED_PIXEL_FORMAT_INVALID /*!< Invalid pixel format */
 } led_pixel_format_t;
 
+/**
+ * @brief Layout of the colors given to `led_strip_set_pixels`
+ */
+typedef enum {
+    LED_STRIP_COLOR_RGB,  /*!< 3 bytes per pixel: red, green, blue */
+    LED_STRIP_COLOR_RGBW, /*!< 4 bytes per pixel: red, green, blue, white */
+} led_strip_color_format_t;
+
+/**
+ * @brief HSV color given to `led_strip_set_pixels_hsv`
+ */
+typedef struct {
+    uint16_t hue;       /*!< Hue (0 - 360) */
+    uint8_t saturation; /*!< Saturation (0 - 255) */
+    uint8_t value;      /*!< Value (0 - 255) */
+} led_strip_hsv_t;
+
 /**
  * @brief LED strip model
  * @note Different led model may have different timing parameters, so we need to distinguish them.
@@ -35,6 +53,16 @@ typedef enum {
  */
 typedef struct led_strip_t *led_strip_handle_t;
 
+/**
+ * @brief Called from the interrupt that ends the transmission of a refresh
+ *
+ * @param strip: LED strip
+ * @param user_ctx: user data given in the backend configuration
+ *
+ * @return true if a higher priority task was woken up
+ */
+typedef bool (*led_strip_refresh_done_cb_t)(led_strip_handle_t strip, void *user_ctx);
+
 /**
  * @brief LED Strip Configuration
  */
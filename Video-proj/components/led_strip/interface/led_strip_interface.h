@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include "esp_err.h"
+#include "led_strip_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +52,21 @@ struct led_strip_t {
      */
     esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+    /**
+     * @brief Set a range of pixels from an array of colors. Optional, NULL falls back to `set_pixel` per pixel
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set, the whole range is checked once against the strip length
+     * @param colors: count pixels in the layout given by format
+     * @param format: layout of colors
+     *
+     * @return
+     *      - ESP_OK: Set the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set the pixels failed because the range exceeds the strip or the format does not fit it
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_strip_color_format_t format);
+
     /**
      * @brief Refresh memory colors to LEDs
      *
@@ -66,6 +82,29 @@ struct led_strip_t {
      */
     esp_err_t (*refresh)(led_strip_t *strip);
 
+    /**
+     * @brief Start sending the memory colors to LEDs and return. Optional, NULL falls back to `refresh`
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Refresh started successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip);
+
+    /**
+     * @brief Wait for the end of the last refresh started by `refresh_async`. Optional with it
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: how long to wait, -1 for ever
+     *
+     * @return
+     *      - ESP_OK: No refresh in progress anymore
+     *      - ESP_ERR_TIMEOUT: The refresh is still going on
+     */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, int timeout_ms);
+
     /**
      * @brief Clear LED strip (turn off all LEDs)
      *
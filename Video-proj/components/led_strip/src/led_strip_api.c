@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_pixels.h"
+
+static const char *TAG = "led_strip";
+
+// HSV colors converted on the stack, this many at a time
+#define HSV_CHUNK 32
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->set_pixel(strip, index, red, green, blue);
+}
+
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *colors, led_strip_color_format_t format)
+{
+    ESP_RETURN_ON_FALSE(strip && (colors || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->set_pixels) {
+        return strip->set_pixels(strip, start, count, colors, format);
+    }
+    // Backend without a bulk path, one pixel at a time
+    for (uint32_t i = 0; i < count; i++) {
+        esp_err_t ret;
+        if (format == LED_STRIP_COLOR_RGBW) {
+            const uint8_t *c = colors + i * 4;
+            ret = strip->set_pixel_rgbw(strip, start + i, c[0], c[1], c[2], c[3]);
+        } else {
+            const uint8_t *c = colors + i * 3;
+            ret = strip->set_pixel(strip, start + i, c[0], c[1], c[2]);
+        }
+        ESP_RETURN_ON_ERROR(ret, TAG, "set pixel %"PRIu32" failed", start + i);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    led_strip_hsv_t hsv = {
+        .hue = hue,
+        .saturation = saturation,
+        .value = value,
+    };
+    uint8_t rgb[3];
+    led_strip_hsv_to_rgb(rgb, &hsv, 1);
+    return strip->set_pixel(strip, index, rgb[0], rgb[1], rgb[2]);
+}
+
+esp_err_t led_strip_set_pixels_hsv(led_strip_handle_t strip, uint32_t start, uint32_t count, const led_strip_hsv_t *colors)
+{
+    ESP_RETURN_ON_FALSE(strip && (colors || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    uint8_t rgb[HSV_CHUNK * 3];
+    while (count > 0) {
+        uint32_t n = count < HSV_CHUNK ? count : HSV_CHUNK;
+        led_strip_hsv_to_rgb(rgb, colors, n);
+        ESP_RETURN_ON_ERROR(led_strip_set_pixels(strip, start, n, rgb, LED_STRIP_COLOR_RGB), TAG, "set pixels failed");
+        start += n;
+        count -= n;
+        colors += n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->set_pixel_rgbw(strip, index, red, green, blue, white);
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->refresh(strip);
+}
+
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->refresh_async) {
+        return strip->refresh_async(strip);
+    }
+    return strip->refresh(strip);
+}
+
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->wait_refresh_done) {
+        return strip->wait_refresh_done(strip, timeout_ms);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->clear(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return strip->del(strip);
+}
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "led_strip_pixels.h"
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the pixel shuffles assume little endian words"
+#endif
+
+// memcpy keeps the loads and stores legal at any alignment, the compiler turns them into word accesses where it can
+static inline uint32_t load32(const uint8_t *p)
+{
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void store32(uint8_t *p, uint32_t w)
+{
+    memcpy(p, &w, sizeof(w));
+}
+
+void led_strip_rgb_to_grb(uint8_t *grb, const uint8_t *rgb, uint32_t count)
+{
+    // 4 pixels are 3 words: R0 G0 B0 R1 | G1 B1 R2 G2 | B2 R3 G3 B3
+    //                   to  G0 R0 B0 G1 | R1 B1 G2 R2 | B2 G3 R3 B3
+    for (; count >= 4; count -= 4, rgb += 12, grb += 12) {
+        uint32_t w0 = load32(rgb);
+        uint32_t w1 = load32(rgb + 4);
+        uint32_t w2 = load32(rgb + 8);
+        store32(grb, ((w0 >> 8) & 0xFF) | ((w0 << 8) & 0xFF00) | (w0 & 0xFF0000) | (w1 << 24));
+        store32(grb + 4, (w0 >> 24) | (w1 & 0xFF00) | ((w1 >> 8) & 0xFF0000) | ((w1 << 8) & 0xFF000000));
+        store32(grb + 8, (w2 & 0xFF0000FF) | ((w2 >> 8) & 0xFF00) | ((w2 << 8) & 0xFF0000));
+    }
+    for (; count > 0; count--, rgb += 3, grb += 3) {
+        grb[0] = rgb[1];
+        grb[1] = rgb[0];
+        grb[2] = rgb[2];
+    }
+}
+
+void led_strip_rgb_to_grbw(uint8_t *grbw, const uint8_t *rgb, uint32_t count)
+{
+    // 4 pixels are 3 words in, one word each out
+    for (; count >= 4; count -= 4, rgb += 12, grbw += 16) {
+        uint32_t w0 = load32(rgb);
+        uint32_t w1 = load32(rgb + 4);
+        uint32_t w2 = load32(rgb + 8);
+        store32(grbw, ((w0 >> 8) & 0xFF) | ((w0 << 8) & 0xFF00) | (w0 & 0xFF0000));
+        store32(grbw + 4, (w1 & 0xFF) | ((w0 >> 16) & 0xFF00) | ((w1 << 8) & 0xFF0000));
+        store32(grbw + 8, (w1 >> 24) | ((w1 >> 8) & 0xFF00) | ((w2 & 0xFF) << 16));
+        store32(grbw + 12, ((w2 >> 16) & 0xFF) | (w2 & 0xFF00) | ((w2 >> 8) & 0xFF0000));
+    }
+    for (; count > 0; count--, rgb += 3, grbw += 4) {
+        grbw[0] = rgb[1];
+        grbw[1] = rgb[0];
+        grbw[2] = rgb[2];
+        grbw[3] = 0;
+    }
+}
+
+void led_strip_rgbw_to_grbw(uint8_t *grbw, const uint8_t *rgbw, uint32_t count)
+{
+    // One word per pixel, swap the two low bytes
+    for (; count > 0; count--, rgbw += 4, grbw += 4) {
+        uint32_t w = load32(rgbw);
+        store32(grbw, (w & 0xFFFF0000) | ((w >> 8) & 0xFF) | ((w << 8) & 0xFF00));
+    }
+}
+
+bool led_strip_pixels_convert(uint8_t *dst, uint8_t bytes_per_pixel, const uint8_t *src, led_strip_color_format_t format, uint32_t count)
+{
+    if (format == LED_STRIP_COLOR_RGB) {
+        if (bytes_per_pixel == 3) {
+            led_strip_rgb_to_grb(dst, src, count);
+        } else {
+            led_strip_rgb_to_grbw(dst, src, count);
+        }
+        return true;
+    }
+    if (format == LED_STRIP_COLOR_RGBW && bytes_per_pixel == 4) {
+        led_strip_rgbw_to_grbw(dst, src, count);
+        return true;
+    }
+    return false;
+}
+
+// The four levels a color takes, one per byte of a word: the max, the min, rising from the min and falling
+// from the max. Each 60 degree sector of the hue picks one of them for red, green and blue, by a shift.
+#define HSV_MAX  0
+#define HSV_MIN  8
+#define HSV_UP   16
+#define HSV_DOWN 24
+#define HSV_SECTOR(r, g, b) ((r) | (g) << 8 | (b) << 16)
+
+static const uint32_t hsv_sectors[6] = {
+    HSV_SECTOR(HSV_MAX, HSV_UP, HSV_MIN),
+    HSV_SECTOR(HSV_DOWN, HSV_MAX, HSV_MIN),
+    HSV_SECTOR(HSV_MIN, HSV_MAX, HSV_UP),
+    HSV_SECTOR(HSV_MIN, HSV_DOWN, HSV_MAX),
+    HSV_SECTOR(HSV_UP, HSV_MIN, HSV_MAX),
+    HSV_SECTOR(HSV_MAX, HSV_MIN, HSV_DOWN),
+};
+
+void led_strip_hsv_to_rgb(uint8_t *rgb, const led_strip_hsv_t *hsv, uint32_t count)
+{
+    for (; count > 0; count--, hsv++, rgb += 3) {
+        uint32_t max = hsv->value;
+        // x / 255 and x / 60 for x <= 65535 as a multiply and a shift, checked for every input by led_strip_test
+        uint32_t min = (max * (255 - hsv->saturation) * 0x8081) >> 23;
+        uint32_t sector = (hsv->hue * 0x8889u) >> 21;
+        uint32_t diff = hsv->hue - sector * 60;
+        uint32_t adj = ((max - min) * diff * 0x8889u) >> 21;
+        uint32_t levels = max | min << 8 | (min + adj) << 16 | (max - adj) << 24;
+        uint32_t shifts = hsv_sectors[sector < 5 ? sector : 5];
+        rgb[0] = levels >> (shifts & 0xFF);
+        rgb[1] = levels >> ((shifts >> 8) & 0xFF);
+        rgb[2] = levels >> (shifts >> 16);
+    }
+}
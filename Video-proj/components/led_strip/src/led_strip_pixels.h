@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reorder colors into the wire order of the strip, several pixels per 32-bit word
+ *
+ * @note No dependency on ESP-IDF, the kernels are also built and checked on the host
+ *
+ * @param dst: pixel buffer of the strip, at the first pixel to write
+ * @param bytes_per_pixel: 3 for GRB strips, 4 for GRBW strips
+ * @param src: colors in the layout given by format
+ * @param format: layout of src
+ * @param count: number of pixels
+ *
+ * @return false if the format does not fit the strip (white component on a GRB strip)
+ */
+bool led_strip_pixels_convert(uint8_t *dst, uint8_t bytes_per_pixel, const uint8_t *src, led_strip_color_format_t format, uint32_t count);
+
+/**
+ * @brief HSV to RGB, integer only: the colors of the float conversion `led_strip_set_pixel_hsv` used to do
+ *
+ * @note Hues past 359 keep the colors of the last sector, as before
+ */
+void led_strip_hsv_to_rgb(uint8_t *rgb, const led_strip_hsv_t *hsv, uint32_t count);
+
+/**
+ * @brief RGB to GRB
+ */
+void led_strip_rgb_to_grb(uint8_t *grb, const uint8_t *rgb, uint32_t count);
+
+/**
+ * @brief RGB to GRBW, white left off as `set_pixel` does
+ */
+void led_strip_rgb_to_grbw(uint8_t *grbw, const uint8_t *rgb, uint32_t count);
+
+/**
+ * @brief RGBW to GRBW
+ */
+void led_strip_rgbw_to_grbw(uint8_t *grbw, const uint8_t *rgbw, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
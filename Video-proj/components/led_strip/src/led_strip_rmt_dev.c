@@ -12,6 +12,8 @@
 #include "led_strip.h"
 #include "led_strip_interface.h"
 #include "led_strip_rmt_encoder.h"
+#include "led_strip_pixels.h"
+#include "led_strip_symbol_cache.h"
 
 #define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
 #define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
@@ -28,9 +30,16 @@ typedef struct {
     led_strip_t base;
     rmt_channel_handle_t rmt_chan;
     rmt_encoder_handle_t strip_encoder;
+    led_strip_refresh_done_cb_t on_refresh_done;
+    void *user_ctx;
+    bool async_refresh;
+    bool symbol_cache;
+    led_strip_symbol_cache_t cache; // RMT symbols of the colors last sent, with symbol_cache
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
-    uint8_t pixel_buf[];
+    uint8_t *pixel_buf;  // Colors set by the application
+    uint8_t *tx_buf;     // Colors read by the RMT driver, the second buffer in async mode
+    uint8_t bufs[];      // One pixel buffer, two in async mode
 } led_strip_rmt_obj;
 
 static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -45,6 +54,9 @@ static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uin
     if (rmt_strip->bytes_per_pixel > 3) {
         rmt_strip->pixel_buf[start + 3] = 0;
     }
+    if (rmt_strip->symbol_cache) {
+        led_strip_symbol_cache_mark(&rmt_strip->cache, index, 1);
+    }
     return ESP_OK;
 }
 
@@ -59,37 +71,104 @@ static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     *++buf_start = red & 0xFF;
     *++buf_start = blue & 0xFF;
     *++buf_start = white & 0xFF;
+    if (rmt_strip->symbol_cache) {
+        led_strip_symbol_cache_mark(&rmt_strip->cache, index, 1);
+    }
     return ESP_OK;
 }
 
-static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_strip_color_format_t format)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(led_strip_pixels_convert(rmt_strip->pixel_buf + start * rmt_strip->bytes_per_pixel, rmt_strip->bytes_per_pixel, colors, format, count),
+                        ESP_ERR_INVALID_ARG, TAG, "wrong color format for the LED pixel format");
+    if (rmt_strip->symbol_cache) {
+        led_strip_symbol_cache_mark(&rmt_strip->cache, start, count);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_transmit(led_strip_rmt_obj *rmt_strip, const uint8_t *colors)
+{
     rmt_transmit_config_t tx_conf = {
         .loop_count = 0,
     };
+    if (rmt_strip->symbol_cache) {
+        // Only called once the previous transmission is done, the driver no longer reads the symbols
+        led_strip_symbol_cache_update(&rmt_strip->cache, colors);
+        return rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->cache.symbols,
+                            led_strip_symbol_cache_size(&rmt_strip->cache), &tx_conf);
+    }
+    return rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, colors,
+                        rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf);
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    return rmt_tx_wait_all_done(rmt_strip->rmt_chan, timeout_ms);
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    size_t len = rmt_strip->strip_len * rmt_strip->bytes_per_pixel;
 
+    // The driver reads the colors while they go out, the previous ones must be out before the buffers swap
+    ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    uint8_t *ready = rmt_strip->pixel_buf;
+    rmt_strip->pixel_buf = rmt_strip->tx_buf;
+    rmt_strip->tx_buf = ready;
+    ESP_RETURN_ON_ERROR(led_strip_rmt_transmit(rmt_strip, rmt_strip->tx_buf), TAG, "transmit pixels by RMT failed");
+    // Pixels not set before the next refresh keep their color
+    memcpy(rmt_strip->pixel_buf, rmt_strip->tx_buf, len);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+
+    if (rmt_strip->async_refresh) {
+        // The channel stays enabled
+        ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_async(strip), TAG, "refresh failed");
+        return led_strip_rmt_wait_refresh_done(strip, -1);
+    }
     ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
-    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
-                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
+    ESP_RETURN_ON_ERROR(led_strip_rmt_transmit(rmt_strip, rmt_strip->pixel_buf), TAG, "transmit pixels by RMT failed");
     ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
     return ESP_OK;
 }
 
+static bool led_strip_rmt_on_trans_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = user_ctx;
+    return rmt_strip->on_refresh_done(&rmt_strip->base, rmt_strip->user_ctx);
+}
+
 static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     // Write zero to turn off all leds
     memset(rmt_strip->pixel_buf, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    if (rmt_strip->symbol_cache) {
+        led_strip_symbol_cache_mark(&rmt_strip->cache, 0, rmt_strip->strip_len);
+    }
     return led_strip_rmt_refresh(strip);
 }
 
 static esp_err_t led_strip_rmt_del(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->async_refresh) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
     ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    led_strip_symbol_cache_free(&rmt_strip->cache);
     free(rmt_strip);
     return ESP_OK;
 }
@@ -108,8 +187,11 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     } else {
         assert(false);
     }
-    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + led_config->max_leds * bytes_per_pixel);
+    size_t buf_len = led_config->max_leds * bytes_per_pixel;
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + buf_len * (rmt_config->flags.async_refresh ? 2 : 1));
     ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    rmt_strip->pixel_buf = rmt_strip->bufs;
+    rmt_strip->tx_buf = rmt_config->flags.async_refresh ? rmt_strip->bufs + buf_len : rmt_strip->bufs;
     uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
 
     // for backward compatibility, if the user does not set the clk_src, use the default value
@@ -135,15 +217,39 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
 
     led_strip_encoder_config_t strip_encoder_conf = {
         .resolution = resolution,
-        .led_model = led_config->led_model
+        .led_model = led_config->led_model,
+        .prebuilt_symbols = rmt_config->flags.symbol_cache,
     };
     ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+    if (rmt_config->flags.symbol_cache) {
+        rmt_symbol_word_t bit0, bit1;
+        ESP_GOTO_ON_ERROR(rmt_led_strip_encoder_bit_symbols(&strip_encoder_conf, &bit0, &bit1), err, TAG, "invalid led model");
+        ESP_GOTO_ON_FALSE(led_strip_symbol_cache_init(&rmt_strip->cache, bit0.val, bit1.val, led_config->max_leds, bytes_per_pixel),
+                          ESP_ERR_NO_MEM, err, TAG, "no mem for symbol cache");
+        rmt_strip->symbol_cache = true;
+    }
 
+    if (rmt_config->on_refresh_done) {
+        rmt_tx_event_callbacks_t cbs = {
+            .on_trans_done = led_strip_rmt_on_trans_done,
+        };
+        rmt_strip->on_refresh_done = rmt_config->on_refresh_done;
+        rmt_strip->user_ctx = rmt_config->user_ctx;
+        ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &cbs, rmt_strip), err, TAG, "register RMT callback failed");
+    }
+    if (rmt_config->flags.async_refresh) {
+        // Enabled once for good, instead of around every refresh
+        ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+        rmt_strip->async_refresh = true;
+        rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+        rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
+    }
 
     rmt_strip->bytes_per_pixel = bytes_per_pixel;
     rmt_strip->strip_len = led_config->max_leds;
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
     rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
@@ -153,11 +259,15 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
 err:
     if (rmt_strip) {
         if (rmt_strip->rmt_chan) {
+            if (rmt_strip->async_refresh) {
+                rmt_disable(rmt_strip->rmt_chan);
+            }
             rmt_del_channel(rmt_strip->rmt_chan);
         }
         if (rmt_strip->strip_encoder) {
             rmt_del_encoder(rmt_strip->strip_encoder);
         }
+        led_strip_symbol_cache_free(&rmt_strip->cache);
         free(rmt_strip);
     }
     return ret;
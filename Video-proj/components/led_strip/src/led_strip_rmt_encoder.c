@@ -13,6 +13,7 @@ typedef struct {
     rmt_encoder_t base;
     rmt_encoder_t *bytes_encoder;
     rmt_encoder_t *copy_encoder;
+    bool prebuilt_symbols;
     int state;
     rmt_symbol_word_t reset_code;
 } rmt_led_strip_encoder_t;
@@ -27,7 +28,12 @@ static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t
     size_t encoded_symbols = 0;
     switch (led_encoder->state) {
     case 0: // send RGB data
-        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
+        if (led_encoder->prebuilt_symbols) {
+            // Symbols from the cache of the strip, the copy encoder starts over by itself once they are all out
+            encoded_symbols += copy_encoder->encode(copy_encoder, channel, primary_data, data_size, &session_state);
+        } else {
+            encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
+        }
         if (session_state & RMT_ENCODING_COMPLETE) {
             led_encoder->state = 1; // switch to next state when current encoding session finished
         }
@@ -71,6 +77,41 @@ static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
     return ESP_OK;
 }
 
+esp_err_t rmt_led_strip_encoder_bit_symbols(const led_strip_encoder_config_t *config, rmt_symbol_word_t *bit0, rmt_symbol_word_t *bit1)
+{
+    if (config->led_model == LED_MODEL_SK6812) {
+        *bit0 = (rmt_symbol_word_t) {
+            .level0 = 1,
+            .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+            .level1 = 0,
+            .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+        };
+        *bit1 = (rmt_symbol_word_t) {
+            .level0 = 1,
+            .duration0 = 0.6 * config->resolution / 1000000, // T1H=0.6us
+            .level1 = 0,
+            .duration1 = 0.6 * config->resolution / 1000000, // T1L=0.6us
+        };
+    } else if (config->led_model == LED_MODEL_WS2812) {
+        // different led strip might have its own timing requirements, following parameter is for WS2812
+        *bit0 = (rmt_symbol_word_t) {
+            .level0 = 1,
+            .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+            .level1 = 0,
+            .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+        };
+        *bit1 = (rmt_symbol_word_t) {
+            .level0 = 1,
+            .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
+            .level1 = 0,
+            .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
+        };
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
 esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
 {
     esp_err_t ret = ESP_OK;
@@ -82,43 +123,11 @@ esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rm
     led_encoder->base.encode = rmt_encode_led_strip;
     led_encoder->base.del = rmt_del_led_strip_encoder;
     led_encoder->base.reset = rmt_led_strip_encoder_reset;
-    rmt_bytes_encoder_config_t bytes_encoder_config;
-    if (config->led_model == LED_MODEL_SK6812) {
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-                .level1 = 0,
-                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 0.6 * config->resolution / 1000000, // T1H=0.6us
-                .level1 = 0,
-                .duration1 = 0.6 * config->resolution / 1000000, // T1L=0.6us
-            },
-            .flags.msb_first = 1 // SK6812 transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
-        };
-    } else if (config->led_model == LED_MODEL_WS2812) {
-        // different led strip might have its own timing requirements, following parameter is for WS2812
-        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
-            .bit0 = {
-                .level0 = 1,
-                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
-                .level1 = 0,
-                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
-            },
-            .bit1 = {
-                .level0 = 1,
-                .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
-                .level1 = 0,
-                .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
-            },
-            .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
-        };
-    } else {
-        assert(false);
-    }
+    rmt_bytes_encoder_config_t bytes_encoder_config = {
+        .flags.msb_first = 1 // transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
+    };
+    ESP_GOTO_ON_ERROR(rmt_led_strip_encoder_bit_symbols(config, &bytes_encoder_config.bit0, &bytes_encoder_config.bit1), err, TAG, "invalid led model");
+    led_encoder->prebuilt_symbols = config->prebuilt_symbols;
     ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
     rmt_copy_encoder_config_t copy_encoder_config = {};
     ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "driver/rmt_encoder.h"
 #include "led_strip_types.h"
@@ -19,8 +20,21 @@ extern "C" {
 typedef struct {
     uint32_t resolution;   /*!< Encoder resolution, in Hz */
     led_model_t led_model; /*!< LED model */
+    bool prebuilt_symbols; /*!< The payload is already RMT symbols (led_strip_symbol_cache.h), copied as they are */
 } led_strip_encoder_config_t;
 
+/**
+ * @brief RMT symbols of a 0 bit and a 1 bit for the LED model
+ *
+ * @param[in] config Encoder configuration
+ * @param[out] bit0 Symbol of a 0 bit
+ * @param[out] bit1 Symbol of a 1 bit
+ * @return
+ *      - ESP_ERR_INVALID_ARG for an invalid LED model
+ *      - ESP_OK otherwise
+ */
+esp_err_t rmt_led_strip_encoder_bit_symbols(const led_strip_encoder_config_t *config, rmt_symbol_word_t *bit0, rmt_symbol_word_t *bit1);
+
 /**
  * @brief Create RMT encoder for encoding LED strip pixels into RMT symbols
  *
@@ -12,13 +12,17 @@
 #include "soc/spi_periph.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_pixels.h"
+#include "led_strip_spi_encoder.h"
 #include "hal/spi_hal.h"
 
 #define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
 #define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
 
-#define SPI_BYTES_PER_COLOR_BYTE 3
+#define SPI_BYTES_PER_COLOR_BYTE LED_STRIP_SPI_BYTES_PER_COLOR_BYTE
 #define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
+// Pixels reordered at a time by set_pixels before encoding, on the stack
+#define SPI_SET_PIXELS_CHUNK 32
 
 static const char *TAG = "led_strip_spi";
 
@@ -28,23 +32,20 @@ typedef struct {
     spi_device_handle_t spi_device;
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
-    uint8_t pixel_buf[];
+    uint8_t *colors;      // Colors last encoded, only to skip unchanged pixels
+    uint8_t pixel_buf[];  // SPI encoding of the pixels
 } led_strip_spi_obj;
 
-// please make sure to zero-initialize the buf before calling this function
-static void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+// Encode count pixels in wire order, from the pixel at index
+static void led_strip_spi_store(led_strip_spi_obj *spi_strip, uint32_t index, const uint8_t *wire, uint32_t count)
 {
-    // Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
-    // So a color byte occupies 3 bytes of SPI.
-    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
-    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
-    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
-    *(buf + 1) |= BIT(0);
-    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
-    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
-    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
-    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
-    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+    uint32_t start = index * spi_strip->bytes_per_pixel;
+    if (spi_strip->colors) {
+        led_strip_spi_encode_changed(&spi_strip->pixel_buf[start * SPI_BYTES_PER_COLOR_BYTE], &spi_strip->colors[start], wire, count,
+                                     spi_strip->bytes_per_pixel);
+    } else {
+        led_strip_spi_encode(&spi_strip->pixel_buf[start * SPI_BYTES_PER_COLOR_BYTE], wire, count * spi_strip->bytes_per_pixel);
+    }
 }
 
 static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
@@ -52,14 +53,8 @@ static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uin
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     // LED_PIXEL_FORMAT_GRB takes 72bits(9bytes)
-    uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
-    memset(spi_strip->pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
-    __led_strip_spi_bit(green, &spi_strip->pixel_buf[start]);
-    __led_strip_spi_bit(red, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE]);
-    __led_strip_spi_bit(blue, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * 2]);
-    if (spi_strip->bytes_per_pixel > 3) {
-        __led_strip_spi_bit(0, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * 3]);
-    }
+    uint8_t wire[4] = {green & 0xFF, red & 0xFF, blue & 0xFF, 0};
+    led_strip_spi_store(spi_strip, index, wire, 1);
     return ESP_OK;
 }
 
@@ -69,14 +64,28 @@ static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     ESP_RETURN_ON_FALSE(spi_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
     // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
-    uint32_t start = index * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
     // SK6812 component order is GRBW
-    memset(spi_strip->pixel_buf + start, 0, spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
-    __led_strip_spi_bit(green, &spi_strip->pixel_buf[start]);
-    __led_strip_spi_bit(red, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE]);
-    __led_strip_spi_bit(blue, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * 2]);
-    __led_strip_spi_bit(white, &spi_strip->pixel_buf[start + SPI_BYTES_PER_COLOR_BYTE * 3]);
+    uint8_t wire[4] = {green & 0xFF, red & 0xFF, blue & 0xFF, white & 0xFF};
+    led_strip_spi_store(spi_strip, index, wire, 1);
+    return ESP_OK;
+}
 
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_strip_color_format_t format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "range out of maximum number of LEDs");
+    uint8_t src_bytes_per_pixel = format == LED_STRIP_COLOR_RGBW ? 4 : 3;
+    uint8_t wire[SPI_SET_PIXELS_CHUNK * 4];
+    while (count > 0) {
+        uint32_t chunk = count < SPI_SET_PIXELS_CHUNK ? count : SPI_SET_PIXELS_CHUNK;
+        // Wire order first, then every color byte becomes its 3 SPI bytes
+        ESP_RETURN_ON_FALSE(led_strip_pixels_convert(wire, spi_strip->bytes_per_pixel, colors, format, chunk),
+                            ESP_ERR_INVALID_ARG, TAG, "wrong color format for the LED pixel format");
+        led_strip_spi_store(spi_strip, start, wire, chunk);
+        colors += chunk * src_bytes_per_pixel;
+        start += chunk;
+        count -= chunk;
+    }
     return ESP_OK;
 }
 
@@ -98,11 +107,10 @@ static esp_err_t led_strip_spi_clear(led_strip_t *strip)
 {
     led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
     //Write zero to turn off all leds
-    memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE);
-    uint8_t *buf = spi_strip->pixel_buf;
-    for (int index = 0; index < spi_strip->strip_len * spi_strip->bytes_per_pixel; index++) {
-        __led_strip_spi_bit(0, buf);
-        buf += SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t wire[SPI_SET_PIXELS_CHUNK * 4] = {0};
+    for (uint32_t index = 0; index < spi_strip->strip_len; index += SPI_SET_PIXELS_CHUNK) {
+        uint32_t remaining = spi_strip->strip_len - index;
+        led_strip_spi_store(spi_strip, index, wire, remaining < SPI_SET_PIXELS_CHUNK ? remaining : SPI_SET_PIXELS_CHUNK);
     }
 
     return led_strip_spi_refresh(strip);
@@ -115,6 +123,7 @@ static esp_err_t led_strip_spi_del(led_strip_t *strip)
     ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi_strip->spi_device), TAG, "delete spi device failed");
     ESP_RETURN_ON_ERROR(spi_bus_free(spi_strip->spi_host), TAG, "free spi bus failed");
 
+    free(spi_strip->colors);
     free(spi_strip);
     return ESP_OK;
 }
@@ -141,6 +150,14 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     spi_strip = heap_caps_calloc(1, sizeof(led_strip_spi_obj) + led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE, mem_caps);
 
     ESP_GOTO_ON_FALSE(spi_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip");
+    // All LEDs off in SPI encoding, the pixels are encoded as they are set
+    for (uint32_t i = 0; i < led_config->max_leds * bytes_per_pixel; i++) {
+        memcpy(&spi_strip->pixel_buf[i * SPI_BYTES_PER_COLOR_BYTE], led_strip_spi_lut, SPI_BYTES_PER_COLOR_BYTE);
+    }
+    if (spi_config->flags.encode_changed_only) {
+        spi_strip->colors = calloc(led_config->max_leds, bytes_per_pixel);
+        ESP_GOTO_ON_FALSE(spi_strip->colors, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip colors");
+    }
 
     spi_strip->spi_host = spi_config->spi_bus;
     // for backward compatibility, if the user does not set the clk_src, use the default value
@@ -191,6 +208,7 @@ esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const l
     spi_strip->strip_len = led_config->max_leds;
     spi_strip->base.set_pixel = led_strip_spi_set_pixel;
     spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
     spi_strip->base.refresh = led_strip_spi_refresh;
     spi_strip->base.clear = led_strip_spi_clear;
     spi_strip->base.del = led_strip_spi_del;
@@ -205,6 +223,7 @@ err:
         if (spi_strip->spi_host) {
             spi_bus_free(spi_strip->spi_host);
         }
+        free(spi_strip->colors);
         free(spi_strip);
     }
     return ret;
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "led_strip_spi_encoder.h"
+
+// 24 SPI bits of a color byte, MSB first: 1, bit, 0 for each bit
+#define SPI_CODE(v) (0x924924 | \
+                     (((v) >> 0 & 1) << 1) | (((v) >> 1 & 1) << 4) | (((v) >> 2 & 1) << 7) | (((v) >> 3 & 1) << 10) | \
+                     (((v) >> 4 & 1) << 13) | (((v) >> 5 & 1) << 16) | (((v) >> 6 & 1) << 19) | (((v) >> 7 & 1) << 22))
+#define SPI_BYTES(v) (uint8_t)(SPI_CODE(v) >> 16), (uint8_t)(SPI_CODE(v) >> 8), (uint8_t)SPI_CODE(v)
+#define SPI_BYTES_4(v) SPI_BYTES(v), SPI_BYTES((v) + 1), SPI_BYTES((v) + 2), SPI_BYTES((v) + 3)
+#define SPI_BYTES_16(v) SPI_BYTES_4(v), SPI_BYTES_4((v) + 4), SPI_BYTES_4((v) + 8), SPI_BYTES_4((v) + 12)
+#define SPI_BYTES_64(v) SPI_BYTES_16(v), SPI_BYTES_16((v) + 16), SPI_BYTES_16((v) + 32), SPI_BYTES_16((v) + 48)
+
+const uint8_t led_strip_spi_lut[256 * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE] = {
+    SPI_BYTES_64(0), SPI_BYTES_64(64), SPI_BYTES_64(128), SPI_BYTES_64(192)
+};
+
+void led_strip_spi_encode(uint8_t *spi, const uint8_t *colors, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        const uint8_t *code = &led_strip_spi_lut[colors[i] * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+        spi[0] = code[0];
+        spi[1] = code[1];
+        spi[2] = code[2];
+        spi += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+    }
+}
+
+uint32_t led_strip_spi_encode_changed(uint8_t *spi, uint8_t *shadow, const uint8_t *colors, uint32_t count, uint8_t bytes_per_pixel)
+{
+    uint32_t encoded = 0;
+    size_t spi_per_pixel = bytes_per_pixel * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t diff = 0;
+        for (uint8_t j = 0; j < bytes_per_pixel; j++) {
+            diff |= shadow[j] ^ colors[j];
+        }
+        if (diff) {
+            memcpy(shadow, colors, bytes_per_pixel);
+            led_strip_spi_encode(spi, colors, bytes_per_pixel);
+            encoded++;
+        }
+        spi += spi_per_pixel;
+        shadow += bytes_per_pixel;
+        colors += bytes_per_pixel;
+    }
+    return encoded;
+}
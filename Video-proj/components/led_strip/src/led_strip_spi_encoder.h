@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief SPI bytes sent for one color byte: each color bit is 3 SPI bits, 100 for 0 and 110 for 1
+ */
+#define LED_STRIP_SPI_BYTES_PER_COLOR_BYTE 3
+
+/**
+ * @brief Encoding of every color byte, built at compile time: the 3 SPI bytes of value v start at 3 * v
+ */
+extern const uint8_t led_strip_spi_lut[256 * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+
+/**
+ * @brief Encode len color bytes, in wire order, into their SPI bytes
+ *
+ * @note No dependency on ESP-IDF, the encoder is also built and checked on the host
+ *
+ * @param spi: destination, 3 * len bytes
+ * @param colors: color bytes in wire order (GRB or GRBW)
+ * @param len: number of color bytes
+ */
+void led_strip_spi_encode(uint8_t *spi, const uint8_t *colors, size_t len);
+
+/**
+ * @brief Encode only the pixels whose color differs from the copy kept in shadow
+ *
+ * @param spi: SPI bytes of the first pixel
+ * @param shadow: colors last encoded for these pixels, updated
+ * @param colors: new colors in wire order
+ * @param count: number of pixels
+ * @param bytes_per_pixel: 3 or 4
+ *
+ * @return number of pixels encoded
+ */
+uint32_t led_strip_spi_encode_changed(uint8_t *spi, uint8_t *shadow, const uint8_t *colors, uint32_t count, uint8_t bytes_per_pixel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "led_strip_symbol_cache.h"
+
+bool led_strip_symbol_cache_init(led_strip_symbol_cache_t *cache, uint32_t bit0, uint32_t bit1, uint32_t strip_len, uint8_t bytes_per_pixel)
+{
+    memset(cache, 0, sizeof(*cache));
+    for (int v = 0; v < 16; v++) {
+        for (int i = 0; i < 4; i++) {
+            cache->nibble[v][i] = v & (0x8 >> i) ? bit1 : bit0;
+        }
+    }
+    uint32_t dirty_words = (strip_len + 31) / 32;
+    cache->symbols = malloc((size_t)strip_len * bytes_per_pixel * 8 * sizeof(uint32_t));
+    cache->dirty = calloc(dirty_words, sizeof(uint32_t));
+    if (!cache->symbols || !cache->dirty) {
+        led_strip_symbol_cache_free(cache);
+        return false;
+    }
+    cache->strip_len = strip_len;
+    cache->bytes_per_pixel = bytes_per_pixel;
+    led_strip_symbol_cache_mark(cache, 0, strip_len);
+    return true;
+}
+
+void led_strip_symbol_cache_free(led_strip_symbol_cache_t *cache)
+{
+    free(cache->symbols);
+    free(cache->dirty);
+    cache->symbols = NULL;
+    cache->dirty = NULL;
+}
+
+void led_strip_symbol_cache_mark(led_strip_symbol_cache_t *cache, uint32_t index, uint32_t count)
+{
+    uint32_t end = index + count;
+    // Partial words bit by bit, whole words at once
+    for (; index < end && index % 32; index++) {
+        cache->dirty[index / 32] |= 1u << (index % 32);
+    }
+    for (; index + 32 <= end; index += 32) {
+        cache->dirty[index / 32] = 0xFFFFFFFF;
+    }
+    for (; index < end; index++) {
+        cache->dirty[index / 32] |= 1u << (index % 32);
+    }
+}
+
+uint32_t led_strip_symbol_cache_update(led_strip_symbol_cache_t *cache, const uint8_t *colors)
+{
+    uint32_t rebuilt = 0;
+    uint32_t dirty_words = (cache->strip_len + 31) / 32;
+    uint8_t bytes_per_pixel = cache->bytes_per_pixel;
+    for (uint32_t w = 0; w < dirty_words; w++) {
+        uint32_t bits = cache->dirty[w];
+        cache->dirty[w] = 0;
+        while (bits) {
+            uint32_t pixel = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+            const uint8_t *color = colors + pixel * bytes_per_pixel;
+            uint32_t *symbols = cache->symbols + pixel * bytes_per_pixel * 8;
+            for (uint8_t i = 0; i < bytes_per_pixel; i++) {
+                memcpy(symbols, cache->nibble[color[i] >> 4], sizeof(cache->nibble[0]));
+                memcpy(symbols + 4, cache->nibble[color[i] & 0xF], sizeof(cache->nibble[0]));
+                symbols += 8;
+            }
+            rebuilt++;
+        }
+    }
+    return rebuilt;
+}
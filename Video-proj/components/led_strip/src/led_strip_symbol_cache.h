@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief RMT symbols of every pixel of a strip, rebuilt only for the pixels marked dirty
+ *
+ * @note Symbols are raw 32-bit RMT symbol words (`rmt_symbol_word_t.val`), 8 per color byte, MSB first.
+ *       No dependency on ESP-IDF, the cache is also built and checked on the host.
+ */
+typedef struct {
+    uint32_t nibble[16][4];   /*!< Symbols of each 4-bit value, MSB first */
+    uint32_t *symbols;        /*!< 8 symbols per color byte, in wire order */
+    uint32_t *dirty;          /*!< One bit per pixel */
+    uint32_t strip_len;       /*!< Number of pixels */
+    uint8_t bytes_per_pixel;  /*!< 3 or 4 */
+} led_strip_symbol_cache_t;
+
+/**
+ * @brief Allocate the cache, every pixel dirty
+ *
+ * @param cache: cache to initialize
+ * @param bit0: symbol word of a 0 bit
+ * @param bit1: symbol word of a 1 bit
+ * @param strip_len: number of pixels
+ * @param bytes_per_pixel: 3 or 4
+ *
+ * @return false if out of memory
+ */
+bool led_strip_symbol_cache_init(led_strip_symbol_cache_t *cache, uint32_t bit0, uint32_t bit1, uint32_t strip_len, uint8_t bytes_per_pixel);
+
+/**
+ * @brief Free the buffers of the cache
+ */
+void led_strip_symbol_cache_free(led_strip_symbol_cache_t *cache);
+
+/**
+ * @brief Mark count pixels from index as changed
+ */
+void led_strip_symbol_cache_mark(led_strip_symbol_cache_t *cache, uint32_t index, uint32_t count);
+
+/**
+ * @brief Rebuild the symbols of the dirty pixels from the colors of the whole strip, in wire order
+ *
+ * @return number of pixels rebuilt
+ */
+uint32_t led_strip_symbol_cache_update(led_strip_symbol_cache_t *cache, const uint8_t *colors);
+
+/**
+ * @brief Size of the symbols of the whole strip, in bytes
+ */
+static inline uint32_t led_strip_symbol_cache_size(const led_strip_symbol_cache_t *cache)
+{
+    return cache->strip_len * cache->bytes_per_pixel * 8 * sizeof(uint32_t);
+}
+
+#ifdef __cplusplus
+}
+#endif
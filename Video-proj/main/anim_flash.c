@@ -0,0 +1,38 @@
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "anim_flash.h"
+
+static const char* TAG = "ANIM_FLASH";
+
+bool anim_flash_open(anim_store_t* store) {
+    const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ANIM_PARTITION_SUBTYPE, ANIM_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "No animation partition");
+        return false;
+    }
+
+    // Mapped once and never unmapped: lines are decoded straight from flash through the cache
+    const void* data;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &data, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Could not map animation partition: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    if (!anim_store_open(store, data, partition->size)) {
+        ESP_LOGW(TAG, "Animation partition is empty or invalid");
+        esp_partition_munmap(handle);
+        return false;
+    }
+    if (store->width != PIXELS_PER_LINE || store->height != LINES_PER_FRAME) {
+        ESP_LOGE(TAG, "Animation is %ux%u, projector is %ux%u", store->width, store->height,
+                 PIXELS_PER_LINE, LINES_PER_FRAME);
+        esp_partition_munmap(handle);
+        return false;
+    }
+    ESP_LOGI(TAG, "Animation: %lu frames at %lu.%02lu fps, %u colors", (unsigned long)store->frame_count,
+             (unsigned long)(store->fps_x100 / 100), (unsigned long)(store->fps_x100 % 100), store->palette_size);
+    return true;
+}
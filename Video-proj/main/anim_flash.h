@@ -0,0 +1,11 @@
+#pragma once
+
+#include "anim_store.h"
+
+// Flash partition holding the animation image (see partitions.csv)
+#define ANIM_PARTITION_LABEL   "anim"
+#define ANIM_PARTITION_SUBTYPE 0x40
+
+// Memory-map the animation partition. Returns false if it is missing, empty
+// or does not match the projector geometry.
+bool anim_flash_open(anim_store_t* store);
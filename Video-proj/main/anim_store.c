@@ -0,0 +1,86 @@
+#include <string.h>
+#include "anim_store.h"
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool anim_store_open(anim_store_t* store, const uint8_t* data, size_t size) {
+    memset(store, 0, sizeof(*store));
+    if (size < ANIM_STORE_HEADER_SIZE || get_u32(data) != ANIM_STORE_MAGIC || get_u16(data + 4) != ANIM_STORE_VERSION) {
+        return false;
+    }
+    store->width = get_u16(data + 6);
+    store->height = get_u16(data + 8);
+    store->palette_size = get_u16(data + 10);
+    store->frame_count = get_u32(data + 12);
+    store->fps_x100 = get_u32(data + 16);
+    if (store->width == 0 || store->height == 0 || store->palette_size == 0 || store->palette_size > 256 ||
+        store->frame_count == 0) {
+        return false;
+    }
+
+    size_t table_offset = ANIM_STORE_HEADER_SIZE + (size_t)store->palette_size * 3;
+    size_t table_size = (size_t)store->frame_count * store->height * 4;
+    if (table_offset + table_size > size) {
+        return false;
+    }
+    store->data = data;
+    store->size = size;
+    store->palette = data + ANIM_STORE_HEADER_SIZE;
+    store->line_table = data + table_offset;
+    return true;
+}
+
+bool anim_store_decode_line(const anim_store_t* store, uint32_t frame, uint16_t line, uint8_t (*rgb)[BYTES_PER_PIXEL]) {
+    if (frame >= store->frame_count || line >= store->height) {
+        return false;
+    }
+    size_t pos = get_u32(store->line_table + ((size_t)frame * store->height + line) * 4);
+    const uint8_t* palette = store->palette;
+    uint16_t x = 0;
+
+    while (x < store->width) {
+        if (pos >= store->size) {
+            goto corrupt;
+        }
+        uint8_t control = store->data[pos++];
+        uint16_t run = (control & 0x7F) + 1;
+        if (x + run > store->width) {
+            goto corrupt;
+        }
+        if (control & 0x80) {
+            if (pos >= store->size || store->data[pos] >= store->palette_size) {
+                goto corrupt;
+            }
+            const uint8_t* color = &palette[store->data[pos++] * 3];
+            for (uint16_t i = 0; i < run; i++, x++) {
+                rgb[x][0] = color[0];
+                rgb[x][1] = color[1];
+                rgb[x][2] = color[2];
+            }
+        } else {
+            if (pos + run > store->size) {
+                goto corrupt;
+            }
+            for (uint16_t i = 0; i < run; i++, x++) {
+                uint8_t index = store->data[pos++];
+                if (index >= store->palette_size) {
+                    goto corrupt;
+                }
+                rgb[x][0] = palette[index * 3];
+                rgb[x][1] = palette[index * 3 + 1];
+                rgb[x][2] = palette[index * 3 + 2];
+            }
+        }
+    }
+    return true;
+
+corrupt:
+    memset(rgb, 0, (size_t)store->width * BYTES_PER_PIXEL);
+    return false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compressed animation image, written to the "anim" flash partition by tools/anim_pack.
+//
+// Layout (little endian):
+//   header        ANIM_STORE_HEADER_SIZE bytes, see below
+//   palette       palette_size * 3 bytes (R G B)
+//   line table    frame_count * height u32 offsets, from the start of the image
+//   line data     one RLE stream of palette indices per line
+//
+// RLE stream: a control byte c < 0x80 is followed by c + 1 literal indices,
+// c >= 0x80 is followed by one index repeated (c & 0x7F) + 1 times.
+// Identical lines share the same data (static parts of a sequence cost only
+// their table entry), so the decoder never needs the previous frame.
+
+#define ANIM_STORE_MAGIC       0x4E415056  // "VPAN"
+#define ANIM_STORE_VERSION     1
+#define ANIM_STORE_HEADER_SIZE 20
+#define ANIM_STORE_MAX_RUN     128
+
+// Header: magic(4) version(2) width(2) height(2) palette_size(2) frame_count(4) fps_x100(4)
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    uint16_t width;
+    uint16_t height;
+    uint16_t palette_size;
+    uint32_t frame_count;
+    uint32_t fps_x100;         // Playback rate in hundredths of frame per second
+    const uint8_t* palette;
+    const uint8_t* line_table;
+} anim_store_t;
+
+// Check the image header and table bounds, data must stay mapped while the store is used
+bool anim_store_open(anim_store_t* store, const uint8_t* data, size_t size);
+
+// Decode one line to RGB. Returns false if the stream is corrupt (the line is then black).
+bool anim_store_decode_line(const anim_store_t* store, uint32_t frame, uint16_t line, uint8_t (*rgb)[BYTES_PER_PIXEL]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,125 @@
+#include <string.h>
+#include "bus_pack.h"
+
+// Bus bit driving a GPIO, -1 if the GPIO is not on the bus
+static int bus_bit(int gpio) {
+    static const int bus[PIN_MAP_BUS_WIDTH] = PIN_MAP_BUS;
+    for (int bit = 0; bit < PIN_MAP_BUS_WIDTH; bit++) {
+        if (bus[bit] == gpio) {
+            return bit;
+        }
+    }
+    return -1;
+}
+
+bool bus_map_init(bus_map_t* map) {
+    static const int data_pins[8] = PIN_MAP_DATA;
+    static const int select_pins[BYTES_PER_PIXEL] = PIN_MAP_SELECT;
+    memset(map, 0, sizeof(*map));
+
+    int data_bit[8];
+    for (int i = 0; i < 8; i++) {
+        data_bit[i] = bus_bit(data_pins[i]);
+        if (data_bit[i] < 0) {
+            return false;
+        }
+    }
+    for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+        int bit = bus_bit(select_pins[color]);
+        if (bit < 0) {
+            return false;
+        }
+        map->select[color] = (uint16_t)(1u << bit);
+        map->select_mask |= map->select[color];
+    }
+
+    for (int value = 0; value < 256; value++) {
+        for (int i = 0; i < 8; i++) {
+            if (value & (1 << i)) {
+                map->data[value] |= (uint16_t)(1u << data_bit[i]);
+            }
+        }
+    }
+    // Reverse tables, one per byte of the word
+    for (int byte = 0; byte < 256; byte++) {
+        for (int i = 0; i < 8; i++) {
+            if (data_bit[i] < 8 && (byte & (1 << data_bit[i]))) {
+                map->value_lo[byte] |= (uint8_t)(1u << i);
+            }
+            if (data_bit[i] >= 8 && (byte & (1 << (data_bit[i] - 8)))) {
+                map->value_hi[byte] |= (uint8_t)(1u << i);
+            }
+        }
+    }
+    return true;
+}
+
+void bus_pack_phases(const bus_map_t* map, const uint8_t pixels[PIXELS_PER_LINE][BYTES_PER_PIXEL],
+                     uint16_t phases[PHASES_PER_LINE]) {
+    for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+        for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+            *phases++ = map->data[pixels[pixel][color]] | map->select[color];
+        }
+    }
+}
+
+void bus_pack_colors(const bus_map_t* map, const uint8_t (*rgb)[BYTES_PER_PIXEL], size_t count,
+                     uint16_t (*phases)[BYTES_PER_PIXEL]) {
+    for (size_t i = 0; i < count; i++) {
+        for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+            phases[i][color] = map->data[rgb[i][color]] | map->select[color];
+        }
+    }
+}
+
+void bus_expand_indices(const uint16_t palette[PALETTE_SIZE][BYTES_PER_PIXEL], const uint8_t indices[PIXELS_PER_LINE],
+                        uint16_t phases[PHASES_PER_LINE]) {
+    for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+        const uint16_t* color = palette[indices[pixel]];
+        *phases++ = color[0];
+        *phases++ = color[1];
+        *phases++ = color[2];
+    }
+}
+
+void bus_expand_line(const bus_map_t* map, const uint16_t phases[PHASES_PER_LINE], uint16_t* words) {
+    uint16_t data_mask = (uint16_t)~map->select_mask;
+    for (int i = 0; i < PHASES_PER_LINE; i++) {
+        uint16_t setup = phases[i] & data_mask;
+        for (int j = 0; j < BUS_SETUP_WORDS; j++) {
+            *words++ = setup;
+        }
+        for (int j = 0; j < BUS_HOLD_WORDS; j++) {
+            *words++ = phases[i];
+        }
+    }
+    *words = 0;
+}
+
+void bus_apply_lut(const bus_map_t* map, const uint8_t lut[256], uint16_t* phases, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        phases[i] = map->data[lut[bus_word_value(map, phases[i])]] | (phases[i] & map->select_mask);
+    }
+}
+
+size_t bus_unpack_line(const bus_map_t* map, const uint16_t* words, size_t count,
+                       uint8_t pixels[PIXELS_PER_LINE][BYTES_PER_PIXEL]) {
+    memset(pixels, 0, PIXELS_PER_LINE * BYTES_PER_PIXEL);
+    size_t pulses[BYTES_PER_PIXEL] = {0};
+    size_t total = 0;
+    uint16_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t rising = words[i] & ~previous;
+        for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+            if (rising & map->select[color]) {
+                if (pulses[color] < PIXELS_PER_LINE) {
+                    pixels[pulses[color]][color] = bus_word_value(map, words[i]);
+                }
+                pulses[color]++;
+                total++;
+            }
+        }
+        previous = words[i];
+    }
+    return total;
+}
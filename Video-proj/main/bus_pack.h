@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_format.h"
+#include "pin_map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lines as the 16-bit words of the parallel bus of pin_map.h (LCD_CAM I80 on the ESP32-S3).
+//
+// Bus bit i drives the i-th pin of PIN_MAP_BUS, so the data bits of a colour are
+// scattered over the word in the order of the board. The host packs each pixel
+// into three phase words, red, green then blue: the data bits of the colour
+// plus its select bit (bus_pack_phases). Frames travel and are stored that way,
+// or with FRAME_PALETTE as indices into a palette packed the same way
+// (bus_pack_colors), expanded one line at a time on the projector (bus_expand_indices).
+//
+// For the I80 backend each phase becomes, at one word per pixel clock period,
+// the sequence GPIO scan-out plays with its pins:
+//   BUS_SETUP_WORDS words with the data and all selects low, then
+//   BUS_HOLD_WORDS words with the data and its select high.
+// The next setup brings the select back low, and a last idle word leaves every
+// output low at the end of the line (bus_expand_line). Only copies and masks,
+// the bits were placed by the host.
+
+#define BUS_SETUP_WORDS     1
+#define BUS_HOLD_WORDS      2
+#define BUS_WORDS_PER_PHASE (BUS_SETUP_WORDS + BUS_HOLD_WORDS)
+#define BUS_LINE_WORDS      (PHASES_PER_LINE * BUS_WORDS_PER_PHASE + 1)
+#define BUS_LINE_BYTES      (BUS_LINE_WORDS * 2)
+
+// Pixel clock that sends a line in line_us microseconds
+#define BUS_PCLK_HZ(line_us) ((uint32_t)((uint64_t)BUS_LINE_WORDS * 1000000 / (line_us)))
+
+// Bus bits of every signal, from the pin map
+typedef struct {
+    uint16_t data[256];                 // Bus bits of each data value
+    uint16_t select[BYTES_PER_PIXEL];   // Bus bit of each colour select
+    uint16_t select_mask;
+    uint8_t value_lo[256];              // Data bits carried by the low byte of a word
+    uint8_t value_hi[256];              // ... and by its high byte
+} bus_map_t;
+
+// Returns false if a data or select pin of the pin map is not on the bus
+bool bus_map_init(bus_map_t* map);
+
+// Data value carried by a bus word
+static inline uint8_t bus_word_value(const bus_map_t* map, uint16_t word) {
+    return map->value_lo[word & 0xFF] | map->value_hi[word >> 8];
+}
+
+// Host: one line of RGB pixels into its phase words
+void bus_pack_phases(const bus_map_t* map, const uint8_t pixels[PIXELS_PER_LINE][BYTES_PER_PIXEL],
+                     uint16_t phases[PHASES_PER_LINE]);
+
+// Host: phase words of count colours (palette of FRAME_PALETTE)
+void bus_pack_colors(const bus_map_t* map, const uint8_t (*rgb)[BYTES_PER_PIXEL], size_t count,
+                     uint16_t (*phases)[BYTES_PER_PIXEL]);
+
+// Firmware, FRAME_PALETTE: the phase words of a line of palette indices, three copies per pixel
+void bus_expand_indices(const uint16_t palette[PALETTE_SIZE][BYTES_PER_PIXEL], const uint8_t indices[PIXELS_PER_LINE],
+                        uint16_t phases[PHASES_PER_LINE]);
+
+// Firmware: fill words[BUS_LINE_WORDS] for the I80 bus from the phase words of a line
+void bus_expand_line(const bus_map_t* map, const uint16_t phases[PHASES_PER_LINE], uint16_t* words);
+
+// Map the data of count phase words through lut (line gain), selects untouched
+void bus_apply_lut(const bus_map_t* map, const uint8_t lut[256], uint16_t* phases, size_t count);
+
+// What a device latching the data on the rising edge of each select would see:
+// rebuilds the pixels from bus words, returns the number of select pulses found.
+// A well formed line gives PHASES_PER_LINE.
+size_t bus_unpack_line(const bus_map_t* map, const uint16_t* words, size_t count,
+                       uint8_t pixels[PIXELS_PER_LINE][BYTES_PER_PIXEL]);
+
+#ifdef __cplusplus
+}
+#endif
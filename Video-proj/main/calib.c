@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <string.h>
+#include "calib.h"
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void calib_identity(calib_table_t* table, uint8_t facet_count) {
+    memset(table, 0, sizeof(*table));
+    table->facet_count = facet_count;
+    memset(table->line_gain, CALIB_GAIN_ONE, sizeof(table->line_gain));
+}
+
+void calib_serialize(const calib_table_t* table, uint8_t out[CALIB_BLOB_SIZE]) {
+    put_u16(out, CALIB_MAGIC);
+    out[2] = CALIB_VERSION;
+    out[3] = table->facet_count;
+    uint8_t* p = out + 4;
+    for (int f = 0; f < CALIB_MAX_FACETS; f++, p += 2) {
+        put_u16(p, table->facet_delay_us[f]);
+    }
+    for (int f = 0; f < CALIB_MAX_FACETS; f++, p += 2) {
+        put_u16(p, (uint16_t)table->facet_signature[f]);
+    }
+    memcpy(p, table->line_gain, LINES_PER_FRAME);
+}
+
+bool calib_parse(const uint8_t* data, size_t len, calib_table_t* table) {
+    if (len != CALIB_BLOB_SIZE || get_u16(data) != CALIB_MAGIC || data[2] != CALIB_VERSION) {
+        return false;
+    }
+    if (data[3] == 0 || data[3] > CALIB_MAX_FACETS) {
+        return false;
+    }
+    table->facet_count = data[3];
+    const uint8_t* p = data + 4;
+    for (int f = 0; f < CALIB_MAX_FACETS; f++, p += 2) {
+        table->facet_delay_us[f] = get_u16(p);
+    }
+    for (int f = 0; f < CALIB_MAX_FACETS; f++, p += 2) {
+        table->facet_signature[f] = (int16_t)get_u16(p);
+    }
+    memcpy(table->line_gain, p, LINES_PER_FRAME);
+    return true;
+}
+
+void calib_lock_init(calib_lock_t* lock, uint8_t facet_count) {
+    memset(lock, 0, sizeof(*lock));
+    lock->facet_count = facet_count;
+}
+
+// Deviation of each edge slot from the mean duration, in 1/16 us
+static bool slot_deviations(const calib_lock_t* lock, int32_t deviation[CALIB_MAX_FACETS]) {
+    int64_t sum = 0;
+    for (int s = 0; s < lock->facet_count; s++) {
+        if (lock->interval_x16[s] == 0) {
+            return false;  // Not a full mirror turn yet
+        }
+        sum += lock->interval_x16[s];
+    }
+    int32_t mean = (int32_t)(sum / lock->facet_count);
+    for (int s = 0; s < lock->facet_count; s++) {
+        deviation[s] = (int32_t)lock->interval_x16[s] - mean;
+    }
+    return true;
+}
+
+static uint32_t match_cost(const calib_lock_t* lock, const calib_table_t* table,
+                           const int32_t deviation[CALIB_MAX_FACETS], uint8_t offset) {
+    uint32_t cost = 0;
+    for (int s = 0; s < lock->facet_count; s++) {
+        cost += abs(deviation[s] - table->facet_signature[(s + offset) % lock->facet_count] * 16);
+    }
+    return cost;
+}
+
+bool calib_lock_update(calib_lock_t* lock, const calib_table_t* table) {
+    int32_t deviation[CALIB_MAX_FACETS];
+    if (lock->facet_count < 2 || table->facet_count != lock->facet_count || !slot_deviations(lock, deviation)) {
+        return false;
+    }
+    uint8_t best = lock->offset;
+    uint32_t current_cost = match_cost(lock, table, deviation, lock->offset);
+    uint32_t best_cost = current_cost;
+    for (uint8_t offset = 0; offset < lock->facet_count; offset++) {
+        uint32_t cost = match_cost(lock, table, deviation, offset);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = offset;
+        }
+    }
+    // Only move on a clear win, noise must not make the numbering hop
+    if (best == lock->offset || best_cost * 4 > current_cost * 3) {
+        return false;
+    }
+    lock->offset = best;
+    return true;
+}
+
+void calib_lock_signature(const calib_lock_t* lock, int16_t signature[CALIB_MAX_FACETS]) {
+    int32_t deviation[CALIB_MAX_FACETS];
+    memset(signature, 0, CALIB_MAX_FACETS * sizeof(int16_t));
+    if (!slot_deviations(lock, deviation)) {
+        return;
+    }
+    for (int s = 0; s < lock->facet_count; s++) {
+        signature[(s + lock->offset) % lock->facet_count] = (int16_t)(deviation[s] / 16);
+    }
+}
+
+void calib_gain_lut_init(calib_gain_lut_t* lut) {
+    lut->gain = CALIB_GAIN_ONE;
+    for (int v = 0; v < 256; v++) {
+        lut->lut[v] = (uint8_t)v;
+    }
+}
+
+const uint8_t* calib_gain_table(calib_gain_lut_t* lut, uint8_t gain) {
+    if (gain == CALIB_GAIN_ONE) {
+        return NULL;
+    }
+    if (gain != lut->gain) {
+        for (int v = 0; v < 256; v++) {
+            int scaled = (v * gain + CALIB_GAIN_ONE / 2) / CALIB_GAIN_ONE;
+            lut->lut[v] = (uint8_t)(scaled > 255 ? 255 : scaled);
+        }
+        lut->gain = gain;
+    }
+    return lut->lut;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-facet and per-line calibration, generated by tools/calib_gen and kept in NVS.
+//
+// Blob layout (little endian):
+//   magic(2) version(1) facet_count(1)
+//   facet_delay_us[CALIB_MAX_FACETS] u16   wait after the mirror edge before pixel 0
+//   facet_signature[CALIB_MAX_FACETS] i16  duration of each facet minus the mean, in us
+//   line_gain[LINES_PER_FRAME] u8          brightness gain, CALIB_GAIN_ONE is 1.0
+//
+// There is no index pulse on the mirror, so facets are numbered from whichever edge
+// comes first after boot. The signature (facets are never cut at exactly the same
+// angle) lets the firmware find which of its facets is facet 0 of the table.
+
+#define CALIB_MAGIC         0x4C43  // "CL"
+#define CALIB_VERSION       1
+#define CALIB_MAX_FACETS    16
+#define CALIB_GAIN_ONE      128
+#define CALIB_MAX_INTERVAL_US ((1u << 27) - 1)  // Longer: the mirror stopped, not a facet
+#define CALIB_BLOB_SIZE     (4 + CALIB_MAX_FACETS * 4 + LINES_PER_FRAME)
+#define CALIB_NVS_NAMESPACE "projector"
+#define CALIB_NVS_KEY       "calib"
+
+typedef struct {
+    uint8_t facet_count;
+    uint16_t facet_delay_us[CALIB_MAX_FACETS];
+    int16_t facet_signature[CALIB_MAX_FACETS];
+    uint8_t line_gain[LINES_PER_FRAME];
+} calib_table_t;
+
+// Facet identification from the mirror edge intervals
+typedef struct {
+    uint8_t facet_count;
+    volatile uint8_t offset;       // Added to the edge count to get the table facet
+    uint32_t edges;
+    int64_t last_edge_us;
+    uint32_t interval_x16[CALIB_MAX_FACETS];  // Smoothed duration per edge slot, 1/16 us
+} calib_lock_t;
+
+// Brightness lookup for the current gain, rebuilt only when the gain changes
+typedef struct {
+    uint8_t gain;
+    uint8_t lut[256];
+} calib_gain_lut_t;
+
+// No delay, unit gain
+void calib_identity(calib_table_t* table, uint8_t facet_count);
+
+void calib_serialize(const calib_table_t* table, uint8_t out[CALIB_BLOB_SIZE]);
+
+// Returns false if the blob is not a calibration table of this geometry
+bool calib_parse(const uint8_t* data, size_t len, calib_table_t* table);
+
+void calib_lock_init(calib_lock_t* lock, uint8_t facet_count);
+
+// Mirror ISR: record the edge, returns the table facet of the line it starts
+static inline uint8_t calib_lock_edge(calib_lock_t* lock, int64_t now_us) {
+    uint32_t slot = lock->edges % lock->facet_count;
+    if (lock->last_edge_us != 0) {
+        // The interval ending at this edge is the duration of the previous slot
+        uint32_t prev = (slot + lock->facet_count - 1) % lock->facet_count;
+        // A stop is left out of the facet durations: shifted it would wrap
+        int64_t elapsed = now_us - lock->last_edge_us;
+        if (elapsed <= CALIB_MAX_INTERVAL_US) {
+            uint32_t interval_x16 = (uint32_t)elapsed << 4;
+            if (lock->interval_x16[prev] == 0) {
+                lock->interval_x16[prev] = interval_x16;
+            } else {
+                lock->interval_x16[prev] += ((int32_t)interval_x16 - (int32_t)lock->interval_x16[prev]) / 16;
+            }
+        }
+    }
+    lock->last_edge_us = now_us;
+    lock->edges++;
+    return (uint8_t)((slot + lock->offset) % lock->facet_count);
+}
+
+// Task context, every few revolutions: align the edge slots on the table signature.
+// Returns true if the facet numbering changed.
+bool calib_lock_update(calib_lock_t* lock, const calib_table_t* table);
+
+// Duration of each table facet minus the mean, in us (what calib_gen stores as signature)
+void calib_lock_signature(const calib_lock_t* lock, int16_t signature[CALIB_MAX_FACETS]);
+
+void calib_gain_lut_init(calib_gain_lut_t* lut);
+
+// Lookup table scaling a value by gain, NULL at unit gain (nothing to do)
+const uint8_t* calib_gain_table(calib_gain_lut_t* lut, uint8_t gain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "calib_nvs.h"
+
+static const char* TAG = "CALIB";
+
+bool calib_nvs_load(calib_table_t* table, uint8_t facet_count) {
+    calib_identity(table, facet_count);
+
+    // Not erased on error: the table is the only thing kept in NVS and must survive
+    esp_err_t err = nvs_flash_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS unavailable: %s", esp_err_to_name(err));
+        return false;
+    }
+    nvs_handle_t handle;
+    err = nvs_open(CALIB_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No calibration, scanning uncorrected");
+        return false;
+    }
+    uint8_t blob[CALIB_BLOB_SIZE];
+    size_t size = sizeof(blob);
+    err = nvs_get_blob(handle, CALIB_NVS_KEY, blob, &size);
+    nvs_close(handle);
+
+    calib_table_t loaded;
+    if (err != ESP_OK || !calib_parse(blob, size, &loaded)) {
+        ESP_LOGW(TAG, "No valid calibration, scanning uncorrected");
+        return false;
+    }
+    if (loaded.facet_count != facet_count) {
+        ESP_LOGE(TAG, "Calibration is for %u facets, mirror has %u", loaded.facet_count, facet_count);
+        return false;
+    }
+    *table = loaded;
+    ESP_LOGI(TAG, "Calibration loaded, %u facets", facet_count);
+    return true;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "calib.h"
+
+// Load the calibration table from NVS. Falls back to the identity table (and
+// returns false) when there is none or it does not match the rig.
+bool calib_nvs_load(calib_table_t* table, uint8_t facet_count);
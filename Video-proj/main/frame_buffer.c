@@ -0,0 +1,66 @@
+#include <string.h>
+#include "frame_buffer.h"
+
+// State word bits
+#define FB_FRONT   (1u << 0)  // Index of the front frame
+#define FB_PENDING (1u << 1)  // Back frame complete, waiting for the swap
+#define FB_WRITING (1u << 2)  // Receiver is filling the back frame
+
+void frame_buffer_init(frame_buffer_t* fb) {
+    memset(fb->frames, 0, sizeof(fb->frames));
+    atomic_init(&fb->state, 0);
+    atomic_init(&fb->frames_shown, 0);
+    atomic_init(&fb->frames_late, 0);
+    atomic_init(&fb->frames_skipped, 0);
+    atomic_init(&fb->frames_aborted, 0);
+}
+
+frame_t* frame_buffer_begin_write(frame_buffer_t* fb) {
+    uint_fast32_t state = atomic_load(&fb->state);
+    do {
+        // The back frame still holds a published frame: overwriting it now would tear it
+        if (state & FB_PENDING) {
+            atomic_fetch_add(&fb->frames_skipped, 1);
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak(&fb->state, &state, state | FB_WRITING));
+    return &fb->frames[(state & FB_FRONT) ^ 1];
+}
+
+void frame_buffer_publish(frame_buffer_t* fb) {
+    uint_fast32_t state = atomic_load(&fb->state);
+    while (!atomic_compare_exchange_weak(&fb->state, &state, (state & ~FB_WRITING) | FB_PENDING)) {
+    }
+}
+
+void frame_buffer_abort_write(frame_buffer_t* fb) {
+    atomic_fetch_and(&fb->state, ~FB_WRITING);
+    atomic_fetch_add(&fb->frames_aborted, 1);
+}
+
+bool frame_buffer_swap(frame_buffer_t* fb) {
+    uint_fast32_t state = atomic_load(&fb->state);
+    do {
+        if (!(state & FB_PENDING)) {
+            // Only a frame that was on its way but did not make it counts as late,
+            // a still image simply stays on the front
+            if (state & FB_WRITING) {
+                atomic_fetch_add(&fb->frames_late, 1);
+            }
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak(&fb->state, &state, (state ^ FB_FRONT) & ~FB_PENDING));
+    atomic_fetch_add(&fb->frames_shown, 1);
+    return true;
+}
+
+const frame_t* frame_buffer_front(const frame_buffer_t* fb) {
+    return &fb->frames[atomic_load(&fb->state) & FB_FRONT];
+}
+
+void frame_buffer_get_stats(const frame_buffer_t* fb, frame_buffer_stats_t* stats) {
+    stats->shown = atomic_load(&fb->frames_shown);
+    stats->late = atomic_load(&fb->frames_late);
+    stats->skipped = atomic_load(&fb->frames_skipped);
+    stats->aborted = atomic_load(&fb->frames_aborted);
+}
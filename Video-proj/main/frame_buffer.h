@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+// Host tools written in C++ share this header
+#include <atomic>
+typedef std::atomic<uint_fast32_t> atomic_uint_fast32_t;
+extern "C" {
+#else
+#include <stdatomic.h>
+#endif
+#include "frame_format.h"
+
+// Front/back frame pair.
+// The display side reads the front frame, the receiver fills the back frame, and
+// the two are exchanged at the motor revolution boundary. The whole state
+// (front index, pending and writing flags) lives in one atomic word so that
+// the receiver and the scan-out never need a lock.
+typedef struct {
+    frame_t frames[2];
+    atomic_uint_fast32_t state;
+    atomic_uint_fast32_t frames_shown;   // Swaps that brought a new frame to the front
+    atomic_uint_fast32_t frames_late;    // Revolutions that had to repeat the previous frame
+    atomic_uint_fast32_t frames_skipped; // Incoming frames dropped because the back frame was busy
+    atomic_uint_fast32_t frames_aborted; // Back frames abandoned before being published
+} frame_buffer_t;
+
+typedef struct {
+    uint32_t shown;
+    uint32_t late;
+    uint32_t skipped;
+    uint32_t aborted;
+} frame_buffer_stats_t;
+
+void frame_buffer_init(frame_buffer_t* fb);
+
+// Receiver side: get the back frame to fill, or NULL if the previously
+// published frame has not reached the front yet (the frame is counted as skipped).
+frame_t* frame_buffer_begin_write(frame_buffer_t* fb);
+
+// Receiver side: mark the back frame complete, it becomes the front at the next swap.
+void frame_buffer_publish(frame_buffer_t* fb);
+
+// Receiver side: give up on a partially written back frame (link error, timeout).
+void frame_buffer_abort_write(frame_buffer_t* fb);
+
+// Display side: call between two revolutions of lines. Returns true if a new frame
+// was brought to the front, false if the current one is shown again (counted as late).
+bool frame_buffer_swap(frame_buffer_t* fb);
+
+// Display side: frame currently displayed. Only valid until the next swap.
+const frame_t* frame_buffer_front(const frame_buffer_t* fb);
+
+void frame_buffer_get_stats(const frame_buffer_t* fb, frame_buffer_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Projector geometry (one line per mirror facet, one frame per motor revolution)
+#define PIXELS_PER_LINE 100
+#define LINES_PER_FRAME 100
+#define BYTES_PER_PIXEL 3
+
+// Lines go out to the pins as one bus word per colour of each pixel, packed by
+// the host for the pin map (bus_pack.h)
+#define PHASES_PER_LINE (PIXELS_PER_LINE * BYTES_PER_PIXEL)
+
+// 1: frames travel and are stored as one palette index per pixel, with the bus
+// words of the palette colours, and each line is expanded just before it goes
+// out. About 5x less link traffic and RAM per frame than the bus words, for
+// at most PALETTE_SIZE colours per frame. Shared by the host and the firmware
+// like the pin map: rebuild both sides after changing it.
+#ifndef FRAME_PALETTE
+#define FRAME_PALETTE 0
+#endif
+#define PALETTE_SIZE 256
+
+// Word aligned so that every line can be a DMA destination
+#if FRAME_PALETTE
+typedef struct {
+    uint16_t palette[PALETTE_SIZE][BYTES_PER_PIXEL];  // Bus words of each colour
+    uint8_t indices[LINES_PER_FRAME][PIXELS_PER_LINE];
+} __attribute__((aligned(4))) frame_t;
+#else
+typedef struct {
+    uint16_t phases[LINES_PER_FRAME][PHASES_PER_LINE];
+} __attribute__((aligned(4))) frame_t;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
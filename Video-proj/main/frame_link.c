@@ -0,0 +1,99 @@
+#include "driver/spi_slave.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "frame_link.h"
+
+static const char* TAG = "FRAME_LINK";
+
+#define LINK_SPI_HOST        SPI2_HOST
+#define LINK_TASK_STACK      4096
+#define LINK_TASK_PRIORITY   5
+#define LINK_TASK_CORE       0   // Ingestion core, the scan-out owns core 1
+
+static frame_rx_t frame_rx;
+
+// Headers are the only bytes the CPU reads, payloads land directly in the frame
+DMA_ATTR static uint8_t header_buf[FRAME_PROTO_HEADER_SIZE];
+
+static void IRAM_ATTR link_post_setup(spi_slave_transaction_t* trans) {
+    gpio_set_level(LINK_PIN_HANDSHAKE, 1);
+}
+
+static void IRAM_ATTR link_post_trans(spi_slave_transaction_t* trans) {
+    gpio_set_level(LINK_PIN_HANDSHAKE, 0);
+}
+
+static esp_err_t receive(void* dst, size_t len, size_t* received) {
+    spi_slave_transaction_t trans = {
+        .length = len * 8,
+        .rx_buffer = dst,
+    };
+    esp_err_t err = spi_slave_transmit(LINK_SPI_HOST, &trans, portMAX_DELAY);
+    *received = trans.trans_len / 8;
+    return err;
+}
+
+static void frame_link_task(void* arg) {
+    while (1) {
+        size_t received;
+        if (receive(header_buf, FRAME_PROTO_HEADER_SIZE, &received) != ESP_OK) {
+            continue;
+        }
+        frame_proto_header_t header;
+        if (received != FRAME_PROTO_HEADER_SIZE || !frame_proto_decode_header(header_buf, &header)) {
+            frame_rx.bad_headers++;
+            continue;
+        }
+
+        uint8_t* dst;
+        size_t len;
+        frame_rx_header(&frame_rx, &header, &dst, &len);
+        if (len == 0) {
+            continue;
+        }
+        // DMA straight to the line position in the back frame
+        if (receive(dst, len, &received) != ESP_OK || received != len) {
+            frame_rx.payload_dst = NULL;
+            continue;
+        }
+        frame_rx_payload_done(&frame_rx);
+    }
+}
+
+void frame_link_start(frame_buffer_t* fb) {
+    frame_rx_init(&frame_rx, fb);
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << LINK_PIN_HANDSHAKE,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    gpio_config(&io_conf);
+    gpio_set_level(LINK_PIN_HANDSHAKE, 0);
+
+    spi_bus_config_t bus_conf = {
+        .mosi_io_num = LINK_PIN_MOSI,
+        .miso_io_num = LINK_PIN_MISO,
+        .sclk_io_num = LINK_PIN_SCLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = FRAME_PROTO_MAX_PAYLOAD,
+    };
+    spi_slave_interface_config_t slave_conf = {
+        .spics_io_num = LINK_PIN_CS,
+        .mode = 0,
+        .queue_size = 1,
+        .post_setup_cb = link_post_setup,
+        .post_trans_cb = link_post_trans,
+    };
+    ESP_ERROR_CHECK(spi_slave_initialize(LINK_SPI_HOST, &bus_conf, &slave_conf, SPI_DMA_CH_AUTO));
+
+    xTaskCreatePinnedToCore(frame_link_task, "frame_link", LINK_TASK_STACK, NULL, LINK_TASK_PRIORITY, NULL, LINK_TASK_CORE);
+    ESP_LOGI(TAG, "SPI slave link ready, handshake on GPIO%d", LINK_PIN_HANDSHAKE);
+}
+
+const frame_rx_t* frame_link_get_rx(void) {
+    return &frame_rx;
+}
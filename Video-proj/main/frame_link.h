@@ -0,0 +1,17 @@
+#pragma once
+
+#include "frame_buffer.h"
+#include "frame_rx.h"
+
+// SPI slave link to the host (Raspberry Pi as SPI master)
+#define LINK_PIN_MOSI       11  // GPIO11 - FSPID
+#define LINK_PIN_SCLK       12  // GPIO12 - FSPICLK
+#define LINK_PIN_MISO       13  // GPIO13 - FSPIQ
+#define LINK_PIN_CS         10  // GPIO10 - FSPICS0
+#define LINK_PIN_HANDSHAKE   6  // GPIO6  - High while a transaction is queued, the host waits for it
+
+// Start receiving frames into the back frame of fb
+void frame_link_start(frame_buffer_t* fb);
+
+// Reassembler counters (frames completed, CRC errors...)
+const frame_rx_t* frame_link_get_rx(void);
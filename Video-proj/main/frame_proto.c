@@ -0,0 +1,66 @@
+#include <string.h>
+#include "frame_proto.h"
+
+// CRC-32 (IEEE 802.3, same as zlib and esp_rom_crc32_le), nibble table
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t frame_proto_crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+// CRC-16/CCITT-FALSE, only used on the 14 first header bytes
+uint16_t frame_proto_crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void frame_proto_encode_header(const frame_proto_header_t* header, uint8_t out[FRAME_PROTO_HEADER_SIZE]) {
+    put_u16(out + 0, FRAME_PROTO_MAGIC);
+    out[2] = FRAME_PROTO_VERSION;
+    out[3] = header->type;
+    put_u16(out + 4, header->frame_seq);
+    put_u16(out + 6, header->line);
+    put_u16(out + 8, header->payload_len);
+    put_u16(out + 10, header->payload_crc & 0xFFFF);
+    put_u16(out + 12, header->payload_crc >> 16);
+    put_u16(out + 14, frame_proto_crc16(out, FRAME_PROTO_HEADER_SIZE - 2));
+}
+
+bool frame_proto_decode_header(const uint8_t in[FRAME_PROTO_HEADER_SIZE], frame_proto_header_t* header) {
+    if (get_u16(in) != FRAME_PROTO_MAGIC || in[2] != FRAME_PROTO_VERSION) {
+        return false;
+    }
+    if (get_u16(in + 14) != frame_proto_crc16(in, FRAME_PROTO_HEADER_SIZE - 2)) {
+        return false;
+    }
+    header->type = in[3];
+    header->frame_seq = get_u16(in + 4);
+    header->line = get_u16(in + 6);
+    header->payload_len = get_u16(in + 8);
+    header->payload_crc = get_u16(in + 10) | ((uint32_t)get_u16(in + 12) << 16);
+    return true;
+}
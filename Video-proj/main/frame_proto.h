@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame_format.h"
+
+// Framed link protocol between the host and the projector.
+//
+// Every packet starts with a fixed 16 byte header (little endian):
+//   magic(2) version(1) type(1) frame_seq(2) line(2) payload_len(2) payload_crc(4) header_crc(2)
+// A LINE packet is followed by payload_len bytes of line data that belong at
+// `line` in the frame, so a DMA transport can receive the payload straight into
+// its final position in the back frame: the bus words of the line, little endian
+// (frame_format.h). An END packet closes the frame.
+//
+// With FRAME_PALETTE a LINE payload is the palette index of each pixel. The
+// PALETTE packet carries the bus words of the palette colours, little endian,
+// with a palette id in `line`. The host sends it before the first frame that
+// uses it, and again every few frames in case it was lost. The END packet gives
+// in `line` the id of the palette of its frame: a frame is only published if
+// that palette was received.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_PROTO_MAGIC       0x5650  // "VP"
+#define FRAME_PROTO_HEADER_SIZE 16
+#if FRAME_PALETTE
+#define FRAME_PROTO_VERSION      3  // 3: lines are palette indices
+#define FRAME_PROTO_LINE_SIZE    PIXELS_PER_LINE
+#define FRAME_PROTO_PALETTE_SIZE (PALETTE_SIZE * BYTES_PER_PIXEL * 2)
+#define FRAME_PROTO_MAX_PAYLOAD  FRAME_PROTO_PALETTE_SIZE
+#else
+#define FRAME_PROTO_VERSION      2  // 2: lines are bus words
+#define FRAME_PROTO_LINE_SIZE    (PHASES_PER_LINE * 2)
+#define FRAME_PROTO_MAX_PAYLOAD  FRAME_PROTO_LINE_SIZE
+#endif
+
+typedef enum {
+    FRAME_PROTO_LINE    = 1,  // One line of pixels
+    FRAME_PROTO_END     = 2,  // Frame complete, no payload
+    FRAME_PROTO_PALETTE = 3,  // Palette of the next frames, FRAME_PALETTE only
+} frame_proto_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t frame_seq;
+    uint16_t line;
+    uint16_t payload_len;
+    uint32_t payload_crc;
+} frame_proto_header_t;
+
+uint16_t frame_proto_crc16(const uint8_t* data, size_t len);
+uint32_t frame_proto_crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+// Serialize a header, filling in magic, version and header CRC
+void frame_proto_encode_header(const frame_proto_header_t* header, uint8_t out[FRAME_PROTO_HEADER_SIZE]);
+
+// Returns false if the magic, version or header CRC do not match
+bool frame_proto_decode_header(const uint8_t in[FRAME_PROTO_HEADER_SIZE], frame_proto_header_t* header);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#include <string.h>
+#include "frame_rx.h"
+
+#define MAGIC_LO (FRAME_PROTO_MAGIC & 0xFF)
+#define MAGIC_HI (FRAME_PROTO_MAGIC >> 8)
+
+void frame_rx_init(frame_rx_t* rx, frame_buffer_t* fb) {
+    memset(rx, 0, sizeof(*rx));
+    rx->fb = fb;
+}
+
+static bool all_lines_received(const frame_rx_t* rx) {
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        if (!(rx->lines_received[line / 32] & (1u << (line % 32)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void end_frame(frame_rx_t* rx, bool complete) {
+    if (rx->back) {
+        if (complete) {
+#if FRAME_PALETTE
+            memcpy(rx->back->palette, rx->palette, sizeof(rx->back->palette));
+#endif
+            frame_buffer_publish(rx->fb);
+            rx->frames_completed++;
+        } else {
+            frame_buffer_abort_write(rx->fb);
+            rx->frames_incomplete++;
+        }
+    }
+    rx->back = NULL;
+    rx->in_frame = false;
+}
+
+void frame_rx_header(frame_rx_t* rx, const frame_proto_header_t* header, uint8_t** dst, size_t* len) {
+    *dst = NULL;
+    *len = 0;
+
+    switch (header->type) {
+        case FRAME_PROTO_LINE:
+            if (header->payload_len != FRAME_PROTO_LINE_SIZE) {
+                rx->bad_headers++;
+                return;
+            }
+            if (!rx->in_frame || header->frame_seq != rx->frame_seq) {
+                // First line of a new frame, the previous one never got its END
+                if (rx->in_frame) {
+                    end_frame(rx, false);
+                }
+                rx->frame_seq = header->frame_seq;
+                rx->in_frame = true;
+                memset(rx->lines_received, 0, sizeof(rx->lines_received));
+                rx->back = frame_buffer_begin_write(rx->fb);
+            }
+            if (header->line >= LINES_PER_FRAME) {
+                rx->bad_headers++;
+                *dst = rx->discard;
+            } else {
+#if FRAME_PALETTE
+                *dst = rx->back ? rx->back->indices[header->line] : rx->discard;
+#else
+                *dst = rx->back ? (uint8_t*)rx->back->phases[header->line] : rx->discard;
+#endif
+            }
+            *len = header->payload_len;
+            rx->pending = *header;
+            rx->payload_dst = *dst;
+            break;
+
+        case FRAME_PROTO_END:
+            if (rx->in_frame && header->frame_seq == rx->frame_seq) {
+#if FRAME_PALETTE
+                // Without its palette the indices are meaningless, the previous frame stays
+                end_frame(rx, all_lines_received(rx) && rx->palette_valid && rx->palette_id == header->line);
+#else
+                end_frame(rx, all_lines_received(rx));
+#endif
+            }
+            break;
+
+#if FRAME_PALETTE
+        case FRAME_PROTO_PALETTE:
+            if (header->payload_len != FRAME_PROTO_PALETTE_SIZE) {
+                rx->bad_headers++;
+                return;
+            }
+            *dst = (uint8_t*)rx->palette_in;
+            *len = header->payload_len;
+            rx->pending = *header;
+            rx->payload_dst = *dst;
+            break;
+#endif
+
+        default:
+            rx->bad_headers++;
+            break;
+    }
+}
+
+void frame_rx_payload_done(frame_rx_t* rx) {
+#if FRAME_PALETTE
+    if (rx->payload_dst == (uint8_t*)rx->palette_in) {
+        // Kept aside until intact, the frame being received may use the current one
+        if (frame_proto_crc32(0, rx->payload_dst, rx->pending.payload_len) == rx->pending.payload_crc) {
+            memcpy(rx->palette, rx->palette_in, sizeof(rx->palette));
+            rx->palette_id = rx->pending.line;
+            rx->palette_valid = true;
+        } else {
+            rx->crc_errors++;
+        }
+        rx->payload_dst = NULL;
+        return;
+    }
+#endif
+    if (rx->payload_dst && rx->payload_dst != rx->discard) {
+        uint16_t line = rx->pending.line;
+        if (frame_proto_crc32(0, rx->payload_dst, rx->pending.payload_len) == rx->pending.payload_crc) {
+            rx->lines_received[line / 32] |= 1u << (line % 32);
+        } else {
+            // The line stays missing, a retransmission before END can still fix it
+            rx->lines_received[line / 32] &= ~(1u << (line % 32));
+            rx->crc_errors++;
+        }
+    }
+    rx->payload_dst = NULL;
+}
+
+// Drop bytes up to the next possible magic so the parser resynchronises
+static void resync_header(frame_rx_t* rx) {
+    size_t start = 1;
+    while (start < rx->header_fill &&
+           (rx->header_buf[start] != MAGIC_LO ||
+            (start + 1 < rx->header_fill && rx->header_buf[start + 1] != MAGIC_HI))) {
+        start++;
+    }
+    rx->header_fill -= start;
+    memmove(rx->header_buf, rx->header_buf + start, rx->header_fill);
+}
+
+void frame_rx_feed(frame_rx_t* rx, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (rx->payload_dst) {
+            size_t n = rx->pending.payload_len - rx->payload_fill;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(rx->payload_dst + rx->payload_fill, data, n);
+            rx->payload_fill += n;
+            data += n;
+            len -= n;
+            if (rx->payload_fill == rx->pending.payload_len) {
+                frame_rx_payload_done(rx);
+            }
+            continue;
+        }
+
+        rx->header_buf[rx->header_fill++] = *data++;
+        len--;
+        if ((rx->header_fill == 1 && rx->header_buf[0] != MAGIC_LO) ||
+            (rx->header_fill == 2 && rx->header_buf[1] != MAGIC_HI)) {
+            resync_header(rx);
+            continue;
+        }
+        if (rx->header_fill < FRAME_PROTO_HEADER_SIZE) {
+            continue;
+        }
+
+        frame_proto_header_t header;
+        if (!frame_proto_decode_header(rx->header_buf, &header)) {
+            rx->bad_headers++;
+            resync_header(rx);
+            continue;
+        }
+        rx->header_fill = 0;
+
+        uint8_t* dst;
+        size_t payload_len;
+        frame_rx_header(rx, &header, &dst, &payload_len);
+        rx->payload_fill = 0;
+        if (payload_len == 0) {
+            rx->payload_dst = NULL;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_buffer.h"
+#include "frame_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frame reassembler: places received lines in the back frame and publishes it
+// once every line of the frame arrived with a valid CRC (and, with FRAME_PALETTE,
+// its palette).
+typedef struct {
+    frame_buffer_t* fb;
+    frame_t* back;                       // Back frame being filled, NULL if the frame is dropped
+    uint16_t frame_seq;
+    bool in_frame;
+    uint32_t lines_received[(LINES_PER_FRAME + 31) / 32];
+    frame_proto_header_t pending;        // Header of the payload being received
+    uint8_t* payload_dst;
+    uint8_t discard[FRAME_PROTO_LINE_SIZE] __attribute__((aligned(4))); // Payload sink for dropped frames
+#if FRAME_PALETTE
+    uint16_t palette_in[PALETTE_SIZE][BYTES_PER_PIXEL];  // PALETTE payload being received
+    uint16_t palette[PALETTE_SIZE][BYTES_PER_PIXEL];     // Last palette received intact, copied into each frame
+    uint16_t palette_id;
+    bool palette_valid;
+#endif
+
+    // Byte stream parser state (frame_rx_feed)
+    uint8_t header_buf[FRAME_PROTO_HEADER_SIZE];
+    size_t header_fill;
+    size_t payload_fill;
+
+    uint32_t frames_completed;
+    uint32_t frames_incomplete;
+    uint32_t bad_headers;
+    uint32_t crc_errors;
+} frame_rx_t;
+
+void frame_rx_init(frame_rx_t* rx, frame_buffer_t* fb);
+
+// Handle a decoded header. Returns where its payload must be received and how
+// many bytes it has (0 if none). Only the header is touched by the CPU, the
+// payload can be received directly at *dst by DMA.
+void frame_rx_header(frame_rx_t* rx, const frame_proto_header_t* header, uint8_t** dst, size_t* len);
+
+// Check the payload received at the location given by frame_rx_header
+void frame_rx_payload_done(frame_rx_t* rx);
+
+// Byte stream path (UART, pty): parses headers, resynchronises on the magic
+// after garbage and copies payloads to their destination.
+void frame_rx_feed(frame_rx_t* rx, const uint8_t* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+#include <stddef.h>
+#include "line_queue.h"
+
+#define LINE_QUEUE_MASK (LINE_QUEUE_DEPTH - 1)
+
+_Static_assert((LINE_QUEUE_DEPTH & LINE_QUEUE_MASK) == 0, "LINE_QUEUE_DEPTH must be a power of two");
+
+void line_queue_init(line_queue_t* q) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+line_slot_t* line_queue_reserve(line_queue_t* q) {
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head - tail >= LINE_QUEUE_DEPTH) {
+        return NULL;
+    }
+    return &q->slots[head & LINE_QUEUE_MASK];
+}
+
+void line_queue_commit(line_queue_t* q) {
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    // Release: the slot content is visible before the new head
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+
+const line_slot_t* line_queue_peek(line_queue_t* q) {
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+    return &q->slots[tail & LINE_QUEUE_MASK];
+}
+
+void line_queue_release(line_queue_t* q) {
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
+
+uint32_t line_queue_count(line_queue_t* q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire) - atomic_load_explicit(&q->tail, memory_order_acquire);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include "frame_format.h"
+
+#ifdef __cplusplus
+#include <atomic>
+typedef std::atomic<uint_fast32_t> atomic_uint_fast32_t;
+extern "C" {
+#else
+#include <stdatomic.h>
+#endif
+
+// Lines prepared ahead of the scan-out, must be a power of two
+#define LINE_QUEUE_DEPTH 8
+
+typedef struct {
+    uint16_t line;      // Line index in the frame
+    uint16_t frame;     // Frame counter of the producer, for resync at the revolution boundary
+    uint16_t phases[PHASES_PER_LINE];  // Bus words, see frame_format.h
+} line_slot_t;
+
+// Single producer / single consumer line queue.
+// The producer (ingestion core) fills slots in place and commits them, the
+// consumer (scan-out core) reads them in place and releases them: no copy,
+// no lock, only one atomic store per side. Keep it in internal RAM.
+typedef struct {
+    line_slot_t slots[LINE_QUEUE_DEPTH];
+    atomic_uint_fast32_t head;  // Written by the producer only
+    atomic_uint_fast32_t tail;  // Written by the consumer only
+} line_queue_t;
+
+void line_queue_init(line_queue_t* q);
+
+// Producer: next free slot, or NULL if the queue is full
+line_slot_t* line_queue_reserve(line_queue_t* q);
+void line_queue_commit(line_queue_t* q);
+
+// Consumer: oldest committed slot, or NULL if the queue is empty
+const line_slot_t* line_queue_peek(line_queue_t* q);
+void line_queue_release(line_queue_t* q);
+
+uint32_t line_queue_count(line_queue_t* q);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,8 +2,22 @@
 #include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_attr.h"  // Add this include for IRAM_ATTR
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "frame_buffer.h"
+#include "frame_link.h"
+#include "line_queue.h"
+#include "anim_flash.h"
+#include "telemetry.h"
+#include "calib_nvs.h"
+#include "scan_out.h"
+#include "bus_pack.h"
+#include "pin_map.h"
 
 static const char* TAG = "VIDEO_PROJ";
 
@@ -15,113 +29,298 @@ static const char* TAG = "VIDEO_PROJ";
 
 // Function declarations
 void init_machine_etats(void);
+frame_buffer_t* get_frame_buffer(void);
 void process_state(void);
 void motor_rotation_isr(void* arg);  // Remove static and IRAM_ATTR from declaration
 void mirror_change_isr(void* arg);   // Remove static and IRAM_ATTR from declaration
 
-// Input pins
-#define MOTOR_PIN           4   // GPIO4  - Motor rotation detection
-#define MIRROR_PIN          5   // GPIO5  - Mirror position detection
+// Create array of data pins for easier iteration
+static const uint8_t DATA_PINS[8] = PIN_MAP_DATA;
+
+// Scan-out backend: 1 streams the lines with the LCD_CAM I80 bus (DMA), 0 bit-bangs the GPIOs
+#define SCAN_OUT_I80       1
+#define I80_LINE_US        900  // Line length on the bus, within the 1ms mirror period
+
+// Dual-core split: link reception and line preparation never preempt the scan-out
+#define INGEST_CORE             0
+#define SCANOUT_CORE            1
+#define SCANOUT_TASK_PRIORITY   (configMAX_PRIORITIES - 1)
+#define PRODUCER_TASK_PRIORITY  5
+#define TASK_STACK_SIZE         4096
+#define STATS_PERIOD_MS         1000
+#define LIVE_TIMEOUT_US         1000000  // Link frames take over the flash animation for this long
+#define MIRROR_FACETS           8        // Mirror edges per turn of the polygon mirror, set to the rig
 
-// RGB select pins
-#define RED_SELECT_PIN     15   // GPIO15 - Red color select
-#define GREEN_SELECT_PIN   16   // GPIO16 - Green color select
-#define BLUE_SELECT_PIN    17   // GPIO17 - Blue color select
+volatile uint8_t current_state = ETAT_ATTENTE_IMAGE;
+volatile uint8_t line_counter = 0;
 
-// 8-bit data bus pins
-#define DATA_PIN_0         43   // GPIO43 - Data bit 0 (LSB)
-#define DATA_PIN_1         44   // GPIO44 - Data bit 1
-#define DATA_PIN_2         1   // GPIO1 - Data bit 2
-#define DATA_PIN_3         2   // GPIO2 - Data bit 3
-#define DATA_PIN_4         42   // GPIO42 - Data bit 4
-#define DATA_PIN_5         41   // GPIO41 - Data bit 5
-#define DATA_PIN_6         40   // GPIO40 - Data bit 6
-#define DATA_PIN_7         39   // GPIO39 - Data bit 7 (MSB)
+// Selected by SCAN_OUT_I80, the simulator can change it before app_main
+static bool use_i80 = SCAN_OUT_I80;
+static scan_out_t* scan_out = NULL;
+static bus_map_t bus_map;  // Bus bits of the pins, as the host packed the lines
+static volatile bool line_active = false;  // A line (or a dark one on underrun) is going out
+static uint32_t line_edge_count = 0;        // Mirror edges when the line started
+static volatile uint32_t swap_edge_count = 0;  // Mirror edges at the last motor edge
 
-// Update COLOR_START_PIN to use first RGB select pin
-#define COLOR_START_PIN    RED_SELECT_PIN
+// Front/back frame pair, the receiver fills the back frame while the front one is displayed
+static frame_buffer_t frame_buffer;
 
-// Create array of data pins for easier iteration
-static const uint8_t DATA_PINS[8] = {
-    DATA_PIN_0, DATA_PIN_1, DATA_PIN_2, DATA_PIN_3,
-    DATA_PIN_4, DATA_PIN_5, DATA_PIN_6, DATA_PIN_7
-};
+// Lines prepared by the ingestion core for the scan-out core (internal RAM)
+static line_queue_t line_queue;
 
-#define PIXEL_DELAY_US  10000 // 10ms delay between pixels
-#define PIXELS_PER_LINE 100
-#define LINES_PER_FRAME 100
-#define SWAP_DELAY_MS 2000  // 2 seconds delay between image swaps
+// Line being displayed, owned by the scan-out until released
+static const line_slot_t* current_line = NULL;
 
-volatile uint8_t current_state = ETAT_ATTENTE_IMAGE;
-volatile uint8_t pixel_counter = 0;
-volatile uint8_t line_counter = 0;
-static int64_t last_swap_time = 0;
+// Frame of the lines of this revolution, -1 until its first line, and of the
+// previous revolution, whose leftovers are dropped (scan-out core only)
+static int32_t scan_frame = -1;
+static int32_t stale_frame = -1;
 
-// Define two static image matrices (100x100 RGB)
-static const uint8_t red_matrix[100][100][3] = {
-    [0 ... 99] = {
-        [0 ... 99] = {255, 0, 0}  // Full red for all pixels
-    }
-};
+static TaskHandle_t producer_task_handle = NULL;
+static TaskHandle_t scanout_task_handle = NULL;
 
-static const uint8_t green_matrix[100][100][3] = {
-    [0 ... 99] = {
-        [0 ... 99] = {0, 255, 0}  // Full green for all pixels
-    }
-};
+// Facet start delays and line gains (NVS), and which facet the mirror is on
+static calib_table_t calib;
+static calib_lock_t facet_lock;
+static volatile uint8_t mirror_facet = 0;
+static volatile int line0_facet = -1;  // Facet of line 0 over the stats period, -2 if it changed
+
+// Animation played from flash when the link is idle
+static anim_store_t animation;
+static bool animation_available = false;
 
-// Pointer to current matrix being displayed
-static const uint8_t (*current_matrix)[100][3] = red_matrix;
-static bool using_red_matrix = true;
+// Busy time per core in microseconds (wraps, only differences are used)
+static atomic_uint_fast32_t core_busy_us[2];
+
+// Scan-out counters
+static atomic_uint_fast32_t lines_underrun = 0;  // Mirror edge with no line ready
+static atomic_uint_fast32_t lines_dropped = 0;   // Lines of a past revolution or late for their row
 
 // Add debug counters
 static volatile uint32_t motor_interrupt_count = 0;
 static volatile uint32_t mirror_interrupt_count = 0;
 
-static void affiche_pixel(void) {
-    uint8_t r = current_matrix[line_counter][pixel_counter][0];
-    uint8_t g = current_matrix[line_counter][pixel_counter][1];
-    uint8_t b = current_matrix[line_counter][pixel_counter][2];
+// Edge timing histograms, exported with the stats
+static telemetry_t telemetry;
+static volatile int64_t mirror_edge_us = 0;       // Entry time of the last mirror ISR
+static volatile bool line_overrun_pending = false;
+static volatile int64_t line_overrun_edge_us = 0; // First mirror edge while the line was going out
+static atomic_uint_fast32_t lines_overrun = 0;    // Lines still going out at the next mirror edge
+
+// Wake the scan-out task, which sleeps between events
+static bool IRAM_ATTR wake_scanout_from_isr(void* arg) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(scanout_task_handle, &woken);
+    return woken == pdTRUE;
+}
 
-    // Set all RGB select pins low initially
-    gpio_set_level(RED_SELECT_PIN, 0);
-    gpio_set_level(GREEN_SELECT_PIN, 0);
-    gpio_set_level(BLUE_SELECT_PIN, 0);
+void IRAM_ATTR motor_rotation_isr(void* arg) {
+    telemetry_edge(&telemetry, TELEMETRY_MOTOR, esp_timer_get_time());
+    motor_interrupt_count++;
+    swap_edge_count = mirror_interrupt_count;
+    current_state = ETAT_SWAP_BUFFER;
+    portYIELD_FROM_ISR(wake_scanout_from_isr(NULL));
+}
 
-    // Set and display Red
-    for(int i = 0; i < 8; i++) {
-        gpio_set_level(DATA_PINS[i], (r >> i) & 0x01);
+void IRAM_ATTR mirror_change_isr(void* arg) {
+    int64_t now = esp_timer_get_time();
+    telemetry_edge(&telemetry, TELEMETRY_MIRROR, now);
+    if (line_active && !line_overrun_pending) {
+        // The previous line has not finished going out
+        line_overrun_edge_us = now;
+        line_overrun_pending = true;
+    }
+    mirror_facet = calib_lock_edge(&facet_lock, now);
+    mirror_edge_us = now;
+    mirror_interrupt_count++;
+    // The swap runs first, it starts the line itself if this edge came meanwhile.
+    // Past the last line the edges wait for the motor: a mirror slightly faster
+    // than LINES_PER_FRAME edges per revolution must not take the next frame.
+    if (current_state != ETAT_SWAP_BUFFER && line_counter < LINES_PER_FRAME) {
+        current_state = ETAT_AFFICHE_LIGNE;
     }
-    gpio_set_level(RED_SELECT_PIN, 1);
-    esp_rom_delay_us(10);
-    gpio_set_level(RED_SELECT_PIN, 0);  // Turn off red before moving to green
+    portYIELD_FROM_ISR(wake_scanout_from_isr(NULL));
+}
 
-    // Set and display Green
-    for(int i = 0; i < 8; i++) {
-        gpio_set_level(DATA_PINS[i], (g >> i) & 0x01);
+static void init_frame_buffer(void) {
+    frame_buffer_init(&frame_buffer);
+
+    // Full red test pattern until the first frame is received
+    static uint8_t red[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+    for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+        red[pixel][0] = 255;
+    }
+    frame_t* frame = frame_buffer_begin_write(&frame_buffer);
+#if FRAME_PALETTE
+    bus_pack_colors(&bus_map, red, 1, frame->palette);
+    memset(frame->indices, 0, sizeof(frame->indices));
+#else
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        bus_pack_phases(&bus_map, red, frame->phases[line]);
     }
-    gpio_set_level(GREEN_SELECT_PIN, 1);
-    esp_rom_delay_us(10);
-    gpio_set_level(GREEN_SELECT_PIN, 0);  // Turn off green before moving to blue
+#endif
+    frame_buffer_publish(&frame_buffer);
+    frame_buffer_swap(&frame_buffer);
+}
 
-    // Set and display Blue
-    for(int i = 0; i < 8; i++) {
-        gpio_set_level(DATA_PINS[i], (b >> i) & 0x01);
+frame_buffer_t* get_frame_buffer(void) {
+    return &frame_buffer;
+}
+
+static void account_busy(int core, int64_t start) {
+    atomic_fetch_add(&core_busy_us[core], (uint32_t)(esp_timer_get_time() - start));
+}
+
+static uint32_t animation_frame_at(int64_t elapsed_us) {
+    return (uint32_t)((elapsed_us * animation.fps_x100 / 100000000) % animation.frame_count);
+}
+
+// Ingestion core: fills the queue with the lines of the front frame, or decodes
+// them from the flash animation when no frame came from the link recently.
+// The queue applies back-pressure, so the producer only moves to the next frame
+// once the scan-out consumed the previous one, and frames swap between revolutions.
+static void line_producer_task(void* arg) {
+    uint16_t frame_counter = 0;
+    int64_t live_until = 0;
+    int64_t playback_start = esp_timer_get_time();
+    calib_gain_lut_t gain_lut;
+    calib_gain_lut_init(&gain_lut);
+    uint8_t decoded[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        if (frame_buffer_swap(&frame_buffer)) {
+            live_until = now + LIVE_TIMEOUT_US;
+        }
+        const frame_t* frame = frame_buffer_front(&frame_buffer);
+        bool playback = animation_available && now >= live_until;
+        uint32_t anim_frame = playback ? animation_frame_at(now - playback_start) : 0;
+
+        for (uint16_t line = 0; line < LINES_PER_FRAME; line++) {
+            line_slot_t* slot;
+            while ((slot = line_queue_reserve(&line_queue)) == NULL) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            int64_t start = esp_timer_get_time();
+            slot->line = line;
+            slot->frame = frame_counter;
+            if (playback) {
+                // Decoded one line ahead of the scan-out, then packed like the host does
+                anim_store_decode_line(&animation, anim_frame, line, decoded);
+                bus_pack_phases(&bus_map, decoded, slot->phases);
+            } else {
+#if FRAME_PALETTE
+                // Palette lookup in place of the copy, the scan-out still gets bus words
+                bus_expand_indices(frame->palette, frame->indices[line], slot->phases);
+#else
+                memcpy(slot->phases, frame->phases[line], sizeof(slot->phases));
+#endif
+            }
+            // Line gain applied here, the scan-out only copies words to the bus
+            const uint8_t* gain = calib_gain_table(&gain_lut, calib.line_gain[line]);
+            if (gain != NULL) {
+                bus_apply_lut(&bus_map, gain, slot->phases, PHASES_PER_LINE);
+            }
+            line_queue_commit(&line_queue);
+            account_busy(INGEST_CORE, start);
+        }
+        frame_counter++;
     }
-    gpio_set_level(BLUE_SELECT_PIN, 1);
-    esp_rom_delay_us(10);
-    gpio_set_level(BLUE_SELECT_PIN, 0);  // Turn off blue when done
 }
 
-void IRAM_ATTR motor_rotation_isr(void* arg) {
-    motor_interrupt_count++;
-    current_state = ETAT_SWAP_BUFFER;
+// Scan-out core: hand the current line back to the producer
+static void release_line(void) {
+    line_queue_release(&line_queue);
+    current_line = NULL;
+    xTaskNotifyGive(producer_task_handle);
 }
 
-void IRAM_ATTR mirror_change_isr(void* arg) {
-    mirror_interrupt_count++;
-    current_state = ETAT_AFFICHE_LIGNE;
-    pixel_counter = 0;
+// Scan-out core: drop the queued line at the head, it will not be shown
+static void drop_line(void) {
+    line_queue_release(&line_queue);
+    atomic_fetch_add(&lines_dropped, 1);
+    xTaskNotifyGive(producer_task_handle);
+}
+
+// Scan-out core: the queued line of row line_counter, NULL if it is not there
+// yet. Lines of the previous revolution and lines of this one that missed
+// their row are dropped, the next frame waits at the head of the queue: every
+// line lands on its own row whatever edges came too many or too few.
+static const line_slot_t* line_for_row(void) {
+    const line_slot_t* slot;
+    while ((slot = line_queue_peek(&line_queue)) != NULL) {
+        if (scan_frame < 0 && slot->frame != stale_frame) {
+            scan_frame = slot->frame;
+        }
+        if (slot->frame == scan_frame && slot->line >= line_counter) {
+            return slot->line == line_counter ? slot : NULL;
+        }
+        if (slot->frame != scan_frame && slot->frame != stale_frame) {
+            return NULL;
+        }
+        drop_line();
+    }
+    return NULL;
+}
+
+// Scan-out core: start sending the line of this row at the last mirror edge
+static void start_line(int64_t start) {
+    // Each facet starts its pixels after its own delay, so all lines line up
+    uint8_t facet = mirror_facet;
+    int64_t target = mirror_edge_us + calib.facet_delay_us[facet];
+    if (target > start) {
+        esp_rom_delay_us((uint32_t)(target - start));
+    }
+    if (line_counter == 0) {
+        line0_facet = line0_facet == -1 || line0_facet == facet ? facet : -2;
+    }
+    telemetry_record_us(&telemetry, TELEMETRY_EDGE_LATENCY, (uint32_t)(start - mirror_edge_us));
+
+    line_edge_count = mirror_interrupt_count;
+    line_active = true;
+    current_line = line_for_row();
+    if (current_line == NULL) {
+        // The line of this row is not queued yet (ingestion core late), the row stays dark
+        atomic_fetch_add(&lines_underrun, 1);
+        return;
+    }
+    esp_err_t err = scan_out->write_line(scan_out, current_line->phases);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Line not sent: %s", esp_err_to_name(err));
+    }
+}
+
+// Scan-out core: retire the line once the backend has sent it.
+// Returns false while it is still going out.
+static bool finish_line(void) {
+    if (current_line != NULL) {
+        if (!scan_out->line_done(scan_out)) {
+            return false;
+        }
+        release_line();
+    }
+    // Cleared first: an edge from now on belongs to the next line
+    line_active = false;
+    line_counter++;
+    if (line_overrun_pending) {
+        uint32_t late = (uint32_t)(esp_timer_get_time() - line_overrun_edge_us);
+        telemetry_record_us(&telemetry, TELEMETRY_LINE_OVERRUN, late);
+        atomic_fetch_add(&lines_overrun, 1);
+        line_overrun_pending = false;
+    }
+    return true;
+}
+
+static void init_scan_out(void) {
+    if (!use_i80) {
+        ESP_ERROR_CHECK(scan_out_new_gpio(&bus_map, &scan_out));
+        return;
+    }
+    scan_out_i80_config_t config = {
+        .map = &bus_map,
+        .pclk_hz = BUS_PCLK_HZ(I80_LINE_US),
+        .on_line_done = wake_scanout_from_isr,
+    };
+    ESP_ERROR_CHECK(scan_out_new_i80(&config, &scan_out));
 }
 
 void init_machine_etats(void) {
@@ -161,6 +360,7 @@ void init_machine_etats(void) {
     gpio_isr_handler_add(MOTOR_PIN, motor_rotation_isr, NULL);
     gpio_isr_handler_add(MIRROR_PIN, mirror_change_isr, NULL);
 
+    init_scan_out();
     ESP_LOGI(TAG, "GPIO interrupt configuration complete");
 }
 
@@ -168,13 +368,13 @@ void process_state(void) {
     static uint32_t last_motor_count = 0;
     static uint32_t last_mirror_count = 0;
 
-    // Log interrupt counts periodically
+    // Log interrupt counts (debug level: at 1kHz the console would hold up the scan-out)
     if (motor_interrupt_count != last_motor_count) {
-        ESP_LOGI(TAG, "Motor interrupts: %lu", motor_interrupt_count);
+        ESP_LOGD(TAG, "Motor interrupts: %lu", (unsigned long)motor_interrupt_count);
         last_motor_count = motor_interrupt_count;
     }
     if (mirror_interrupt_count != last_mirror_count) {
-        ESP_LOGI(TAG, "Mirror interrupts: %lu", mirror_interrupt_count);
+        ESP_LOGD(TAG, "Mirror interrupts: %lu", (unsigned long)mirror_interrupt_count);
         last_mirror_count = mirror_interrupt_count;
     }
 
@@ -188,16 +388,28 @@ void process_state(void) {
 
         case ETAT_SWAP_BUFFER:
             {
-                int64_t current_time = esp_timer_get_time() / 1000;  // Convert to milliseconds
-                if (current_time - last_swap_time >= SWAP_DELAY_MS) {
-                    using_red_matrix = !using_red_matrix;
-                    current_matrix = using_red_matrix ? red_matrix : green_matrix;
-                    last_swap_time = current_time;
-                    ESP_LOGI(TAG, "Buffer swapped to %s matrix", using_red_matrix ? "RED" : "GREEN");
+                // A line still going out finishes before the swap
+                if (line_active && !finish_line()) {
+                    break;
                 }
+                // New revolution: discard the leftovers of the previous one, the
+                // producer refills the queue with the next frame before line 0
+                if (scan_frame >= 0) {
+                    stale_frame = scan_frame;
+                    scan_frame = -1;
+                }
+                const line_slot_t* slot;
+                while ((slot = line_queue_peek(&line_queue)) != NULL && slot->frame == stale_frame) {
+                    drop_line();
+                }
+                xTaskNotifyGive(producer_task_handle);
                 line_counter = 0;
                 current_state = ETAT_ATTENTE_LIGNE;
-                ESP_LOGI(TAG, "Switching to ATTENTE_LIGNE state");
+                if (mirror_interrupt_count != swap_edge_count) {
+                    // The edge of line 0 came during the swap
+                    current_state = ETAT_AFFICHE_LIGNE;
+                }
+                ESP_LOGD(TAG, "Switching to ATTENTE_LIGNE state");
             }
             break;
 
@@ -209,32 +421,118 @@ void process_state(void) {
             break;
 
         case ETAT_AFFICHE_LIGNE:
-            affiche_pixel();
-            pixel_counter++;
-            
-            if(pixel_counter >= PIXELS_PER_LINE) {
-                line_counter++;
+            {
+                int64_t start = esp_timer_get_time();
+                if (!line_active) {
+                    start_line(start);
+                }
+                bool done = finish_line();
+                account_busy(SCANOUT_CORE, start);
+                if (!done) {
+                    break;  // The backend wakes the task at the end of the line
+                }
+
                 if(line_counter >= LINES_PER_FRAME) {
                     current_state = ETAT_ATTENTE_IMAGE;
-                    ESP_LOGI(TAG, "Frame complete - Switching to ATTENTE_IMAGE");
+                    ESP_LOGD(TAG, "Frame complete - Switching to ATTENTE_IMAGE");
                 } else {
                     current_state = ETAT_ATTENTE_LIGNE;
-                    ESP_LOGI(TAG, "Line complete - Waiting for next line");
+                    if (mirror_interrupt_count != line_edge_count) {
+                        // Overrun: the edge of the next line already came
+                        current_state = ETAT_AFFICHE_LIGNE;
+                    }
+                    ESP_LOGD(TAG, "Line complete - Waiting for next line");
                 }
             }
             break;
     }
 }
 
+static void scanout_task(void* arg) {
+    // GPIO interrupts are allocated on the core that installs them: this one
+    init_machine_etats();
+    ESP_LOGI(TAG, "State machine initialized on core %d, starting main loop", xPortGetCoreID());
+
+    while (1) {
+        process_state();
+        // Until the next motor/mirror edge or the end of the line, at most one tick
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+}
+
+static void log_stats(void) {
+    static uint32_t last_busy[2] = {0, 0};
+    static int64_t last_time = 0;
+
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed = (uint32_t)(now - last_time);
+    uint32_t busy[2];
+    for (int core = 0; core < 2; core++) {
+        busy[core] = atomic_load(&core_busy_us[core]) - last_busy[core];
+        last_busy[core] += busy[core];
+    }
+    last_time = now;
+
+    frame_buffer_stats_t stats;
+    frame_buffer_get_stats(&frame_buffer, &stats);
+    const frame_rx_t* rx = frame_link_get_rx();
+    ESP_LOGI(TAG, "core0=%lu%% core1=%lu%% shown=%lu late=%lu skipped=%lu crc_errors=%lu underrun=%lu dropped=%lu overrun=%lu",
+             (unsigned long)((uint64_t)busy[INGEST_CORE] * 100 / elapsed),
+             (unsigned long)((uint64_t)busy[SCANOUT_CORE] * 100 / elapsed),
+             (unsigned long)stats.shown, (unsigned long)stats.late, (unsigned long)stats.skipped,
+             (unsigned long)rx->crc_errors,
+             (unsigned long)atomic_load(&lines_underrun), (unsigned long)atomic_load(&lines_dropped),
+             (unsigned long)atomic_load(&lines_overrun));
+
+    // Timing histograms, decoded on the host by tools/telemetry_decode
+    static uint8_t tlm_data[TELEMETRY_MAX_EXPORT];
+    static char tlm_text[4 * ((TELEMETRY_MAX_EXPORT + 2) / 3) + 1];
+    size_t len = telemetry_export(&telemetry, now, tlm_data);
+    telemetry_base64(tlm_data, len, tlm_text);
+    ESP_LOGI(TAG, "TLM:%s", tlm_text);
+
+    // Facet timing for tools/calib_gen: facet count, facet of line 0 ('-' if it moved), line period, signature
+    if (calib_lock_update(&facet_lock, &calib)) {
+        ESP_LOGI(TAG, "Facet numbering realigned on the calibration");
+    }
+    int16_t signature[CALIB_MAX_FACETS];
+    calib_lock_signature(&facet_lock, signature);
+    char cal_text[16 * (CALIB_MAX_FACETS + 3)];
+    int pos = snprintf(cal_text, sizeof(cal_text), "%u:", MIRROR_FACETS);
+    pos += line0_facet >= 0 ? snprintf(cal_text + pos, sizeof(cal_text) - pos, "%d:", line0_facet)
+                            : snprintf(cal_text + pos, sizeof(cal_text) - pos, "-:");
+    pos += snprintf(cal_text + pos, sizeof(cal_text) - pos, "%lu:",
+                    (unsigned long)(telemetry.edges[TELEMETRY_MIRROR].mean_period_x16 >> 4));
+    for (int f = 0; f < MIRROR_FACETS; f++) {
+        pos += snprintf(cal_text + pos, sizeof(cal_text) - pos, f ? ",%d" : "%d", signature[f]);
+    }
+    ESP_LOGI(TAG, "CAL:%s", cal_text);
+    line0_facet = -1;
+}
+
 void app_main(void) {
     ESP_LOGI(TAG, "Initializing state machine");
-    init_machine_etats();
-    ESP_LOGI(TAG, "State machine initialized, starting main loop");
+    if (!bus_map_init(&bus_map)) {
+        ESP_LOGE(TAG, "Data or select pin missing from PIN_MAP_BUS");
+        abort();
+    }
+    telemetry_init(&telemetry, esp_timer_get_time());
+    init_frame_buffer();
+    line_queue_init(&line_queue);
+    animation_available = anim_flash_open(&animation);
+    calib_nvs_load(&calib, MIRROR_FACETS);
+    calib_lock_init(&facet_lock, MIRROR_FACETS);
+
+    // app_main runs on core 0: the link and its SPI interrupt stay on the ingestion core
+    frame_link_start(&frame_buffer);
+    xTaskCreatePinnedToCore(line_producer_task, "line_producer", TASK_STACK_SIZE, NULL,
+                            PRODUCER_TASK_PRIORITY, &producer_task_handle, INGEST_CORE);
+    xTaskCreatePinnedToCore(scanout_task, "scanout", TASK_STACK_SIZE, NULL,
+                            SCANOUT_TASK_PRIORITY, &scanout_task_handle, SCANOUT_CORE);
     ESP_LOGI(TAG, "Expecting: Motor frequency=10Hz, Mirror frequency=1kHz");
-    
-    // Main loop
+
     while (1) {
-        process_state();
-        vTaskDelay(1);  // Minimal delay of 1 tick
+        vTaskDelay(pdMS_TO_TICKS(STATS_PERIOD_MS));
+        log_stats();
     }
 }
@@ -0,0 +1,37 @@
+#pragma once
+
+// Wiring of the projector board. Shared by the firmware and by the host, which
+// packs frames into bus words for these pins (bus_pack.h): change a pin here
+// and rebuild both sides.
+
+// Input pins
+#define MOTOR_PIN           4   // GPIO4  - Motor rotation detection
+#define MIRROR_PIN          5   // GPIO5  - Mirror position detection
+
+// RGB select pins
+#define RED_SELECT_PIN     15   // GPIO15 - Red color select
+#define GREEN_SELECT_PIN   16   // GPIO16 - Green color select
+#define BLUE_SELECT_PIN    17   // GPIO17 - Blue color select
+
+// 8-bit data bus pins
+#define DATA_PIN_0         43   // GPIO43 - Data bit 0 (LSB)
+#define DATA_PIN_1         44   // GPIO44 - Data bit 1
+#define DATA_PIN_2         1    // GPIO1  - Data bit 2
+#define DATA_PIN_3         2    // GPIO2  - Data bit 3
+#define DATA_PIN_4         42   // GPIO42 - Data bit 4
+#define DATA_PIN_5         41   // GPIO41 - Data bit 5
+#define DATA_PIN_6         40   // GPIO40 - Data bit 6
+#define DATA_PIN_7         39   // GPIO39 - Data bit 7 (MSB)
+
+#define PIN_MAP_DATA   {DATA_PIN_0, DATA_PIN_1, DATA_PIN_2, DATA_PIN_3, DATA_PIN_4, DATA_PIN_5, DATA_PIN_6, DATA_PIN_7}
+#define PIN_MAP_SELECT {RED_SELECT_PIN, GREEN_SELECT_PIN, BLUE_SELECT_PIN}
+
+// 16-bit parallel bus of the I80 scan-out: GPIO driven by each bit of a bus word,
+// bit 0 first. The bits follow the GPIO numbers of the header, so a bus word reads
+// like a logic analyser capture of it. GPIO7, 8, 9, 14 and 18 complete the bus
+// and are not connected.
+#define PIN_MAP_BUS {1, 2, 15, 16, 17, 39, 40, 41, 42, 43, 44, 7, 8, 9, 14, 18}
+#define PIN_MAP_BUS_WIDTH 16
+
+#define I80_WR_PIN         21   // GPIO21 - Pixel clock of the I80 bus, not connected
+#define I80_DC_PIN         38   // GPIO38 - Required by the I80 bus, not connected
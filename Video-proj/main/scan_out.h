@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "bus_pack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output of the lines to the 8 data + 3 select pins of the light modulator.
+// The state machine hands over whole lines and does not know how they go out:
+// bit-banged with GPIO writes, or streamed by DMA through the LCD_CAM peripheral.
+
+typedef struct scan_out_t scan_out_t;
+
+struct scan_out_t {
+    // Start sending a line of phase words (bus_pack.h). They may be reused as soon
+    // as it returns. Only one line at a time: the previous one must be done.
+    esp_err_t (*write_line)(scan_out_t* out, const uint16_t phases[PHASES_PER_LINE]);
+
+    // True once the last line written is completely out
+    bool (*line_done)(scan_out_t* out);
+};
+
+// Called from the interrupt that completes a line, returns true if it woke a
+// higher priority task
+typedef bool (*scan_out_done_cb_t)(void* ctx);
+
+// CPU writes every pin of pin_map.h, write_line returns once the line is out
+// (10us per select pulse). The map must outlive the backend.
+esp_err_t scan_out_new_gpio(const bus_map_t* map, scan_out_t** ret);
+
+typedef struct {
+    const bus_map_t* map;     // Must outlive the backend
+    uint32_t pclk_hz;         // One bus word per period, see bus_pack.h
+    scan_out_done_cb_t on_line_done;
+    void* ctx;
+} scan_out_i80_config_t;
+
+// Lines streamed on the PIN_MAP_BUS pins by the LCD_CAM I80 bus (DMA),
+// write_line returns right away and the CPU is free while the line goes out
+esp_err_t scan_out_new_i80(const scan_out_i80_config_t* config, scan_out_t** ret);
+
+#ifdef __cplusplus
+}
+#endif
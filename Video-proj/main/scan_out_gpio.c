@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "scan_out.h"
+
+#define SELECT_PULSE_US 10
+
+static const int DATA_PINS[8] = PIN_MAP_DATA;
+static const int SELECT_PINS[BYTES_PER_PIXEL] = PIN_MAP_SELECT;
+
+typedef struct {
+    scan_out_t base;
+    const bus_map_t* map;
+} scan_out_gpio_t;
+
+static void affiche_pixel(const bus_map_t* map, const uint16_t phases[BYTES_PER_PIXEL]) {
+    // Set all RGB select pins low initially
+    for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+        gpio_set_level(SELECT_PINS[color], 0);
+    }
+
+    // Red, green then blue: data first, then a pulse on the select of the colour
+    for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+        uint8_t value = bus_word_value(map, phases[color]);
+        for (int i = 0; i < 8; i++) {
+            gpio_set_level(DATA_PINS[i], (value >> i) & 0x01);
+        }
+        gpio_set_level(SELECT_PINS[color], 1);
+        esp_rom_delay_us(SELECT_PULSE_US);
+        gpio_set_level(SELECT_PINS[color], 0);
+    }
+}
+
+static esp_err_t scan_out_gpio_write_line(scan_out_t* out, const uint16_t phases[PHASES_PER_LINE]) {
+    scan_out_gpio_t* gpio_out = (scan_out_gpio_t*)out;
+    for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+        affiche_pixel(gpio_out->map, &phases[pixel * BYTES_PER_PIXEL]);
+    }
+    return ESP_OK;
+}
+
+static bool scan_out_gpio_line_done(scan_out_t* out) {
+    return true;
+}
+
+esp_err_t scan_out_new_gpio(const bus_map_t* map, scan_out_t** ret) {
+    scan_out_gpio_t* gpio_out = calloc(1, sizeof(scan_out_gpio_t));
+    if (gpio_out == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    gpio_out->map = map;
+    gpio_out->base.write_line = scan_out_gpio_write_line;
+    gpio_out->base.line_done = scan_out_gpio_line_done;
+    *ret = &gpio_out->base;
+    return ESP_OK;
+}
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include "esp_lcd_panel_io.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "bus_pack.h"
+#include "scan_out.h"
+
+static const char* TAG = "SCAN_OUT";
+
+typedef struct {
+    scan_out_t base;
+    esp_lcd_i80_bus_handle_t bus;
+    esp_lcd_panel_io_handle_t io;
+    const bus_map_t* map;
+    uint16_t* words;  // Read by the DMA while the line goes out
+    volatile bool busy;
+    scan_out_done_cb_t on_line_done;
+    void* ctx;
+} scan_out_i80_t;
+
+static bool IRAM_ATTR on_trans_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t* edata, void* user_ctx) {
+    scan_out_i80_t* i80 = user_ctx;
+    i80->busy = false;
+    return i80->on_line_done != NULL && i80->on_line_done(i80->ctx);
+}
+
+static esp_err_t scan_out_i80_write_line(scan_out_t* out, const uint16_t phases[PHASES_PER_LINE]) {
+    scan_out_i80_t* i80 = (scan_out_i80_t*)out;
+    if (i80->busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bus_expand_line(i80->map, phases, i80->words);
+    i80->busy = true;
+    // No command phase: the bus only clocks out the words
+    esp_err_t err = esp_lcd_panel_io_tx_color(i80->io, -1, i80->words, BUS_LINE_BYTES);
+    if (err != ESP_OK) {
+        i80->busy = false;
+    }
+    return err;
+}
+
+static bool scan_out_i80_line_done(scan_out_t* out) {
+    return !((scan_out_i80_t*)out)->busy;
+}
+
+esp_err_t scan_out_new_i80(const scan_out_i80_config_t* config, scan_out_t** ret) {
+    scan_out_i80_t* i80 = calloc(1, sizeof(scan_out_i80_t));
+    if (i80 == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = ESP_ERR_NO_MEM;
+    i80->words = heap_caps_calloc(1, BUS_LINE_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (i80->words == NULL) {
+        goto err;
+    }
+
+    // Bus bit i drives data_gpio_nums[i], in the layout of pin_map.h
+    static const int bus_pins[PIN_MAP_BUS_WIDTH] = PIN_MAP_BUS;
+    esp_lcd_i80_bus_config_t bus_config = {
+        .dc_gpio_num = I80_DC_PIN,
+        .wr_gpio_num = I80_WR_PIN,
+        .clk_src = LCD_CLK_SRC_DEFAULT,
+        .bus_width = PIN_MAP_BUS_WIDTH,
+        .max_transfer_bytes = BUS_LINE_BYTES,
+    };
+    for (int i = 0; i < PIN_MAP_BUS_WIDTH; i++) {
+        bus_config.data_gpio_nums[i] = bus_pins[i];
+    }
+    err = esp_lcd_new_i80_bus(&bus_config, &i80->bus);
+    if (err != ESP_OK) {
+        goto err;
+    }
+
+    esp_lcd_panel_io_i80_config_t io_config = {
+        .cs_gpio_num = -1,
+        .pclk_hz = config->pclk_hz,
+        .trans_queue_depth = 1,  // One line at a time, each starts at its mirror edge
+        .on_color_trans_done = on_trans_done,
+        .user_ctx = i80,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+        .dc_levels = {
+            .dc_data_level = 1,
+        },
+    };
+    err = esp_lcd_new_panel_io_i80(i80->bus, &io_config, &i80->io);
+    if (err != ESP_OK) {
+        goto err;
+    }
+
+    i80->map = config->map;
+    i80->on_line_done = config->on_line_done;
+    i80->ctx = config->ctx;
+    i80->base.write_line = scan_out_i80_write_line;
+    i80->base.line_done = scan_out_i80_line_done;
+    *ret = &i80->base;
+    ESP_LOGI(TAG, "I80 scan-out, %lu Hz pixel clock, %u words per line",
+             (unsigned long)config->pclk_hz, BUS_LINE_WORDS);
+    return ESP_OK;
+err:
+    if (i80->bus) {
+        esp_lcd_del_i80_bus(i80->bus);
+    }
+    heap_caps_free(i80->words);
+    free(i80);
+    return err;
+}
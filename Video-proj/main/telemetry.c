@@ -0,0 +1,129 @@
+#include <string.h>
+#include "telemetry.h"
+
+// Export layout (little endian, counters as LEB128 varints, mostly 1 byte):
+//   magic(1) version(1) seq(2) window_ms(4)
+//   mean period of each signal, then for each histogram max_us and the 32 buckets,
+//   then the glitch count of each signal
+
+void telemetry_init(telemetry_t* tlm, int64_t now_us) {
+    memset(tlm, 0, sizeof(*tlm));
+    tlm->window_start_us = now_us;
+}
+
+static uint8_t* put_varint(uint8_t* p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static bool get_varint(const uint8_t** p, const uint8_t* end, uint32_t* v) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*p == end) {
+            return false;
+        }
+        uint8_t byte = *(*p)++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *v = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t telemetry_export(telemetry_t* tlm, int64_t now_us, uint8_t* out) {
+    uint32_t finished = tlm->active;
+    // ISRs pick the new window up on their next edge; an update still in flight on the
+    // finished window is at most one count, not worth a lock in the ISR
+    tlm->active = finished ^ 1;
+    const telemetry_window_t* window = &tlm->windows[finished];
+
+    uint32_t window_ms = (uint32_t)((now_us - tlm->window_start_us) / 1000);
+    tlm->window_start_us = now_us;
+    uint16_t seq = tlm->export_seq++;
+
+    uint8_t* p = out;
+    *p++ = TELEMETRY_MAGIC;
+    *p++ = TELEMETRY_VERSION;
+    *p++ = seq & 0xFF;
+    *p++ = seq >> 8;
+    for (int i = 0; i < 4; i++) {
+        *p++ = (window_ms >> (8 * i)) & 0xFF;
+    }
+    for (int s = 0; s < TELEMETRY_SIGNAL_COUNT; s++) {
+        p = put_varint(p, tlm->edges[s].mean_period_x16 >> 4);
+    }
+    for (int h = 0; h < TELEMETRY_HIST_COUNT; h++) {
+        p = put_varint(p, window->max_us[h]);
+        for (int b = 0; b < TELEMETRY_BUCKETS; b++) {
+            p = put_varint(p, window->buckets[h][b]);
+        }
+    }
+    for (int s = 0; s < TELEMETRY_SIGNAL_COUNT; s++) {
+        p = put_varint(p, window->glitches[s]);
+    }
+
+    memset(&tlm->windows[finished], 0, sizeof(telemetry_window_t));
+    return (size_t)(p - out);
+}
+
+void telemetry_base64(const uint8_t* data, size_t len, char* out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 2 < len; i += 3) {
+        uint32_t v = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = alphabet[(v >> 6) & 0x3F];
+        *out++ = alphabet[v & 0x3F];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) {
+            v |= (uint32_t)data[i + 1] << 8;
+        }
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = i + 1 < len ? alphabet[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+bool telemetry_parse(const uint8_t* data, size_t len, telemetry_report_t* report) {
+    if (len < 8 || data[0] != TELEMETRY_MAGIC || data[1] != TELEMETRY_VERSION) {
+        return false;
+    }
+    memset(report, 0, sizeof(*report));
+    report->seq = (uint16_t)(data[2] | (data[3] << 8));
+    report->window_ms = data[4] | (data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+
+    const uint8_t* p = data + 8;
+    const uint8_t* end = data + len;
+    for (int s = 0; s < TELEMETRY_SIGNAL_COUNT; s++) {
+        if (!get_varint(&p, end, &report->mean_period_us[s])) {
+            return false;
+        }
+    }
+    for (int h = 0; h < TELEMETRY_HIST_COUNT; h++) {
+        if (!get_varint(&p, end, &report->window.max_us[h])) {
+            return false;
+        }
+        for (int b = 0; b < TELEMETRY_BUCKETS; b++) {
+            if (!get_varint(&p, end, &report->window.buckets[h][b])) {
+                return false;
+            }
+        }
+    }
+    for (int s = 0; s < TELEMETRY_SIGNAL_COUNT; s++) {
+        if (!get_varint(&p, end, &report->window.glitches[s])) {
+            return false;
+        }
+    }
+    return p == end;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timing telemetry of the motor and mirror signals, in fixed memory.
+//
+// Jitter histograms are signed log2 buckets of the deviation from the running
+// mean period: bucket 16 is |d| < 1 us, 16 + k (resp. 16 - k) holds deviations
+// of +[2^(k-1), 2^k) us (resp. negative). Latency and overrun histograms are
+// plain log2 buckets: bucket k holds [2^(k-1), 2^k) us, bucket 0 is 0 us.
+
+#define TELEMETRY_BUCKETS   32
+#define TELEMETRY_MAGIC     0x54  // 'T'
+#define TELEMETRY_VERSION   1
+#define TELEMETRY_MAX_EXPORT 688  // Worst case, every value a 5 byte varint
+// Longest edge interval recorded, about 134 s: in 1/16 us it still fits an int32_t
+#define TELEMETRY_MAX_INTERVAL_US ((1u << 27) - 1)
+
+typedef enum {
+    TELEMETRY_MOTOR_JITTER,   // Motor edge interval minus the mean revolution period
+    TELEMETRY_MIRROR_JITTER,  // Mirror edge interval minus the mean line period
+    TELEMETRY_EDGE_LATENCY,   // Mirror ISR entry to the start of the line output
+    TELEMETRY_LINE_OVERRUN,   // How late a line finished after the next mirror edge
+    TELEMETRY_HIST_COUNT
+} telemetry_hist_t;
+
+typedef enum {
+    TELEMETRY_MOTOR,
+    TELEMETRY_MIRROR,
+    TELEMETRY_SIGNAL_COUNT
+} telemetry_signal_t;
+
+typedef struct {
+    uint32_t buckets[TELEMETRY_HIST_COUNT][TELEMETRY_BUCKETS];
+    uint32_t max_us[TELEMETRY_HIST_COUNT];
+    uint32_t glitches[TELEMETRY_SIGNAL_COUNT];  // Edges closer than a quarter of the mean period
+} telemetry_window_t;
+
+// Per-signal edge tracking, only touched by the ISR of that signal
+typedef struct {
+    int64_t last_edge_us;
+    uint32_t mean_period_x16;  // Exponential mean of the period, 1/16 us
+} telemetry_edge_t;
+
+typedef struct {
+    telemetry_window_t windows[2];       // Recording window and the one being exported
+    volatile uint32_t active;
+    telemetry_edge_t edges[TELEMETRY_SIGNAL_COUNT];
+    uint16_t export_seq;
+    int64_t window_start_us;
+} telemetry_t;
+
+// Decoded export, as produced by telemetry_parse
+typedef struct {
+    uint16_t seq;
+    uint32_t window_ms;
+    uint32_t mean_period_us[TELEMETRY_SIGNAL_COUNT];
+    telemetry_window_t window;
+} telemetry_report_t;
+
+static inline uint32_t telemetry_log2_bucket(uint32_t us) {
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    return bucket < TELEMETRY_BUCKETS ? bucket : TELEMETRY_BUCKETS - 1;
+}
+
+// Inline so that it lands in the IRAM of the ISR calling it
+static inline void telemetry_record(telemetry_t* tlm, telemetry_hist_t hist, uint32_t bucket, uint32_t us) {
+    telemetry_window_t* window = &tlm->windows[tlm->active];
+    window->buckets[hist][bucket]++;
+    if (us > window->max_us[hist]) {
+        window->max_us[hist] = us;
+    }
+}
+
+static inline void telemetry_record_us(telemetry_t* tlm, telemetry_hist_t hist, uint32_t us) {
+    telemetry_record(tlm, hist, telemetry_log2_bucket(us), us);
+}
+
+// Call from the edge ISR with the ISR entry time
+static inline void telemetry_edge(telemetry_t* tlm, telemetry_signal_t signal, int64_t now_us) {
+    telemetry_edge_t* edge = &tlm->edges[signal];
+    if (edge->last_edge_us != 0) {
+        // A stopped motor saturates the interval instead of wrapping it to a short one
+        int64_t elapsed = now_us - edge->last_edge_us;
+        uint32_t interval = elapsed < TELEMETRY_MAX_INTERVAL_US ? (uint32_t)elapsed : TELEMETRY_MAX_INTERVAL_US;
+        uint32_t mean = edge->mean_period_x16 >> 4;
+        if (mean != 0 && interval < mean / 4) {
+            // Got through the glitch filter: do not let it pull the mean down
+            tlm->windows[tlm->active].glitches[signal]++;
+            return;
+        }
+        if (mean == 0) {
+            // First interval, or the first after a stop
+            edge->mean_period_x16 = interval < TELEMETRY_MAX_INTERVAL_US ? interval << 4 : 0;
+        } else {
+            int32_t deviation = (int32_t)interval - (int32_t)mean;
+            uint32_t magnitude = deviation < 0 ? (uint32_t)-deviation : (uint32_t)deviation;
+            uint32_t k = telemetry_log2_bucket(magnitude);
+            if (k > TELEMETRY_BUCKETS / 2 - 1) {
+                k = TELEMETRY_BUCKETS / 2 - 1;
+            }
+            uint32_t bucket = deviation < 0 ? TELEMETRY_BUCKETS / 2 - k : TELEMETRY_BUCKETS / 2 + k;
+            telemetry_hist_t hist = signal == TELEMETRY_MOTOR ? TELEMETRY_MOTOR_JITTER : TELEMETRY_MIRROR_JITTER;
+            telemetry_record(tlm, hist, bucket, magnitude);
+            if (interval / 4 > mean) {
+                // Stopped: the mean starts again from the next interval, a stop
+                // in it would take every edge after for a glitch
+                edge->mean_period_x16 = 0;
+            } else {
+                edge->mean_period_x16 += ((int32_t)(interval << 4) - (int32_t)edge->mean_period_x16) / 16;
+            }
+        }
+    }
+    edge->last_edge_us = now_us;
+}
+
+void telemetry_init(telemetry_t* tlm, int64_t now_us);
+
+// Switch recording to the other window and serialize the finished one into out
+// (at most TELEMETRY_MAX_EXPORT bytes). Returns the number of bytes written.
+size_t telemetry_export(telemetry_t* tlm, int64_t now_us, uint8_t* out);
+
+// Base64 text of an export, for the console. out needs 4 * ((len + 2) / 3) + 1 bytes.
+void telemetry_base64(const uint8_t* data, size_t len, char* out);
+
+// Decode an export (host side)
+bool telemetry_parse(const uint8_t* data, size_t len, telemetry_report_t* report);
+
+#ifdef __cplusplus
+}
+#endif
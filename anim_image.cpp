@@ -0,0 +1,94 @@
+#include "anim_image.hpp"
+#include "anim_store.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+std::vector<uint8_t> anim_encode_line(const uint8_t* indices, int width) {
+    std::vector<uint8_t> out;
+    int x = 0;
+    while (x < width) {
+        int run = 1;
+        while (x + run < width && run < ANIM_STORE_MAX_RUN && indices[x + run] == indices[x]) {
+            run++;
+        }
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            out.push_back(indices[x]);
+            x += run;
+            continue;
+        }
+        // Literals up to the next run worth encoding
+        int start = x;
+        while (x < width && x - start < ANIM_STORE_MAX_RUN) {
+            if (x + 2 < width && indices[x] == indices[x + 1] && indices[x] == indices[x + 2]) {
+                break;
+            }
+            x++;
+        }
+        out.push_back(static_cast<uint8_t>(x - start - 1));
+        out.insert(out.end(), indices + start, indices + x);
+    }
+    return out;
+}
+
+static void put_u16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    put_u16(out, v & 0xFFFF);
+    put_u16(out, v >> 16);
+}
+
+AnimImage anim_encode(const std::vector<Rgb>& palette, const std::vector<std::vector<uint8_t>>& frames, double fps) {
+    if (palette.empty() || palette.size() > 256) {
+        throw std::logic_error("Animation palette must have 1 to 256 colours");
+    }
+    if (frames.empty()) {
+        throw std::logic_error("No frame to pack");
+    }
+    // Header, palette (R G B), line table, then deduplicated line streams
+    AnimImage image;
+    std::vector<uint8_t>& bytes = image.bytes;
+    put_u32(bytes, ANIM_STORE_MAGIC);
+    put_u16(bytes, ANIM_STORE_VERSION);
+    put_u16(bytes, PIXELS_PER_LINE);
+    put_u16(bytes, LINES_PER_FRAME);
+    put_u16(bytes, static_cast<uint16_t>(palette.size()));
+    put_u32(bytes, static_cast<uint32_t>(frames.size()));
+    put_u32(bytes, static_cast<uint32_t>(fps * 100));
+    for (const Rgb& color : palette) {
+        bytes.insert(bytes.end(), color.begin(), color.end());
+    }
+    size_t table_offset = bytes.size();
+    bytes.resize(table_offset + frames.size() * LINES_PER_FRAME * 4);
+
+    std::unordered_map<std::string, uint32_t> lines_seen;
+    for (size_t f = 0; f < frames.size(); f++) {
+        if (frames[f].size() != LINES_PER_FRAME * PIXELS_PER_LINE) {
+            throw std::logic_error("Frame size does not match the projector geometry");
+        }
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            std::vector<uint8_t> encoded = anim_encode_line(&frames[f][line * PIXELS_PER_LINE], PIXELS_PER_LINE);
+            std::string key(encoded.begin(), encoded.end());
+            auto it = lines_seen.find(key);
+            uint32_t offset;
+            if (it != lines_seen.end()) {
+                offset = it->second;
+                image.shared_lines++;
+            } else {
+                offset = static_cast<uint32_t>(bytes.size());
+                bytes.insert(bytes.end(), encoded.begin(), encoded.end());
+                lines_seen[key] = offset;
+            }
+            std::vector<uint8_t> entry;
+            put_u32(entry, offset);
+            std::copy(entry.begin(), entry.end(), bytes.begin() + table_offset + (f * LINES_PER_FRAME + line) * 4);
+        }
+    }
+    return image;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "palette.hpp"
+
+// Compressed animation image of Video-proj/main/anim_store.h, from frames of
+// palette indices at the projector geometry. Built by tools/anim_pack.
+struct AnimImage {
+    std::vector<uint8_t> bytes;
+    size_t shared_lines = 0;  // Lines stored once for several frames or lines
+};
+
+// RLE stream of one line of palette indices
+std::vector<uint8_t> anim_encode_line(const uint8_t* indices, int width);
+
+// frames: LINES_PER_FRAME * PIXELS_PER_LINE indices into palette each, line by
+// line. Identical lines share their data.
+AnimImage anim_encode(const std::vector<Rgb>& palette, const std::vector<std::vector<uint8_t>>& frames, double fps);
@@ -0,0 +1,115 @@
+#include "area_resize.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+// Sums of the rows rows of row (rows known at compile time if ROWS > 0), width bytes each
+template <typename Sum, int ROWS>
+void sum_rows(const uint8_t* row, size_t stride, int rows, size_t width, Sum* sums) {
+    if (ROWS > 0) {
+        for (size_t i = 0; i < width; i++) {
+            Sum sum = row[i];
+            for (int y = 1; y < ROWS; y++) {
+                sum += row[y * stride + i];
+            }
+            sums[i] = sum;
+        }
+        return;
+    }
+    for (size_t i = 0; i < width; i++) {
+        sums[i] = row[i];
+    }
+    for (int y = 1; y < rows; y++) {
+        const uint8_t* next = row + y * stride;
+        for (size_t i = 0; i < width; i++) {
+            sums[i] += next[i];
+        }
+    }
+}
+
+// Means of the blocks of a row of sums of rows rows: blocks of COLUMNS columns
+// if known at compile time, else from x_edges
+template <typename Sum, int COLUMNS>
+void average_blocks(const Sum* sums, const int* x_edges, int rows, int dst_width, uint8_t* out) {
+    for (int x = 0; x < dst_width; x++) {
+        int first = COLUMNS > 0 ? x * COLUMNS : x_edges[x];
+        int columns = COLUMNS > 0 ? COLUMNS : x_edges[x + 1] - first;
+        const Sum* block = sums + first * 3;
+        uint32_t b = 0;
+        uint32_t g = 0;
+        uint32_t r = 0;
+        for (int i = 0; i < columns; i++) {
+            b += block[i * 3];
+            g += block[i * 3 + 1];
+            r += block[i * 3 + 2];
+        }
+        uint32_t count = COLUMNS > 0 ? uint32_t(COLUMNS) * rows : uint32_t(columns) * rows;
+        out[x * 3] = static_cast<uint8_t>((b + count / 2) / count);
+        out[x * 3 + 1] = static_cast<uint8_t>((g + count / 2) / count);
+        out[x * 3 + 2] = static_cast<uint8_t>((r + count / 2) / count);
+    }
+}
+
+// Downscaling by RATIO on both axes, divisor and loop bounds constant
+template <int RATIO>
+void downscale_by(const uint8_t* src, size_t src_stride, uint8_t* dst, int dst_width, int dst_height,
+                  uint16_t* sums) {
+    size_t width = size_t(dst_width) * RATIO * 3;
+    for (int y = 0; y < dst_height; y++) {
+        sum_rows<uint16_t, RATIO>(src + size_t(y) * RATIO * src_stride, src_stride, RATIO, width, sums);
+        average_blocks<uint16_t, RATIO>(sums, nullptr, RATIO, dst_width, dst + size_t(y) * dst_width * 3);
+    }
+}
+
+template <typename Sum>
+void downscale(const uint8_t* src, int src_width, int src_height, size_t src_stride, uint8_t* dst, int dst_width,
+               int dst_height, const int* x_edges, Sum* sums) {
+    size_t width = size_t(src_width) * 3;
+    for (int y = 0; y < dst_height; y++) {
+        int first = static_cast<int>(int64_t(y) * src_height / dst_height);
+        int rows = static_cast<int>(int64_t(y + 1) * src_height / dst_height) - first;
+        sum_rows<Sum, 0>(src + size_t(first) * src_stride, src_stride, rows, width, sums);
+        average_blocks<Sum, 0>(sums, x_edges, rows, dst_width, dst + size_t(y) * dst_width * 3);
+    }
+}
+
+}  // namespace
+
+void AreaDownscaler::resize(const uint8_t* src, int src_width, int src_height, size_t src_stride, uint8_t* dst,
+                            int dst_width, int dst_height) {
+    if (dst_width <= 0 || dst_height <= 0 || dst_width > src_width || dst_height > src_height) {
+        throw std::logic_error("AreaDownscaler only scales down");
+    }
+    sums_.resize(size_t(src_width) * 3);
+    int ratio = src_width / dst_width;
+    if (src_width == dst_width * ratio && src_height == dst_height * ratio) {
+        switch (ratio) {
+        case 2:
+            return downscale_by<2>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        case 3:
+            return downscale_by<3>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        case 4:
+            return downscale_by<4>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        case 5:
+            return downscale_by<5>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        case 8:
+            return downscale_by<8>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        case 10:
+            return downscale_by<10>(src, src_stride, dst, dst_width, dst_height, sums_.data());
+        }
+    }
+
+    x_edges_.resize(dst_width + 1);
+    for (int x = 0; x <= dst_width; x++) {
+        x_edges_[x] = static_cast<int>(int64_t(x) * src_width / dst_width);
+    }
+    // Tallest block: 65535 / 255 = 257 rows fit in 16 bits
+    if ((src_height + dst_height - 1) / dst_height <= 257) {
+        downscale(src, src_width, src_height, src_stride, dst, dst_width, dst_height, x_edges_.data(), sums_.data());
+    } else {
+        wide_sums_.resize(size_t(src_width) * 3);
+        downscale(src, src_width, src_height, src_stride, dst, dst_width, dst_height, x_edges_.data(),
+                  wide_sums_.data());
+    }
+}
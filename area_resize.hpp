@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Box (area) downscaling of 8 bit images of 3 interleaved channels, for the
+// large ratios from the video to the projector (1080p to 100x100 is about
+// 20:1). Each output pixel is the rounded mean of the block of source pixels
+// it covers. The blocks are whole pixels: with a ratio that is not an integer
+// they are one pixel wider or taller here and there, every source pixel still
+// counting once, where cv::INTER_AREA weighs the pixels cut by a block edge.
+//
+// The source rows of a block are summed first into one row of sums, a plain
+// loop the compiler vectorises (16 bit sums up to 257 rows), then the columns
+// of each block of that row. The integer ratios 2, 3, 4, 5, 8 and 10, the same
+// on both axes, have their own code with constant block sizes and divisor.
+class AreaDownscaler {
+public:
+    // src_width x src_height pixels with rows src_stride bytes apart, into
+    // dst_width x dst_height pixels with no gap between the rows. The output
+    // is not larger than the source.
+    void resize(const uint8_t* src, int src_width, int src_height, size_t src_stride, uint8_t* dst, int dst_width,
+                int dst_height);
+
+private:
+    std::vector<uint16_t> sums_;       // Row of sums of up to 257 rows
+    std::vector<uint32_t> wide_sums_;  // Row of sums of more rows
+    std::vector<int> x_edges_;         // First source column of each block, and the width
+};
@@ -0,0 +1,54 @@
+#include "dither.hpp"
+
+namespace {
+
+const int BAYER[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+// Order of the temporal phases, the 2x2 Bayer matrix
+const int PHASES[4] = {0, 2, 3, 1};
+
+}  // namespace
+
+void Dither::apply(const LevelMap& map, const uint8_t* pixels, int width, int height, uint8_t* out) {
+    // Threshold of each cell in 1/128 of the step between two levels: the middle
+    // of one of 64 steps with the phase of this frame, of one of 16 without
+    int threshold[16];
+    for (int cell = 0; cell < 16; cell++) {
+        int bayer = BAYER[cell / 4][cell % 4];
+        threshold[cell] = temporal_ ? bayer * 8 + PHASES[frame_ % 4] * 2 + 1 : bayer * 8 + 4;
+    }
+    for (int k = 0; k < 3; k++) {
+        const std::vector<uint8_t>& levels = map.levels[k];
+        size_t above = 0;
+        for (int v = 0; v < 256; v++) {
+            while (above < levels.size() && levels[above] <= v) {
+                above++;
+            }
+            // Below the first level or above the last one there is nothing to
+            // dither: the value keeps its lookup, which need not be the nearest
+            // level (the fixed split sends the values above its top level to 0)
+            int lo = levels[above ? above - 1 : 0];
+            int hi = above < levels.size() && above ? levels[above] : lo;
+            for (int cell = 0; cell < 16; cell++) {
+                bool up = (v - lo) * 128 >= threshold[cell] * (hi - lo);
+                tables_[(cell * 3 + k) * 256 + v] = hi > lo ? map.drive[k][up ? hi : lo] : map.lut[k][v];
+            }
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = &tables_[(y % 4) * 4 * 3 * 256];
+        for (int x = 0; x < width; x++, pixels += 3, out += 3) {
+            const uint8_t* table = row + (x % 4) * 3 * 256;
+            out[0] = table[pixels[0]];
+            out[1] = table[256 + pixels[1]];
+            out[2] = table[512 + pixels[2]];
+        }
+    }
+    frame_++;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "levels.hpp"
+
+// Ordered dithering between the levels of a LevelMap, in place of its plain
+// lookup: each value goes to the level below or above it depending on its
+// position between the two and on a 4x4 Bayer threshold. With temporal, the
+// thresholds also step through 4 phases on successive frames (frame rate
+// control), so at 10 frames/s the eye averages 64 steps between two levels
+// instead of 16. A pixel only changes level between frames when its value is
+// close to its threshold, the flat areas do not flicker. The levels go out
+// through the drive tables of the map, as with its lookup.
+class Dither {
+public:
+    explicit Dither(bool temporal = true) : temporal_(temporal) {}
+
+    // Quantizes the next frame, width * height pixels of 3 channels row by row, into out
+    void apply(const LevelMap& map, const uint8_t* pixels, int width, int height, uint8_t* out);
+
+    // Back to the first phase (scene change)
+    void reset() { frame_ = 0; }
+
+    uint32_t frame() const { return frame_; }
+
+private:
+    bool temporal_;
+    uint32_t frame_ = 0;
+    // Output of every value of every channel, for each of the 16 cells of the Bayer matrix
+    std::vector<uint8_t> tables_ = std::vector<uint8_t>(16 * 3 * 256);
+};
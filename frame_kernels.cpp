@@ -0,0 +1,38 @@
+#include "frame_kernels.hpp"
+
+namespace {
+
+template <typename Geometry>
+bool is(int width, int height) {
+    return width == Geometry().width() && height == Geometry().height();
+}
+
+}  // namespace
+
+void quantize_rgb(const LevelMap& map, const uint8_t* bgr, int width, int height, size_t stride, uint8_t* rgb) {
+    if (is<ProjectorGeometry>(width, height)) {
+        quantize_rgb(ProjectorGeometry(), map, bgr, stride, rgb);
+    } else if (is<HalfProjectorGeometry>(width, height)) {
+        quantize_rgb(HalfProjectorGeometry(), map, bgr, stride, rgb);
+    } else {
+        quantize_rgb(FrameGeometry<>(width, height), map, bgr, stride, rgb);
+    }
+}
+
+void reorder_rgb(const uint8_t* bgr, int width, int height, size_t stride, uint8_t* rgb) {
+    if (is<ProjectorGeometry>(width, height)) {
+        reorder_rgb(ProjectorGeometry(), bgr, stride, rgb);
+    } else if (is<HalfProjectorGeometry>(width, height)) {
+        reorder_rgb(HalfProjectorGeometry(), bgr, stride, rgb);
+    } else {
+        reorder_rgb(FrameGeometry<>(width, height), bgr, stride, rgb);
+    }
+}
+
+void scale_nearest(const uint8_t* pixels, int width, int height, uint8_t* out, int out_width, int out_height) {
+    if (is<HalfProjectorGeometry>(width, height) && is<ProjectorGeometry>(out_width, out_height)) {
+        scale_nearest(HalfProjectorGeometry(), pixels, ProjectorGeometry(), out);
+    } else {
+        scale_nearest(FrameGeometry<>(width, height), pixels, FrameGeometry<>(out_width, out_height), out);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_format.h"
+#include "levels.hpp"
+
+// Per frame loops of the host from the resized frame (B G R, as read by
+// OpenCV) to the R G B lines sent to the projector, written once over a
+// FrameGeometry. FrameGeometry<W, H> has its bounds known at compile time, so
+// the loops are unrolled and the offsets folded; FrameGeometry<> takes them at
+// run time. The functions below the templates pick the geometry of the rig
+// (frame_format.h) or its half (low resolution of the QoS governor) when the
+// frame has it, the generic loops otherwise.
+//
+// The packing into bus words (bus_pack.h) is already written over the
+// constants of frame_format.h.
+
+// width x height pixels of C channels, 0 for a bound known at run time
+template <int W = 0, int H = 0, int C = 3>
+struct FrameGeometry {
+    static_assert(W >= 0 && H >= 0, "negative frame size");
+    static_assert(C == 3, "frames are 3 colours");
+
+    FrameGeometry(int runtime_width = W, int runtime_height = H) : width_(runtime_width), height_(runtime_height) {}
+
+    int width() const { return W > 0 ? W : width_; }
+    int height() const { return H > 0 ? H : height_; }
+    static constexpr int channels() { return C; }
+    size_t bytes() const { return size_t(width()) * height() * C; }
+
+private:
+    int width_;
+    int height_;
+};
+
+// Geometry of the projector, and its half
+typedef FrameGeometry<PIXELS_PER_LINE, LINES_PER_FRAME> ProjectorGeometry;
+typedef FrameGeometry<(PIXELS_PER_LINE + 1) / 2, (LINES_PER_FRAME + 1) / 2> HalfProjectorGeometry;
+
+// Levels of map looked up for the B G R pixels of bgr (rows stride bytes
+// apart), written R G B with no gap between the rows
+template <int W, int H, int C>
+void quantize_rgb(const FrameGeometry<W, H, C>& geometry, const LevelMap& map, const uint8_t* bgr, size_t stride,
+                  uint8_t* rgb) {
+    const uint8_t* blue = map.lut[0].data();
+    const uint8_t* green = map.lut[1].data();
+    const uint8_t* red = map.lut[2].data();
+    for (int y = 0; y < geometry.height(); y++) {
+        const uint8_t* in = bgr + y * stride;
+        uint8_t* out = rgb + size_t(y) * geometry.width() * C;
+        for (int x = 0; x < geometry.width(); x++) {
+            out[x * C] = red[in[x * C + 2]];
+            out[x * C + 1] = green[in[x * C + 1]];
+            out[x * C + 2] = blue[in[x * C]];
+        }
+    }
+}
+
+// B G R pixels (rows stride bytes apart) to R G B with no gap between the rows
+template <int W, int H, int C>
+void reorder_rgb(const FrameGeometry<W, H, C>& geometry, const uint8_t* bgr, size_t stride, uint8_t* rgb) {
+    for (int y = 0; y < geometry.height(); y++) {
+        const uint8_t* in = bgr + y * stride;
+        uint8_t* out = rgb + size_t(y) * geometry.width() * C;
+        for (int x = 0; x < geometry.width(); x++) {
+            out[x * C] = in[x * C + 2];
+            out[x * C + 1] = in[x * C + 1];
+            out[x * C + 2] = in[x * C];
+        }
+    }
+}
+
+// Nearest neighbour scaling of packed pixels from one geometry to the other
+template <int W, int H, int C, int W2, int H2>
+void scale_nearest(const FrameGeometry<W, H, C>& from, const uint8_t* pixels, const FrameGeometry<W2, H2, C>& to,
+                   uint8_t* out) {
+    for (int y = 0; y < to.height(); y++) {
+        const uint8_t* in = pixels + size_t(y * from.height() / to.height()) * from.width() * C;
+        for (int x = 0; x < to.width(); x++) {
+            const uint8_t* pixel = in + (x * from.width() / to.width()) * C;
+            for (int c = 0; c < C; c++) {
+                *out++ = pixel[c];
+            }
+        }
+    }
+}
+
+// The same on width x height frames, specialised for the geometries above
+void quantize_rgb(const LevelMap& map, const uint8_t* bgr, int width, int height, size_t stride, uint8_t* rgb);
+void reorder_rgb(const uint8_t* bgr, int width, int height, size_t stride, uint8_t* rgb);
+void scale_nearest(const uint8_t* pixels, int width, int height, uint8_t* out, int out_width, int out_height);
@@ -0,0 +1,244 @@
+#include "frame_link.hpp"
+#include "frame_proto.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+static void write_sysfs(const std::string& path, const std::string& value) {
+    std::ofstream file(path);
+    if (!(file << value << std::flush)) {
+        throw std::runtime_error("Could not write " + value + " to " + path);
+    }
+}
+
+// Value file of a host GPIO as an input whose rising edges wake poll()
+static int open_gpio_input(int gpio) {
+    std::string dir = "/sys/class/gpio/gpio" + std::to_string(gpio);
+    if (access(dir.c_str(), F_OK) != 0) {
+        write_sysfs("/sys/class/gpio/export", std::to_string(gpio));
+    }
+    write_sysfs(dir + "/direction", "in");
+    write_sysfs(dir + "/edge", "rising");
+    int fd = open((dir + "/value").c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open handshake GPIO " + std::to_string(gpio) + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+FrameLink::FrameLink(const std::string& device, int spi_speed_hz) {
+    if (device.empty()) {
+        throw std::logic_error("Link device cannot be empty");
+    }
+    if (!bus_map_init(&bus_map_)) {
+        throw std::logic_error("Data or select pin missing from PIN_MAP_BUS");
+    }
+    bool spi = device.find("spidev") != std::string::npos;
+    size_t at = spi ? device.rfind('@') : std::string::npos;
+    std::string path = device.substr(0, at);
+    fd_ = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open link device " + path + ": " + std::strerror(errno));
+    }
+
+    if (spi) {
+        uint8_t mode = SPI_MODE_0;
+        uint32_t speed = spi_speed_hz;
+        if (ioctl(fd_, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(fd_, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+            close(fd_);
+            throw std::runtime_error("Could not configure SPI device " + path);
+        }
+        try {
+            handshake_fd_ = open_gpio_input(at == std::string::npos ? DEFAULT_HANDSHAKE_GPIO
+                                                                    : std::stoi(device.substr(at + 1)));
+        } catch (...) {
+            close(fd_);
+            throw;
+        }
+    } else if (isatty(fd_)) {
+        // Raw byte stream, no line discipline on the way
+        termios tio;
+        if (tcgetattr(fd_, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(fd_, TCSANOW, &tio);
+        }
+    }
+}
+
+FrameLink::~FrameLink() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    if (handshake_fd_ >= 0) {
+        close(handshake_fd_);
+    }
+}
+
+void FrameLink::wait_handshake() {
+    // The line may still be high from the last transaction: after one, only a
+    // new rising edge means that the slave queued the next. poll() reports the
+    // edges since the value was last read.
+    bool edge = !handshake_used_;
+    for (;;) {
+        if (!edge) {
+            pollfd gpio = {handshake_fd_, POLLPRI | POLLERR, 0};
+            int n = poll(&gpio, 1, HANDSHAKE_TIMEOUT_MS);
+            if (n == 0) {
+                throw std::runtime_error("Projector did not raise its handshake line");
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Handshake GPIO poll failed: ") + std::strerror(errno));
+            }
+        }
+        char value = '0';
+        if (lseek(handshake_fd_, 0, SEEK_SET) < 0 || read(handshake_fd_, &value, 1) != 1) {
+            throw std::runtime_error(std::string("Handshake GPIO read failed: ") + std::strerror(errno));
+        }
+        if (value == '1') {
+            handshake_used_ = true;
+            return;
+        }
+        edge = false;
+    }
+}
+
+void FrameLink::write_all(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Link write failed: ") + std::strerror(errno));
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+void FrameLink::send_packet(uint8_t type, uint16_t line, const uint8_t* payload, uint16_t len) {
+    frame_proto_header_t header = {};
+    header.type = type;
+    header.frame_seq = frame_seq_;
+    header.line = line;
+    header.payload_len = len;
+    header.payload_crc = len ? frame_proto_crc32(0, payload, len) : 0;
+
+    uint8_t buf[FRAME_PROTO_HEADER_SIZE];
+    frame_proto_encode_header(&header, buf);
+    // On spidev every write() is one chip select cycle: header and payload are two
+    // transactions so the slave can DMA the payload to its final position. Each
+    // waits for the slave to queue its receive, or it would be clocked into nothing.
+    if (handshake_fd_ >= 0) {
+        wait_handshake();
+    }
+    write_all(buf, sizeof(buf));
+    if (len) {
+        if (handshake_fd_ >= 0) {
+            wait_handshake();
+        }
+        write_all(payload, len);
+    }
+}
+
+void FrameLink::send_frame(const std::vector<uint8_t>& rgb) {
+    send_frame_lines(rgb);
+    end_frame();
+}
+
+void FrameLink::send_frame_lines(const std::vector<uint8_t>& rgb) {
+    const size_t rgb_line = PIXELS_PER_LINE * BYTES_PER_PIXEL;
+    if (rgb.size() != LINES_PER_FRAME * rgb_line) {
+        throw std::logic_error("Frame size does not match the projector geometry");
+    }
+#if FRAME_PALETTE
+    scene_.index(rgb.data(), LINES_PER_FRAME * PIXELS_PER_LINE, indices_);
+    send_indexed_lines(scene_.palette(), indices_);
+#else
+    uint16_t phases[PHASES_PER_LINE];
+    uint8_t payload[FRAME_PROTO_LINE_SIZE];
+    for (uint16_t line = 0; line < LINES_PER_FRAME; line++) {
+        bus_pack_phases(&bus_map_, reinterpret_cast<const uint8_t(*)[BYTES_PER_PIXEL]>(rgb.data() + line * rgb_line),
+                        phases);
+        for (int i = 0; i < PHASES_PER_LINE; i++) {
+            payload[2 * i] = static_cast<uint8_t>(phases[i]);
+            payload[2 * i + 1] = static_cast<uint8_t>(phases[i] >> 8);
+        }
+        send_packet(FRAME_PROTO_LINE, line, payload, FRAME_PROTO_LINE_SIZE);
+    }
+#endif
+}
+
+void FrameLink::end_frame() {
+#if FRAME_PALETTE
+    // The receiver only publishes the frame if it holds this palette
+    send_packet(FRAME_PROTO_END, palette_id_, nullptr, 0);
+#else
+    send_packet(FRAME_PROTO_END, 0, nullptr, 0);
+#endif
+    frame_seq_++;
+}
+
+void FrameLink::scene_cut() {
+#if FRAME_PALETTE
+    scene_.reset();
+#endif
+}
+
+#if FRAME_PALETTE
+void FrameLink::send_indexed_frame(const std::vector<Rgb>& palette, const std::vector<uint8_t>& indices) {
+    send_indexed_lines(palette, indices);
+    end_frame();
+}
+
+void FrameLink::send_indexed_lines(const std::vector<Rgb>& palette, const std::vector<uint8_t>& indices) {
+    if (palette.empty() || palette.size() > PALETTE_SIZE) {
+        throw std::logic_error("Palette must have 1 to PALETTE_SIZE colours");
+    }
+    if (indices.size() != LINES_PER_FRAME * PIXELS_PER_LINE) {
+        throw std::logic_error("Frame size does not match the projector geometry");
+    }
+    bool changed = palette != sent_palette_;
+    if (changed || ++frames_since_palette_ >= PALETTE_RESEND_FRAMES) {
+        if (changed) {
+            palette_id_++;
+            sent_palette_ = palette;
+        }
+        // Unused entries stay black
+        uint8_t colors[PALETTE_SIZE][BYTES_PER_PIXEL] = {};
+        for (size_t i = 0; i < palette.size(); i++) {
+            std::copy(palette[i].begin(), palette[i].end(), colors[i]);
+        }
+        uint16_t phases[PALETTE_SIZE][BYTES_PER_PIXEL];
+        bus_pack_colors(&bus_map_, colors, PALETTE_SIZE, phases);
+        uint8_t payload[FRAME_PROTO_PALETTE_SIZE];
+        for (size_t i = 0; i < PALETTE_SIZE * BYTES_PER_PIXEL; i++) {
+            payload[2 * i] = static_cast<uint8_t>(phases[i / BYTES_PER_PIXEL][i % BYTES_PER_PIXEL]);
+            payload[2 * i + 1] = static_cast<uint8_t>(phases[i / BYTES_PER_PIXEL][i % BYTES_PER_PIXEL] >> 8);
+        }
+        send_packet(FRAME_PROTO_PALETTE, palette_id_, payload, FRAME_PROTO_PALETTE_SIZE);
+        frames_since_palette_ = 0;
+    }
+    for (uint16_t line = 0; line < LINES_PER_FRAME; line++) {
+        for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+            if (indices[line * PIXELS_PER_LINE + pixel] >= palette.size()) {
+                throw std::logic_error("Palette index out of the palette");
+            }
+        }
+        send_packet(FRAME_PROTO_LINE, line, &indices[line * PIXELS_PER_LINE], FRAME_PROTO_LINE_SIZE);
+    }
+}
+#endif
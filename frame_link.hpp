@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bus_pack.h"
+#include "palette.hpp"
+
+// Sends frames to the projector over the framed protocol of Video-proj/main/frame_proto.h.
+// The device is either a serial port / pty (byte stream) or a spidev node (one SPI
+// transaction per packet, the ESP32 is the SPI slave and raises its handshake
+// line while it is ready for the next transaction).
+// On spidev the handshake line (LINK_PIN_HANDSHAKE of frame_link.h) goes to a
+// host GPIO, read through sysfs: DEFAULT_HANDSHAKE_GPIO, or the one given after
+// the device as in "/dev/spidev0.1@24". Every transaction waits for it.
+class FrameLink {
+public:
+    static const int DEFAULT_HANDSHAKE_GPIO = 25;
+    static const int HANDSHAKE_TIMEOUT_MS = 1000;
+
+    explicit FrameLink(const std::string& device, int spi_speed_hz = 10000000);
+    ~FrameLink();
+
+    FrameLink(const FrameLink&) = delete;
+    FrameLink& operator=(const FrameLink&) = delete;
+
+    // rgb: LINES_PER_FRAME * PIXELS_PER_LINE * 3 bytes, line by line, in R G B order.
+    // Sent as the bus words of the projector pins (pin_map.h), ready for its scan-out,
+    // or with FRAME_PALETTE as indices into the palette of the scene.
+    void send_frame(const std::vector<uint8_t>& rgb);
+
+    // send_frame in two steps: the lines, then the END packet on which the
+    // projector publishes the frame. Links to several projectors send their
+    // lines first and their END packets together (sharded_link.hpp).
+    void send_frame_lines(const std::vector<uint8_t>& rgb);
+    void end_frame();
+
+    // The next frame starts a new scene: with FRAME_PALETTE its palette is rebuilt
+    // instead of waiting for a frame that does not fit the current one
+    void scene_cut();
+
+#if FRAME_PALETTE
+    // indices: one per pixel, line by line, into palette (at most PALETTE_SIZE colours).
+    // The palette goes out when it changes, and every PALETTE_RESEND_FRAMES frames.
+    void send_indexed_frame(const std::vector<Rgb>& palette, const std::vector<uint8_t>& indices);
+
+    const ScenePalette& scene_palette() const { return scene_; }
+#endif
+
+    uint16_t frame_seq() const { return frame_seq_; }
+    // Sequence number of the next frame, shared by the links of one show
+    void set_frame_seq(uint16_t frame_seq) { frame_seq_ = frame_seq; }
+
+private:
+#if FRAME_PALETTE
+    void send_indexed_lines(const std::vector<Rgb>& palette, const std::vector<uint8_t>& indices);
+#endif
+    void send_packet(uint8_t type, uint16_t line, const uint8_t* payload, uint16_t len);
+    void write_all(const uint8_t* data, size_t len);
+    // Until the slave has queued the receive of the next transaction
+    void wait_handshake();
+
+    bus_map_t bus_map_;
+    int fd_ = -1;
+    int handshake_fd_ = -1;  // Value of the handshake GPIO, -1 off spidev
+    bool handshake_used_ = false;  // A transaction went out on the current level
+    uint16_t frame_seq_ = 0;
+#if FRAME_PALETTE
+    static const int PALETTE_RESEND_FRAMES = 10;
+
+    ScenePalette scene_;
+    std::vector<uint8_t> indices_;
+    std::vector<Rgb> sent_palette_;
+    uint16_t palette_id_ = 0;
+    int frames_since_palette_ = 0;
+#endif
+};
@@ -0,0 +1,141 @@
+#include "laser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* const COLOUR_NAMES[3] = {"red", "green", "blue"};
+
+// Squared error of the curve (black, gamma) on readings normalised to 1 at drive top
+double curve_error(const std::vector<LaserReading>& readings, int top, int black, double gamma) {
+    double error = 0;
+    for (const LaserReading& r : readings) {
+        double model = r.drive > black ? std::pow(double(r.drive - black) / (top - black), gamma) : 0.0;
+        error += (r.light - model) * (r.light - model);
+    }
+    return error;
+}
+
+}  // namespace
+
+LaserCurve LaserCurve::fit(std::vector<LaserReading> readings, double max_power) {
+    if (readings.size() < 3) {
+        throw std::runtime_error("At least 3 readings per colour are needed");
+    }
+    std::sort(readings.begin(), readings.end(),
+              [](const LaserReading& a, const LaserReading& b) { return a.drive < b.drive; });
+    // Ambient light off the readings, then relative to the light at the highest drive
+    double ambient = readings.front().light;
+    for (const LaserReading& r : readings) {
+        ambient = std::min(ambient, r.light);
+    }
+    int top = readings.back().drive;
+    double full = readings.back().light - ambient;
+    if (full <= 0) {
+        throw std::runtime_error("No light at the highest drive value");
+    }
+    for (LaserReading& r : readings) {
+        r.light = (r.light - ambient) / full;
+    }
+
+    // For each black value, gamma from the slope of log(light) over log(drive above black),
+    // keeping the pair that fits the readings best
+    LaserCurve best;
+    double best_error = -1;
+    for (int black = 0; black < top; black++) {
+        double xy = 0;
+        double xx = 0;
+        for (const LaserReading& r : readings) {
+            if (r.drive > black && r.drive < top && r.light > 0.001) {
+                double x = std::log(double(r.drive - black) / (top - black));
+                xy += x * std::log(r.light);
+                xx += x * x;
+            }
+        }
+        if (xx == 0) {
+            continue;
+        }
+        double gamma = xy / xx;
+        if (gamma <= 0) {
+            continue;
+        }
+        double error = curve_error(readings, top, black, gamma);
+        if (best_error < 0 || error < best_error) {
+            best_error = error;
+            best.black = black;
+            best.gamma = gamma;
+        }
+    }
+    if (best_error < 0) {
+        throw std::runtime_error("No light between the lowest and highest drive values");
+    }
+    double cap = best.black + (top - best.black) * std::pow(max_power, 1.0 / best.gamma);
+    best.max = static_cast<int>(std::min(std::floor(cap), 255.0));
+    return best;
+}
+
+LaserProfile LaserProfile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not read laser profile " + path);
+    }
+    LaserProfile profile;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key) || key[0] == '#') {
+            continue;
+        }
+        if (key == "target_gamma") {
+            if (!(in >> profile.target_gamma) || profile.target_gamma <= 0) {
+                throw std::runtime_error("Malformed laser profile line: " + line);
+            }
+            continue;
+        }
+        const char* const* name = std::find(COLOUR_NAMES, COLOUR_NAMES + 3, key);
+        if (name == COLOUR_NAMES + 3) {
+            throw std::runtime_error("Unknown colour in laser profile line: " + line);
+        }
+        LaserCurve& curve = profile.curves[name - COLOUR_NAMES];
+        if (!(in >> curve.gamma >> curve.black >> curve.max) || curve.gamma <= 0 || curve.black < 0 ||
+            curve.max > 255 || curve.black >= curve.max) {
+            throw std::runtime_error("Malformed laser profile line: " + line);
+        }
+    }
+    return profile;
+}
+
+void LaserProfile::save(const std::string& path) const {
+    std::ofstream file(path);
+    file << "# colour gamma black max" << std::endl;
+    for (int c = 0; c < 3; c++) {
+        file << COLOUR_NAMES[c] << " " << curves[c].gamma << " " << curves[c].black << " " << curves[c].max
+             << std::endl;
+    }
+    file << "target_gamma " << target_gamma << std::endl;
+    if (!file) {
+        throw std::runtime_error("Could not write laser profile " + path);
+    }
+}
+
+ChannelTables LaserProfile::drive_tables(bool bgr) const {
+    ChannelTables tables;
+    for (int c = 0; c < 3; c++) {
+        const LaserCurve& curve = curves[c];
+        std::array<uint8_t, 256>& table = tables[bgr ? 2 - c : c];
+        // Light of value v is (v / 255)^target_gamma of the light at max, so the
+        // drive above black grows as (v / 255)^(target_gamma / gamma)
+        double exponent = target_gamma / curve.gamma;
+        table[0] = 0;
+        for (int v = 1; v < 256; v++) {
+            double drive = curve.black + (curve.max - curve.black) * std::pow(v / 255.0, exponent);
+            table[v] = static_cast<uint8_t>(std::min(std::lround(drive), static_cast<long>(curve.max)));
+        }
+    }
+    return tables;
+}
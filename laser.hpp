@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "levels.hpp"
+
+// Light measured at one drive value, in any unit
+struct LaserReading {
+    int drive;
+    double light;
+};
+
+// Response of the laser diode of one colour: no light up to the black drive
+// value, then light growing as ((drive - black) / (255 - black))^gamma.
+// max caps the drive value (power limit).
+struct LaserCurve {
+    double gamma = 1.0;
+    int black = 0;
+    int max = 255;
+
+    // Curve fitted on photodiode readings of the laser, max giving max_power of
+    // the light at the highest drive value read. The lowest reading is taken
+    // as the ambient light.
+    static LaserCurve fit(std::vector<LaserReading> readings, double max_power = 1.0);
+};
+
+// Calibration of the three lasers, read from a profile file:
+//   # comment
+//   red <gamma> <black> <max>
+//   green <gamma> <black> <max>
+//   blue <gamma> <black> <max>
+//   target_gamma <gamma>
+// Frame values are displayed as light (value / 255)^target_gamma of the
+// light at max, like a video display, whatever the response of the diodes.
+// A missing line keeps the defaults: linear diode, full power, target 1.
+class LaserProfile {
+public:
+    static LaserProfile load(const std::string& path);
+    void save(const std::string& path) const;
+
+    // Drive value of every frame value, per channel in B G R order (OpenCV) or R G B
+    ChannelTables drive_tables(bool bgr) const;
+
+    std::array<LaserCurve, 3> curves;  // Red, green, blue
+    double target_gamma = 1.0;
+};
@@ -0,0 +1,130 @@
+#include "levels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Levels of one channel from its (averaged) histogram: each level takes the
+// values up to its share of the pixels not yet in a level, at least one value
+void choose_levels(const std::array<float, 256>& hist, int levels, std::array<uint8_t, 256>& lut,
+                   std::vector<uint8_t>& values) {
+    float total = 0;
+    for (float h : hist) {
+        total += h;
+    }
+    // Below this the remaining pixels are rounding errors of the average
+    const float empty = total * 1e-6f;
+    values.clear();
+    int begin = 0;
+    float below = 0;
+    for (int level = 0; begin < 256; level++) {
+        bool last = level >= levels - 1 || total - below <= empty;
+        float target = below + (total - below) / (levels - level);
+        int end = begin;
+        float mass = 0;
+        float weighted = 0;
+        do {
+            mass += hist[end];
+            weighted += hist[end] * end;
+            end++;
+        } while (end < 256 && (last || below + mass < target));
+        if (total - below - mass <= empty) {
+            end = 256;  // Nothing above, the level takes the rest
+        }
+        int value = mass > 0 ? static_cast<int>(std::lround(weighted / mass)) : begin;
+        value = std::min(std::max(value, begin), end - 1);
+        std::fill(lut.begin() + begin, lut.begin() + end, static_cast<uint8_t>(value));
+        values.push_back(static_cast<uint8_t>(value));
+        below += mass;
+        begin = end;
+    }
+}
+
+}  // namespace
+
+void channel_histogram(const uint8_t* pixels, size_t count, ChannelHistogram& hist) {
+    hist = ChannelHistogram{};
+    for (size_t i = 0; i < count; i++, pixels += 3) {
+        hist[0][pixels[0]]++;
+        hist[1][pixels[1]]++;
+        hist[2][pixels[2]]++;
+    }
+}
+
+ChannelTables identity_tables() {
+    ChannelTables tables;
+    for (int k = 0; k < 3; k++) {
+        for (int v = 0; v < 256; v++) {
+            tables[k][v] = static_cast<uint8_t>(v);
+        }
+    }
+    return tables;
+}
+
+int seuil(int pixel, int plages) {
+    int plage = 256 / plages;
+    int res = 0;
+    for (int i = 0; i < plages; i++) {
+        if (pixel >= i * plage / plages && pixel < (i + 1) * plage / plages) {
+            res = i * plage / plages;
+        }
+    }
+    return res;
+}
+
+LevelMap LevelMap::fixed(int plages) {
+    LevelMap map;
+    for (int k = 0; k < 3; k++) {
+        for (int v = 0; v < 256; v++) {
+            map.lut[k][v] = static_cast<uint8_t>(seuil(v, plages));
+        }
+        std::vector<uint8_t>& levels = map.levels[k];
+        levels.assign(map.lut[k].begin(), map.lut[k].end());
+        std::sort(levels.begin(), levels.end());
+        levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+    }
+    return map;
+}
+
+void LevelMap::calibrate(const ChannelTables& tables) {
+    for (int k = 0; k < 3; k++) {
+        for (int v = 0; v < 256; v++) {
+            lut[k][v] = tables[k][lut[k][v]];
+            drive[k][v] = tables[k][drive[k][v]];
+        }
+    }
+}
+
+void LevelMap::apply(const uint8_t* pixels, size_t count, uint8_t* out) const {
+    for (size_t i = 0; i < count; i++, pixels += 3, out += 3) {
+        out[0] = lut[0][pixels[0]];
+        out[1] = lut[1][pixels[1]];
+        out[2] = lut[2][pixels[2]];
+    }
+}
+
+AdaptiveLevels::AdaptiveLevels(int levels, float smoothing)
+    : levels_(std::max(levels, 1)), smoothing_(std::min(std::max(smoothing, 0.0f), 1.0f)) {
+    for (int k = 0; k < 3; k++) {
+        choose_levels(average_[k], levels_, map_.lut[k], map_.levels[k]);
+    }
+}
+
+const LevelMap& AdaptiveLevels::update(const uint8_t* pixels, size_t count) {
+    ChannelHistogram hist;
+    channel_histogram(pixels, count, hist);
+    // Histograms as shares of the frame, so frames of any size average alike
+    float past = frames_ ? smoothing_ : 0.0f;
+    float scale = count ? (1.0f - past) / count : 0.0f;
+    for (int k = 0; k < 3; k++) {
+        for (int v = 0; v < 256; v++) {
+            average_[k][v] = past * average_[k][v] + scale * hist[k][v];
+        }
+    }
+    frames_++;
+    for (int k = 0; k < 3; k++) {
+        choose_levels(average_[k], levels_, map_.lut[k], map_.levels[k]);
+    }
+    return map_;
+}
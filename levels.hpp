@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quantization levels of the host frames (the `plages` of main.cpp), on pixels
+// of 3 interleaved channels (B G R as read by OpenCV, or R G B: each channel is
+// handled on its own).
+
+// Pixels of each value, per channel
+typedef std::array<std::array<uint32_t, 256>, 3> ChannelHistogram;
+
+// 8 bit value of every 8 bit value, per channel
+typedef std::array<std::array<uint8_t, 256>, 3> ChannelTables;
+
+ChannelTables identity_tables();
+
+// Histogram of count pixels
+void channel_histogram(const uint8_t* pixels, size_t count, ChannelHistogram& hist);
+
+// Fixed split of main.cpp: level of pixel among plages
+int seuil(int pixel, int plages);
+
+// Output value of every input value, per channel
+struct LevelMap {
+    ChannelTables lut;
+    std::array<std::vector<uint8_t>, 3> levels;  // Distinct level values, ascending
+    ChannelTables drive = identity_tables();     // Output value of each level value
+
+    // seuil(value, plages) for every value
+    static LevelMap fixed(int plages);
+
+    // Output values passed through tables (laser calibration), composed into lut
+    // so that it costs no lookup per pixel
+    void calibrate(const ChannelTables& tables);
+
+    void apply(const uint8_t* pixels, size_t count, uint8_t* out) const;
+};
+
+// Levels chosen on each frame from its histogram: the boundaries split the
+// pixels of each channel into equal parts, each level outputs the mean of its
+// pixels, so a dark or washed-out frame keeps all its levels. The histograms
+// are averaged over the previous frames (smoothing: weight of the past, 0 for
+// none) so the levels do not flicker from one frame to the next.
+class AdaptiveLevels {
+public:
+    explicit AdaptiveLevels(int levels, float smoothing = 0.75f);
+
+    // Map of the frame, count pixels of the resized frame
+    const LevelMap& update(const uint8_t* pixels, size_t count);
+
+    // Forget the past frames (scene change)
+    void reset() { frames_ = 0; }
+
+    // Levels of the next frames
+    void set_levels(int levels) { levels_ = levels > 1 ? levels : 1; }
+
+    const LevelMap& map() const { return map_; }  // Of the last frame, a single level before the first
+
+private:
+    int levels_;
+    float smoothing_;
+    uint32_t frames_ = 0;
+    std::array<std::array<float, 256>, 3> average_ = {};
+    LevelMap map_;
+};
@@ -1,8 +1,27 @@
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
+#include "area_resize.hpp"
+#include "dither.hpp"
+#include "frame_kernels.hpp"
+#include "frame_link.hpp"
+#include "laser.hpp"
+#include "prefetch.hpp"
+#include "levels.hpp"
+#include "playlist.hpp"
+#include "qos.hpp"
+#include "scene_detect.hpp"
+#include "sharded_link.hpp"
+
+// An unchanged frame is still sent after this many, for a receiver that lost the last one
+static const uint32_t REPEAT_RESEND_FRAMES = 10;
+
 // Load an image from file
 cv::Mat load_image(const std::string& name) {
     // Check if the name is empty
@@ -21,61 +40,410 @@ cv::Mat load_image(const std::string& name) {
     return image;
 }
 
-int seuil(int pixel, int plages) {
-    int plage = 256 / plages;
-    int res = 0;
-    for (int i = 0; i < plages; i++) {
-        if (pixel >= i * plage / plages && pixel < (i + 1) * plage / plages) {
-            res = i * plage / plages;
-        }
+//redimensionne l'image
+// box: area downscaler to use in place of cv::resize with interpolation, for
+// 8 bit colour images made smaller
+cv::Mat resize_image(cv::Mat image, int width, int height, int interpolation = cv::INTER_LINEAR,
+                     AreaDownscaler* box = nullptr) {
+    cv::Mat resized_image;
+    if (box && image.type() == CV_8UC3 && width <= image.cols && height <= image.rows) {
+        resized_image.create(height, width, CV_8UC3);
+        box->resize(image.ptr(), image.cols, image.rows, image.step, resized_image.ptr(), width, height);
+        return resized_image;
     }
-    return res;
+    cv::resize(image, resized_image, cv::Size(width, height), 0, 0, interpolation);
+    return resized_image;
 }
 
-std::vector<std::vector<std::vector<int>>> split_image_to_vector(const cv::Mat& image, int plage) {
-    std::vector<std::vector<std::vector<int>>> channels(image.rows, std::vector<std::vector<int>>(image.cols, std::vector<int>(image.channels())));
-    for (int i = 0; i < image.rows; i++) {
-        for (int j = 0; j < image.cols; j++) {
-            for (int k = 0; k < image.channels(); k++) {
-                int res = seuil(image.at<cv::Vec3b>(i, j)[k], plage);
-                channels[i][j][k] = res;
-            }
-        }
+// Quantization of the frames, from the options of the command line
+struct Quantization {
+    int plages = 0;
+    std::unique_ptr<AdaptiveLevels> levels;  // --adaptive, null for the fixed split
+    std::unique_ptr<Dither> dither;          // --dither, null for none
+    std::unique_ptr<ChannelTables> drive;    // --laser, null for values sent as they are
+};
+
+// qos: what the load of the host leaves of the quantization. Returns the R G B
+// lines for the projector, scaled up to columns x rows by the nearest pixel if
+// the frame was resized smaller
+std::vector<uint8_t> process(const cv::Mat& imgResized, Quantization& quantization, const QosGovernor& qos,
+                             int columns, int rows) {
+    int plages = qos.plages(quantization.plages);
+    Dither* dither = qos.dither() ? quantization.dither.get() : nullptr;
+    if (quantization.levels) {
+        quantization.levels->set_levels(plages);
+    }
+    LevelMap map = quantization.levels ? quantization.levels->update(imgResized.ptr(), imgResized.total())
+                                       : LevelMap::fixed(plages);
+    if (quantization.drive) {
+        map.calibrate(*quantization.drive);
+    }
+    std::vector<uint8_t> rgb(imgResized.total() * 3);
+    if (dither) {
+        cv::Mat quantized(imgResized.size(), imgResized.type());
+        dither->apply(map, imgResized.ptr(), imgResized.cols, imgResized.rows, quantized.ptr());
+        reorder_rgb(quantized.ptr(), quantized.cols, quantized.rows, quantized.step, rgb.data());
+    } else {
+        quantize_rgb(map, imgResized.ptr(), imgResized.cols, imgResized.rows, imgResized.step, rgb.data());
+    }
+    if (imgResized.cols == columns && imgResized.rows == rows) {
+        return rgb;
     }
-    return channels;
+    std::vector<uint8_t> scaled(size_t(columns) * rows * 3);
+    scale_nearest(rgb.data(), imgResized.cols, imgResized.rows, scaled.data(), columns, rows);
+    return scaled;
 }
 
-//redimensionne l'image
-cv::Mat resize_image(cv::Mat image, int width, int height) {
-    cv::Mat resized_image;
-    cv::resize(image, resized_image, cv::Size(width, height));
-    return resized_image;
-}
+// Frames of the video file resized for the projector, decoded ahead by FramePrefetcher
+class VideoSource : public FrameSource {
+public:
+    VideoSource(const std::string& path, int columns, int rows, int interpolation, bool box)
+        : video_(path), columns_(columns), rows_(rows), interpolation_(interpolation),
+          box_(box ? std::make_unique<AreaDownscaler>() : nullptr) {
+        if (!video_.isOpened()) {
+            throw std::runtime_error("Could not open video file");
+        }
+    }
+
+    // The FFmpeg backend of OpenCV seeks to the keyframe before and decodes up to frame
+    bool seek(uint32_t frame) override { return video_.set(cv::CAP_PROP_POS_FRAMES, frame); }
+
+    bool read(PrefetchedFrame& out) override {
+        out.index = static_cast<uint32_t>(video_.get(cv::CAP_PROP_POS_FRAMES));
+        video_ >> frame_;
+        if (frame_.empty()) {
+            return false;
+        }
+        cv::Mat resized = resize_image(frame_, columns_, rows_, interpolation_, box_.get());
+        out.pixels.assign(resized.ptr(), resized.ptr() + resized.total() * resized.elemSize());
+        return true;
+    }
+
+private:
+    cv::VideoCapture video_;
+    cv::Mat frame_;
+    int columns_;
+    int rows_;
+    int interpolation_;
+    std::unique_ptr<AreaDownscaler> box_;
+};
+
+// Still of image/ resized for the projector, the same frame for as long as it is shown
+class ImageSource : public FrameSource {
+public:
+    ImageSource(const std::string& name, int columns, int rows, int interpolation, bool box) {
+        cv::Mat image = load_image(name);
+        if (image.empty()) {
+            throw std::runtime_error("Could not open image " + name);
+        }
+        AreaDownscaler downscaler;
+        cv::Mat resized = resize_image(image, columns, rows, interpolation, box ? &downscaler : nullptr);
+        pixels_.assign(resized.ptr(), resized.ptr() + resized.total() * resized.elemSize());
+    }
+
+    bool seek(uint32_t frame) override {
+        position_ = frame;
+        return true;
+    }
+
+    bool read(PrefetchedFrame& out) override {
+        out.index = position_++;
+        out.pixels = pixels_;
+        return true;
+    }
+
+private:
+    std::vector<uint8_t> pixels_;
+    uint32_t position_ = 0;
+};
 
-std::vector<std::vector<std::vector<int>>> process(cv::Mat frame, char** argv) {
-    cv::Mat img = frame;
-    int height = std::stoi(argv[2]);
-    int width = std::stoi(argv[3]);
-    cv::Mat imgResized = resize_image(img, height, width);
-    return split_image_to_vector(imgResized, std::stoi(argv[4]));
+// Devices of a comma separated list
+std::vector<std::string> device_list(const std::string& list) {
+    std::vector<std::string> devices;
+    std::stringstream in(list);
+    std::string device;
+    while (std::getline(in, device, ',')) {
+        devices.push_back(device);
+    }
+    return devices;
 }
 
 int main(int argc, char** argv) {
-    cv::VideoCapture video("../Video/Video.mp4");
-    if (!video.isOpened()) {
-        throw std::runtime_error("Could not open video file");
+    // --adaptive: argv[4] levels per colour chosen on each frame instead of the fixed split
+    // --dither: ordered and temporal dithering between the levels
+    // --laser <profile>: laser calibration of laser.hpp applied to the levels
+    // --resize <linear|area|box>: cv::resize bilinear (default) or INTER_AREA,
+    // or the area downscaler of area_resize.hpp
+    // --shard-lines <dev,dev,...>: one controller per band of LINES_PER_FRAME
+    // lines, argv[3] lines in all, in place of the link of argv[5]
+    // --shard-colours <red,green,blue>: one controller per laser
+    // --prefetch <frames>: frames decoded and resized ahead on another thread
+    // --cues <frame,frame,...>: keys 1 to 9 jump to these frames (prefetched)
+    // --loop: back to the first frame at the end of the video (prefetched),
+    // or to the first item of the playlist
+    // --playlist <file>: the items of playlist.hpp one after the other, in
+    // place of Video.mp4
+    // --prepare-mb <MB>: memory of the frames of the next item prepared ahead
+    Quantization quantization;
+    size_t prefetch_depth = 0;
+    std::vector<uint32_t> cues;
+    bool loop = false;
+    std::string playlist_path;
+    double prepare_mb = 16;
+    std::unique_ptr<ShardedLink> shards;
+    int interpolation = cv::INTER_LINEAR;
+    std::unique_ptr<AreaDownscaler> box;
+    bool adaptive = false;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        if (std::string(argv[i]) == "--adaptive") {
+            adaptive = true;
+        } else if (std::string(argv[i]) == "--dither") {
+            quantization.dither = std::make_unique<Dither>();
+        } else if (std::string(argv[i]) == "--laser" && i + 1 < argc) {
+            quantization.drive = std::make_unique<ChannelTables>(LaserProfile::load(argv[++i]).drive_tables(true));
+        } else if (std::string(argv[i]) == "--resize" && i + 1 < argc) {
+            std::string backend = argv[++i];
+            if (backend == "area") {
+                interpolation = cv::INTER_AREA;
+            } else if (backend == "box") {
+                box = std::make_unique<AreaDownscaler>();
+            } else if (backend != "linear") {
+                throw std::runtime_error("Unknown resize backend " + backend);
+            }
+        } else if (std::string(argv[i]) == "--prefetch" && i + 1 < argc) {
+            prefetch_depth = std::stoul(argv[++i]);
+        } else if (std::string(argv[i]) == "--cues" && i + 1 < argc) {
+            for (const std::string& cue : device_list(argv[++i])) {
+                cues.push_back(static_cast<uint32_t>(std::stoul(cue)));
+            }
+        } else if (std::string(argv[i]) == "--loop") {
+            loop = true;
+        } else if (std::string(argv[i]) == "--playlist" && i + 1 < argc) {
+            playlist_path = argv[++i];
+        } else if (std::string(argv[i]) == "--prepare-mb" && i + 1 < argc) {
+            prepare_mb = std::stod(argv[++i]);
+        } else if (std::string(argv[i]) == "--shard-lines" && i + 1 < argc) {
+            shards = std::make_unique<ShardedLink>(device_list(argv[++i]), ShardedLink::LINE_BANDS);
+        } else if (std::string(argv[i]) == "--shard-colours" && i + 1 < argc) {
+            shards = std::make_unique<ShardedLink>(device_list(argv[++i]), ShardedLink::COLOURS);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = static_cast<int>(args.size());
+    argv = args.data();
+    quantization.plages = std::stoi(argv[4]);
+    if (adaptive) {
+        quantization.levels = std::make_unique<AdaptiveLevels>(quantization.plages);
+    }
+    const std::string video_path = "../Video/Video.mp4";
+    cv::VideoCapture video;
+    if (playlist_path.empty()) {
+        video.open(video_path);
+        if (!video.isOpened()) {
+            throw std::runtime_error("Could not open video file");
+        }
+    }
+    // Optional link to the projector: serial port, pty or spidev node
+    std::unique_ptr<FrameLink> link;
+    if (argc > 5 && !shards) {
+        link = std::make_unique<FrameLink>(argv[5]);
     }
+    int columns = std::stoi(argv[2]);
+    int rows = std::stoi(argv[3]);
+    bool area = box != nullptr;
+    std::unique_ptr<FramePrefetcher> prefetcher;
+    std::unique_ptr<PlaylistPlayer> playlist;
+    if (!playlist_path.empty()) {
+        if (!cues.empty()) {
+            throw std::runtime_error("Cues are not supported with a playlist");
+        }
+        // Items take the frame rate of their clip, 10 frames/s for 5 s for a
+        // still, and the levels and size of the command line
+        std::vector<PlaylistItem> items = load_playlist(playlist_path);
+        for (PlaylistItem& item : items) {
+            if (item.fps <= 0) {
+                item.fps = item.still ? 0 : cv::VideoCapture("../Video/" + item.name).get(cv::CAP_PROP_FPS);
+                item.fps = item.fps > 0 ? item.fps : 10;
+            }
+            if (item.still && item.seconds <= 0) {
+                item.seconds = 5;
+            }
+            item.plages = item.plages > 0 ? item.plages : quantization.plages;
+            item.columns = item.columns > 0 ? item.columns : columns;
+            item.rows = item.rows > 0 ? item.rows : rows;
+        }
+        playlist = std::make_unique<PlaylistPlayer>(
+            std::move(items),
+            [=](const PlaylistItem& item) -> std::unique_ptr<FrameSource> {
+                if (item.still) {
+                    return std::make_unique<ImageSource>(item.name, item.columns, item.rows, interpolation, area);
+                }
+                return std::make_unique<VideoSource>("../Video/" + item.name, item.columns, item.rows,
+                                                     interpolation, area);
+            },
+            prefetch_depth > 0 ? prefetch_depth : 8, static_cast<size_t>(prepare_mb * 1024 * 1024), loop);
+        quantization.plages = playlist->item(0).plages;
+    } else if (prefetch_depth > 0 || !cues.empty() || loop) {
+        prefetcher = std::make_unique<FramePrefetcher>(
+            [=] { return std::make_unique<VideoSource>(video_path, columns, rows, interpolation, area); },
+            prefetch_depth > 0 ? prefetch_depth : 8, cues, loop);
+    }
+    // Frame n is due n periods after the start, whatever the time spent on the
+    // previous ones, so the show keeps in time with its sound and time code.
+    // Each item of a playlist starts a segment with its own period.
+    double fps = playlist ? playlist->item(0).fps : video.get(cv::CAP_PROP_FPS);
+    double period_ms = fps > 0 ? 1000.0 / fps : 100.0;
+    QosGovernor qos(period_ms);
+    uint32_t dropped = 0;
+    SceneDetector scenes;
+    std::vector<uint8_t> last;  // Last frame quantized
+    QosGovernor::Level last_level = qos.level();  // Quantization of last
+    int last_plages = quantization.plages;
+    uint32_t unsent = 0;        // Unchanged frames since the last one sent
+    // Work skipped on unchanged frames, counted at the mean time of the frames that did it
+    uint32_t quantized = 0;
+    uint32_t quantize_skipped = 0;
+    uint32_t sent = 0;
+    uint32_t send_skipped = 0;
+    double quantize_ms = 0;
+    double send_ms = 0;
     cv::Mat frame;
-    while (true) {
-        video >> frame;
-        if (frame.empty()) {
+    PrefetchedFrame prefetched;
+    size_t current_item = 0;
+    int frame_columns = playlist ? playlist->item(0).columns : columns;  // Size of the prefetched frames
+    int frame_rows = playlist ? playlist->item(0).rows : rows;
+    auto segment_start = std::chrono::steady_clock::now();
+    uint32_t segment_first = 0;  // Index of the first frame of the segment
+    bool item_cut = false;       // A new item started, its first frame shown starts a scene
+    for (uint32_t index = 0;; index++) {
+        // The first frame of the next item is due when the last one of the item
+        // before ends, and starts its scene
+        if (playlist) {
+            size_t item;
+            if (!playlist->next(prefetched, item)) {
+                break;
+            }
+            if (item != current_item) {
+                item_cut = true;
+                segment_start += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::milli>((index - segment_first) * period_ms));
+                segment_first = index;
+                current_item = item;
+                const PlaylistItem& next = playlist->item(item);
+                period_ms = 1000.0 / next.fps;
+                qos.set_budget(period_ms);
+                quantization.plages = next.plages;
+                frame_columns = next.columns;
+                frame_rows = next.rows;
+                std::cout << "Playlist: " << next.name << " at frame " << index << std::endl;
+            }
+        }
+        auto due = segment_start + std::chrono::duration<double, std::milli>((index - segment_first) * period_ms);
+        // Frames more than a period late, or not shown at half rate, are not
+        // decoded, or not used once prefetched
+        bool late = std::chrono::steady_clock::now() > due + std::chrono::duration<double, std::milli>(period_ms);
+        if (prefetcher && !prefetcher->next(prefetched)) {
             break;
         }
-        std::vector<std::vector<std::vector<int>>> channels = process(frame, argv);
-        std::cout << "channels: " << channels.size() << std::endl;
-        if (cv::waitKey(30) >= 0) {
+        if (late || qos.skip(index)) {
+            if (!prefetcher && !playlist && !video.grab()) {
+                break;
+            }
+            dropped += !qos.skip(index);
+            continue;
+        }
+        if (!prefetcher && !playlist) {
+            video >> frame;
+            if (frame.empty()) {
+                break;
+            }
+        } else {
+            frame = cv::Mat(frame_rows, frame_columns, CV_8UC3, prefetched.pixels.data());
+        }
+        auto work_start = std::chrono::steady_clock::now();
+        cv::Mat imgResized =
+            qos.low_resolution()
+                ? resize_image(frame, (frame_columns + 1) / 2, (frame_rows + 1) / 2, interpolation, box.get())
+                : resize_image(frame, frame_columns, frame_rows, interpolation, box.get());
+        SceneDetector::Change change = scenes.classify(imgResized.ptr(), imgResized.cols, imgResized.rows);
+        if (change == SceneDetector::CUT || item_cut) {
+            item_cut = false;
+            if (quantization.levels) {
+                quantization.levels->reset();
+            }
+            if (quantization.dither) {
+                quantization.dither->reset();
+            }
+            if (link) {
+                link->scene_cut();
+            }
+            if (shards) {
+                shards->scene_cut();
+            }
+        }
+        // A repeated frame quantizes to the last one, unless dithered in time or
+        // quantized differently since (QoS level, plages of a playlist item)
+        bool unchanged = change == SceneDetector::REPEAT && !(quantization.dither && qos.dither()) && !last.empty() &&
+                         qos.level() == last_level && quantization.plages == last_plages;
+        if (unchanged) {
+            quantize_skipped++;
+        } else {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<uint8_t> rgb = process(imgResized, quantization, qos, columns, rows);
+            unchanged = rgb == last;
+            last = std::move(rgb);
+            last_level = qos.level();
+            last_plages = quantization.plages;
+            quantize_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            quantized++;
+        }
+        if (link || shards) {
+            // Unchanged frames are only sent once in a while, in case the last one was lost
+            if (unchanged && ++unsent < REPEAT_RESEND_FRAMES) {
+                send_skipped++;
+            } else {
+                auto start = std::chrono::steady_clock::now();
+                if (shards) {
+                    shards->send_frame(last);
+                } else {
+                    link->send_frame(last);
+                }
+                send_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                sent++;
+                unsent = 0;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (qos.record(std::chrono::duration<double, std::milli>(now - work_start).count())) {
+            const QosGovernor::Change& step = qos.changes().back();
+            std::cout << "QoS: " << QosGovernor::name(step.from) << " -> " << QosGovernor::name(step.to)
+                      << " at frame " << index << ", " << step.mean_ms << " ms per frame for " << period_ms
+                      << " ms" << std::endl;
+        }
+        // Until the next frame is due, at least the 1 ms the window events need
+        double wait_ms = std::chrono::duration<double, std::milli>(due - now).count() + period_ms;
+        int key = cv::waitKey(std::max(1, static_cast<int>(wait_ms)));
+        if (prefetcher && key >= '1' && key < '1' + static_cast<int>(std::min<size_t>(cues.size(), 9))) {
+            prefetcher->jump(key - '1');
+        } else if (key >= 0) {
             break;
         }
     }
+    double saved_ms = (quantized ? quantize_skipped * quantize_ms / quantized : 0) +
+                      (sent ? send_skipped * send_ms / sent : 0);
+    std::cout << scenes.frames() << " frames, " << scenes.repeats() << " repeated, " << scenes.cuts()
+              << " scene cuts, quantization skipped " << quantize_skipped << " times, sending " << send_skipped
+              << " times, about " << saved_ms << " ms saved" << std::endl;
+    std::cout << dropped << " frames dropped to keep in time, " << qos.changes().size() << " QoS level changes"
+              << std::endl;
+    if (prefetcher) {
+        std::cout << prefetcher->stalls() << " frames waited for the decoder, " << prefetcher->jumps()
+                  << " cue jumps, " << prefetcher->loops() << " loops" << std::endl;
+    }
+    if (playlist) {
+        std::cout << playlist->stalls() << " frames waited for the decoder in the playlist" << std::endl;
+    }
     return 0;
 }
\ No newline at end of file
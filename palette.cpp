@@ -0,0 +1,228 @@
+#include "palette.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// Histogram bin of 5 bits per colour, and what fell into it
+struct Bin {
+    uint32_t count;
+    uint32_t sum[3];
+    int mean[3];
+};
+
+int bin_of(const uint8_t* p) {
+    return ((p[0] >> 3) << 10) | ((p[1] >> 3) << 5) | (p[2] >> 3);
+}
+
+int distance(const int* a, const Rgb& b) {
+    int d0 = a[0] - b[0];
+    int d1 = a[1] - b[1];
+    int d2 = a[2] - b[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+int nearest(const int* color, const std::vector<Rgb>& palette) {
+    int best = 0;
+    int best_dist = distance(color, palette[0]);
+    for (size_t i = 1; i < palette.size() && best_dist > 0; i++) {
+        int dist = distance(color, palette[i]);
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// f(begin, end, worker) over [0, count) in one contiguous slice per thread,
+// the calling thread taking the first one
+template <typename F>
+void parallel_for(unsigned threads, size_t count, const F& f) {
+    // Below this many items a thread costs more than it saves
+    const size_t min_slice = 256;
+    size_t workers = std::max<size_t>(1, std::min<size_t>(threads, count / min_slice));
+    std::vector<std::thread> pool;
+    for (size_t w = 1; w < workers; w++) {
+        pool.emplace_back(f, count * w / workers, count * (w + 1) / workers, w);
+    }
+    f(0, count / workers, 0);
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+std::vector<Bin> histogram(const uint8_t* rgb, size_t pixels) {
+    std::vector<int> slot(1 << 15, -1);
+    std::vector<Bin> bins;
+    for (size_t i = 0; i < pixels; i++, rgb += 3) {
+        int& s = slot[bin_of(rgb)];
+        if (s < 0) {
+            s = static_cast<int>(bins.size());
+            bins.push_back(Bin{});
+        }
+        Bin& bin = bins[s];
+        bin.count++;
+        for (int k = 0; k < 3; k++) {
+            bin.sum[k] += rgb[k];
+        }
+    }
+    for (Bin& bin : bins) {
+        for (int k = 0; k < 3; k++) {
+            bin.mean[k] = static_cast<int>(bin.sum[k] / bin.count);
+        }
+    }
+    return bins;
+}
+
+Rgb mean_of(std::vector<Bin>::const_iterator begin, std::vector<Bin>::const_iterator end) {
+    uint64_t count = 0;
+    uint64_t sum[3] = {0, 0, 0};
+    for (auto it = begin; it != end; ++it) {
+        count += it->count;
+        for (int k = 0; k < 3; k++) {
+            sum[k] += it->sum[k];
+        }
+    }
+    Rgb color;
+    for (int k = 0; k < 3; k++) {
+        color[k] = static_cast<uint8_t>((sum[k] + count / 2) / count);
+    }
+    return color;
+}
+
+}  // namespace
+
+PaletteBuilder::PaletteBuilder(unsigned threads, size_t max_colors, int kmeans_passes)
+    : threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      max_colors_(std::min<size_t>(std::max<size_t>(max_colors, 1), PALETTE_SIZE)),
+      kmeans_passes_(kmeans_passes) {}
+
+std::vector<Rgb> PaletteBuilder::build(const uint8_t* rgb, size_t pixels) const {
+    std::vector<Bin> bins = histogram(rgb, pixels);
+    if (bins.empty()) {
+        return {Rgb{{0, 0, 0}}};
+    }
+
+    // Median cut: split the box with the most pixels times its longest side,
+    // at the pixel median of that side
+    struct Box {
+        size_t begin, end;
+        uint64_t count;
+        int axis, extent;
+    };
+    auto measure = [&](size_t begin, size_t end) {
+        Box box = {begin, end, 0, 0, 0};
+        int lo[3] = {255, 255, 255};
+        int hi[3] = {0, 0, 0};
+        for (size_t i = begin; i < end; i++) {
+            box.count += bins[i].count;
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], bins[i].mean[k]);
+                hi[k] = std::max(hi[k], bins[i].mean[k]);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            if (hi[k] - lo[k] > box.extent) {
+                box.extent = hi[k] - lo[k];
+                box.axis = k;
+            }
+        }
+        return box;
+    };
+    std::vector<Box> boxes = {measure(0, bins.size())};
+    while (boxes.size() < max_colors_) {
+        auto it = std::max_element(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
+            return a.count * a.extent < b.count * b.extent;
+        });
+        if (it->extent == 0) {
+            break;  // Every box holds a single colour
+        }
+        Box box = *it;
+        int axis = box.axis;
+        std::sort(bins.begin() + box.begin, bins.begin() + box.end,
+                  [axis](const Bin& a, const Bin& b) { return a.mean[axis] < b.mean[axis]; });
+        uint64_t half = bins[box.begin].count;
+        size_t split = box.begin + 1;
+        while (split < box.end - 1 && half * 2 < box.count) {
+            half += bins[split++].count;
+        }
+        *it = measure(box.begin, split);
+        boxes.push_back(measure(split, box.end));
+    }
+    std::vector<Rgb> palette;
+    for (const Box& box : boxes) {
+        palette.push_back(mean_of(bins.begin() + box.begin, bins.begin() + box.end));
+    }
+
+    // k-means passes over the bins, each colour moves to the mean of the bins nearest to it
+    std::vector<int> owner(bins.size());
+    for (int pass = 0; pass < kmeans_passes_; pass++) {
+        parallel_for(threads_, bins.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                owner[i] = nearest(bins[i].mean, palette);
+            }
+        });
+        std::vector<std::array<uint64_t, 4>> acc(palette.size(), {{0, 0, 0, 0}});
+        for (size_t i = 0; i < bins.size(); i++) {
+            std::array<uint64_t, 4>& a = acc[owner[i]];
+            a[0] += bins[i].sum[0];
+            a[1] += bins[i].sum[1];
+            a[2] += bins[i].sum[2];
+            a[3] += bins[i].count;
+        }
+        for (size_t c = 0; c < palette.size(); c++) {
+            if (acc[c][3]) {
+                for (int k = 0; k < 3; k++) {
+                    palette[c][k] = static_cast<uint8_t>((acc[c][k] + acc[c][3] / 2) / acc[c][3]);
+                }
+            }
+        }
+    }
+    return palette;
+}
+
+double PaletteBuilder::map(const uint8_t* rgb, size_t pixels, const std::vector<Rgb>& palette, uint8_t* indices) const {
+    // Nearest colour of every distinct colour of the frame, then a lookup per pixel
+    std::vector<uint32_t> colors(pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        colors[i] = static_cast<uint32_t>(rgb[i * 3] << 16 | rgb[i * 3 + 1] << 8 | rgb[i * 3 + 2]);
+    }
+    std::vector<uint32_t> distinct(colors);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    std::vector<uint8_t> index(distinct.size());
+    parallel_for(threads_, distinct.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            int color[3] = {static_cast<int>(distinct[i] >> 16), static_cast<int>(distinct[i] >> 8 & 0xFF),
+                            static_cast<int>(distinct[i] & 0xFF)};
+            index[i] = static_cast<uint8_t>(nearest(color, palette));
+        }
+    });
+
+    uint64_t error = 0;
+    for (size_t i = 0; i < pixels; i++, rgb += 3) {
+        indices[i] = index[std::lower_bound(distinct.begin(), distinct.end(), colors[i]) - distinct.begin()];
+        int p[3] = {rgb[0], rgb[1], rgb[2]};
+        error += distance(p, palette[indices[i]]);
+    }
+    return pixels ? static_cast<double>(error) / pixels : 0;
+}
+
+ScenePalette::ScenePalette(double max_error, unsigned threads) : builder_(threads), max_error_(max_error) {}
+
+bool ScenePalette::index(const uint8_t* rgb, size_t pixels, std::vector<uint8_t>& indices) {
+    indices.resize(pixels);
+    if (!palette_.empty()) {
+        error_ = builder_.map(rgb, pixels, palette_, indices.data());
+        if (error_ <= limit_) {
+            return false;
+        }
+    }
+    palette_ = builder_.build(rgb, pixels);
+    error_ = builder_.map(rgb, pixels, palette_, indices.data());
+    limit_ = std::max(max_error_, 2 * error_);
+    rebuilds_++;
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_format.h"
+
+// Palettes of the indexed frames (FRAME_PALETTE in frame_format.h), on RGB pixels
+// (3 bytes per pixel, R G B) at the projector geometry.
+typedef std::array<uint8_t, 3> Rgb;
+
+// Median cut over the 15 bit colour histogram of a frame, refined by a few
+// k-means passes. The nearest colour searches, which take the time, are split
+// over `threads` threads (0: one per core).
+class PaletteBuilder {
+public:
+    explicit PaletteBuilder(unsigned threads = 0, size_t max_colors = PALETTE_SIZE, int kmeans_passes = 2);
+
+    std::vector<Rgb> build(const uint8_t* rgb, size_t pixels) const;
+
+    // Index of the nearest palette colour of every pixel. Returns the mean squared
+    // error per pixel, summed over the three colours.
+    double map(const uint8_t* rgb, size_t pixels, const std::vector<Rgb>& palette, uint8_t* indices) const;
+
+    unsigned threads() const { return threads_; }
+
+private:
+    unsigned threads_;
+    size_t max_colors_;
+    int kmeans_passes_;
+};
+
+// Palette of the current scene: frames are mapped to it as long as they fit it,
+// and it is rebuilt on the first frame that does not (scene change). A rebuilt
+// palette accepts frames up to twice its own error, and at least max_error.
+class ScenePalette {
+public:
+    explicit ScenePalette(double max_error = 48.0, unsigned threads = 0);
+
+    // Indices of the frame, rebuilding the palette first if needed. Returns true if the palette changed.
+    bool index(const uint8_t* rgb, size_t pixels, std::vector<uint8_t>& indices);
+
+    // Rebuild the palette on the next frame (scene cut found elsewhere)
+    void reset() { palette_.clear(); }
+
+    const std::vector<Rgb>& palette() const { return palette_; }
+    double error() const { return error_; }        // Of the last frame indexed
+    uint32_t rebuilds() const { return rebuilds_; }
+
+private:
+    PaletteBuilder builder_;
+    double max_error_;
+    double limit_ = 0;
+    double error_ = 0;
+    std::vector<Rgb> palette_;
+    uint32_t rebuilds_ = 0;
+};
@@ -0,0 +1,120 @@
+#include "playlist.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<PlaylistItem> load_playlist(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not read playlist " + path);
+    }
+    std::vector<PlaylistItem> items;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string kind;
+        if (!(in >> kind) || kind[0] == '#') {
+            continue;
+        }
+        PlaylistItem item;
+        if ((kind != "video" && kind != "image") || !(in >> item.name)) {
+            throw std::runtime_error("Malformed playlist line: " + line);
+        }
+        item.still = kind == "image";
+        std::string option;
+        while (in >> option) {
+            size_t equals = option.find('=');
+            std::string key = option.substr(0, equals);
+            std::istringstream value(equals == std::string::npos ? "" : option.substr(equals + 1));
+            bool ok = false;
+            if (key == "fps") {
+                ok = (value >> item.fps) && item.fps > 0;
+            } else if (key == "plages") {
+                ok = (value >> item.plages) && item.plages > 0;
+            } else if (key == "seconds") {
+                ok = (value >> item.seconds) && item.seconds > 0;
+            } else if (key == "size") {
+                char x = 0;
+                ok = (value >> item.columns >> x >> item.rows) && x == 'x' && item.columns > 0 && item.rows > 0;
+            }
+            std::string rest;
+            if (!ok || value >> rest) {
+                throw std::runtime_error("Malformed playlist option " + option + " in line: " + line);
+            }
+        }
+        items.push_back(item);
+    }
+    return items;
+}
+
+PlaylistPlayer::PlaylistPlayer(std::vector<PlaylistItem> items, ItemSourceFactory open, size_t depth,
+                               size_t max_prepared_bytes, bool loop)
+    : items_(std::move(items)), open_(std::move(open)), depth_(depth), max_prepared_bytes_(max_prepared_bytes),
+      loop_(loop) {
+    if (items_.empty()) {
+        throw std::logic_error("Playlist has no items");
+    }
+    for (const PlaylistItem& item : items_) {
+        if (item.fps <= 0 || item.columns <= 0 || item.rows <= 0) {
+            throw std::logic_error("Playlist item " + item.name + " without frame rate or size");
+        }
+    }
+    playing_ = prepare(0, depth_);
+    if (after(0) < items_.size()) {
+        next_ = prepare(after(0), prepared_depth(items_[after(0)]));
+    }
+}
+
+size_t PlaylistPlayer::prepared_depth(const PlaylistItem& item) const {
+    size_t frame_bytes = size_t(item.columns) * item.rows * 3;
+    return std::max<size_t>(1, std::min(depth_, max_prepared_bytes_ / frame_bytes));
+}
+
+std::unique_ptr<FramePrefetcher> PlaylistPlayer::prepare(size_t index, size_t depth) {
+    const PlaylistItem& item = items_[index];
+    ItemSourceFactory open = open_;
+    return std::make_unique<FramePrefetcher>([open, item] { return open(item); }, depth);
+}
+
+size_t PlaylistPlayer::after(size_t index) const {
+    if (index + 1 < items_.size()) {
+        return index + 1;
+    }
+    return loop_ ? 0 : items_.size();
+}
+
+uint32_t PlaylistPlayer::stalls() const {
+    return past_stalls_ + (playing_ ? playing_->stalls() : 0);
+}
+
+bool PlaylistPlayer::next(PrefetchedFrame& frame, size_t& item) {
+    // Items that end before their first frame are passed, once round the playlist at most
+    for (size_t tries = 0; playing_ && tries <= items_.size(); tries++) {
+        uint32_t limit = items_[current_].frames();
+        if ((limit == 0 || played_ < limit) && playing_->next(frame)) {
+            played_++;
+            item = current_;
+            return true;
+        }
+        // On to the prepared item, and the one after it gets ready. The decoder
+        // of a clip cut short may be in the middle of a frame, it is not waited for.
+        past_stalls_ += playing_->stalls();
+        playing_->stop();
+        retired_.push_back(std::move(playing_));
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                      [](const std::unique_ptr<FramePrefetcher>& old) { return old->stopped(); }),
+                       retired_.end());
+        current_ = after(current_);
+        played_ = 0;
+        playing_ = std::move(next_);
+        if (playing_) {
+            playing_->set_depth(depth_);
+            if (after(current_) < items_.size()) {
+                next_ = prepare(after(current_), prepared_depth(items_[after(current_)]));
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "prefetch.hpp"
+
+// One clip of Video/ or still of image/ of the show, with its overrides of
+// the command line (0 for none)
+struct PlaylistItem {
+    bool still = false;
+    std::string name;  // File in Video/ or image/
+    double fps = 0;     // Frame rate of the clip, or at which the still is sent
+    int plages = 0;
+    int columns = 0;    // Resolution the frames are processed at, scaled to the projector
+    int rows = 0;
+    double seconds = 0;  // Time on screen: clips up to their end if 0
+
+    // Frames on screen, 0 for a clip played to its end
+    uint32_t frames() const { return seconds > 0 ? static_cast<uint32_t>(seconds * fps + 0.5) : 0; }
+};
+
+// Playlist file, one item per line:
+//   # comment
+//   video <file> [fps=<fps>] [plages=<n>] [size=<columns>x<rows>] [seconds=<s>]
+//   image <file> [fps=<fps>] [plages=<n>] [size=<columns>x<rows>] [seconds=<s>]
+std::vector<PlaylistItem> load_playlist(const std::string& path);
+
+// Plays the items of a playlist one after the other with no gap: while one
+// item plays, the next one is opened, decoded and resized in the background
+// by its own FramePrefetcher, so its first frame follows the last frame of the
+// one before. The next item keeps at most max_prepared_bytes of frames ready,
+// at least one.
+class PlaylistPlayer {
+public:
+    // Decoder of an item, frames of item.columns x item.rows pixels of 3 bytes
+    typedef std::function<std::unique_ptr<FrameSource>(const PlaylistItem& item)> ItemSourceFactory;
+
+    PlaylistPlayer(std::vector<PlaylistItem> items, ItemSourceFactory open, size_t depth, size_t max_prepared_bytes,
+                   bool loop = false);
+
+    // Next frame of the show and the index of its item, false after the last item
+    bool next(PrefetchedFrame& frame, size_t& item);
+
+    const PlaylistItem& item(size_t index) const { return items_[index]; }
+    size_t items() const { return items_.size(); }
+
+    // Frames of item prepared ahead while the one before plays
+    size_t prepared_depth(const PlaylistItem& item) const;
+
+    uint32_t stalls() const;  // Frames the show waited for a decoder
+
+private:
+    std::unique_ptr<FramePrefetcher> prepare(size_t index, size_t depth);
+    // Index of the item after index, items_.size() at the end of the playlist
+    size_t after(size_t index) const;
+
+    std::vector<PlaylistItem> items_;
+    ItemSourceFactory open_;
+    size_t depth_;
+    size_t max_prepared_bytes_;
+    bool loop_;
+    size_t current_ = 0;
+    uint32_t played_ = 0;  // Frames of the current item
+    std::unique_ptr<FramePrefetcher> playing_;
+    std::unique_ptr<FramePrefetcher> next_;
+    std::vector<std::unique_ptr<FramePrefetcher>> retired_;  // Stopping, destroyed once stopped
+    uint32_t past_stalls_ = 0;
+};
@@ -0,0 +1,188 @@
+#include "prefetch.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// One decoder and the frames it decoded ahead, from start on
+class FramePrefetcher::Stream {
+public:
+    Stream(const SourceFactory& open, uint32_t start, size_t depth) : depth_(depth) {
+        thread_ = std::thread([this, open, start] { run(open, start); });
+    }
+
+    ~Stream() {
+        stop();
+        thread_.join();
+    }
+
+    // Asks the decoder to stop after the frame it is on
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        changed_.notify_all();
+    }
+
+    void set_depth(size_t depth) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        depth_ = depth;
+        changed_.notify_all();
+    }
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return exited_;
+    }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frames_.size() >= depth_ || ended_;
+    }
+
+    // Front frame, false at the end of the file. waited: it was not decoded yet
+    bool pop(PrefetchedFrame& frame, bool& waited) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waited = frames_.empty() && !ended_;
+        changed_.wait(lock, [this] { return !frames_.empty() || ended_; });
+        if (frames_.empty()) {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return false;
+        }
+        frame = std::move(frames_.front());
+        frames_.pop_front();
+        changed_.notify_all();
+        return true;
+    }
+
+private:
+    void run(const SourceFactory& open, uint32_t start) {
+        try {
+            std::unique_ptr<FrameSource> source = open();
+            if (start != 0 && !source->seek(start)) {
+                throw std::runtime_error("Could not seek to frame " + std::to_string(start));
+            }
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    changed_.wait(lock, [this] { return frames_.size() < depth_ || stop_; });
+                    if (stop_) {
+                        break;
+                    }
+                }
+                PrefetchedFrame frame;
+                if (!source->read(frame)) {
+                    break;
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                frames_.push_back(std::move(frame));
+                changed_.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        ended_ = true;
+        exited_ = true;
+        changed_.notify_all();
+    }
+
+    size_t depth_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<PrefetchedFrame> frames_;
+    bool ended_ = false;
+    bool stop_ = false;
+    bool exited_ = false;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
+
+FramePrefetcher::FramePrefetcher(SourceFactory open, size_t depth, const std::vector<uint32_t>& cues, bool loop)
+    : open_(std::move(open)), depth_(depth), cues_(cues) {
+    if (depth == 0) {
+        throw std::logic_error("Prefetch depth must be at least 1 frame");
+    }
+    active_ = std::make_unique<Stream>(open_, 0, depth_);
+    for (uint32_t cue : cues_) {
+        cue_streams_.push_back(std::make_unique<Stream>(open_, cue, depth_));
+    }
+    if (loop) {
+        loop_ = std::make_unique<Stream>(open_, 0, depth_);
+    }
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    // Every decoder stops at once rather than one after the other
+    stop();
+}
+
+void FramePrefetcher::stop() {
+    active_->stop();
+    for (auto& stream : cue_streams_) {
+        stream->stop();
+    }
+    if (loop_) {
+        loop_->stop();
+    }
+}
+
+bool FramePrefetcher::stopped() const {
+    auto done = [](const std::unique_ptr<Stream>& stream) { return !stream || stream->done(); };
+    return done(active_) && done(loop_) && std::all_of(cue_streams_.begin(), cue_streams_.end(), done) &&
+           std::all_of(retired_.begin(), retired_.end(), done);
+}
+
+bool FramePrefetcher::next(PrefetchedFrame& frame) {
+    bool waited = false;
+    if (!active_->pop(frame, waited)) {
+        if (!loop_) {
+            return false;
+        }
+        switch_to(loop_, 0);
+        loops_++;
+        if (!active_->pop(frame, waited)) {
+            return false;
+        }
+    }
+    stalls_ += waited;
+    return true;
+}
+
+void FramePrefetcher::set_depth(size_t depth) {
+    if (depth == 0) {
+        throw std::logic_error("Prefetch depth must be at least 1 frame");
+    }
+    depth_ = depth;
+    active_->set_depth(depth);
+}
+
+void FramePrefetcher::jump(size_t cue) {
+    if (cue >= cues_.size()) {
+        throw std::logic_error("No cue " + std::to_string(cue));
+    }
+    switch_to(cue_streams_[cue], cues_[cue]);
+    jumps_++;
+}
+
+bool FramePrefetcher::cue_ready(size_t cue) const {
+    return cue < cue_streams_.size() && cue_streams_[cue]->ready();
+}
+
+void FramePrefetcher::switch_to(std::unique_ptr<Stream>& next, uint32_t start) {
+    // The old decoder may be in the middle of a frame: it is joined later
+    // rather than waited for here
+    active_->stop();
+    retired_.push_back(std::move(active_));
+    active_ = std::move(next);
+    next = std::make_unique<Stream>(open_, start, depth_);
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [](const std::unique_ptr<Stream>& stream) { return stream->done(); }),
+                   retired_.end());
+}
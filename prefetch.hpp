@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Frame decoded and made ready for the projector (resized) ahead of its time
+struct PrefetchedFrame {
+    uint32_t index = 0;  // Frame number in its file
+    std::vector<uint8_t> pixels;
+};
+
+// Decoder of one file: cv::VideoCapture in main.cpp
+class FrameSource {
+public:
+    virtual ~FrameSource() {}
+    // Next read gives frame: decodes from the keyframe before it, whatever it costs
+    virtual bool seek(uint32_t frame) = 0;
+    // Next frame, false at the end of the file
+    virtual bool read(PrefetchedFrame& frame) = 0;
+};
+
+// Opens a new decoder of the file, called on the thread that will use it
+typedef std::function<std::unique_ptr<FrameSource>()> SourceFactory;
+
+// Decode-ahead buffer of the show: a thread keeps up to depth frames decoded
+// ahead of the one projected. Each cue point, and the start of the file with
+// loop, has its own decoder that seeks to it in the background and decodes
+// its first depth frames, then waits. Jumping to a cue, or back to the start
+// at the end of the file, swaps that buffer in at the next frame with no wait,
+// its decoder going on from there, and a new one gets ready at the cue for
+// the next time.
+class FramePrefetcher {
+public:
+    FramePrefetcher(SourceFactory open, size_t depth, const std::vector<uint32_t>& cues = {}, bool loop = false);
+    ~FramePrefetcher();
+
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+    // Next frame of the show, waiting for it if the decoder is behind. False at
+    // the end of the file without loop. Rethrows an error of the decoder.
+    bool next(PrefetchedFrame& frame);
+
+    // The show goes on from cue at the next frame
+    void jump(size_t cue);
+
+    // Frames decoded ahead from now on
+    void set_depth(size_t depth);
+
+    // Asks every decoder to stop after the frame it is on, without waiting for
+    // them. Once stopped(), destroying the prefetcher does not wait.
+    void stop();
+    bool stopped() const;
+
+    size_t cues() const { return cues_.size(); }
+    // The frames of cue are decoded: jumping to it will not wait
+    bool cue_ready(size_t cue) const;
+
+    uint32_t stalls() const { return stalls_; }  // Frames the show waited for
+    uint32_t jumps() const { return jumps_; }
+    uint32_t loops() const { return loops_; }
+
+private:
+    class Stream;
+
+    // Swaps in next and starts a decoder ready at its place
+    void switch_to(std::unique_ptr<Stream>& next, uint32_t start);
+
+    SourceFactory open_;
+    size_t depth_;
+    std::vector<uint32_t> cues_;
+    std::unique_ptr<Stream> active_;
+    std::vector<std::unique_ptr<Stream>> cue_streams_;
+    std::unique_ptr<Stream> loop_;  // At the start of the file, null without loop
+    std::vector<std::unique_ptr<Stream>> retired_;  // Stopping, joined once done
+    uint32_t stalls_ = 0;
+    uint32_t jumps_ = 0;
+    uint32_t loops_ = 0;
+};
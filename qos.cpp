@@ -0,0 +1,61 @@
+#include "qos.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+QosGovernor::QosGovernor(double budget_ms, int window, int max_misses, double headroom, int hold)
+    : budget_ms_(budget_ms),
+      window_(static_cast<size_t>(std::max(window, 1))),
+      max_misses_(std::max(max_misses, 1)),
+      headroom_(headroom),
+      hold_(hold) {}
+
+bool QosGovernor::record(double ms) {
+    frames_++;
+    at_level_++;
+    times_.push_back(ms);
+    if (times_.size() > window_) {
+        times_.pop_front();
+    }
+    double budget = level_ >= HALF_RATE ? 2 * budget_ms_ : budget_ms_;
+    int misses =
+        static_cast<int>(std::count_if(times_.begin(), times_.end(), [budget](double t) { return t > budget; }));
+    double mean = std::accumulate(times_.begin(), times_.end(), 0.0) / times_.size();
+
+    Level to = level_;
+    if (misses >= max_misses_ && level_ < LOW_RESOLUTION) {
+        to = static_cast<Level>(level_ + 1);
+    } else if (level_ > FULL && at_level_ >= hold_ && times_.size() == window_ && misses == 0 &&
+               mean < headroom_ * budget) {
+        to = static_cast<Level>(level_ - 1);
+    }
+    if (to == level_) {
+        return false;
+    }
+    changes_.push_back(Change{frames_, level_, to, mean});
+    level_ = to;
+    at_level_ = 0;
+    // The times of the previous level say nothing about this one
+    times_.clear();
+    return true;
+}
+
+int QosGovernor::plages(int wanted) const {
+    return level_ >= FEWER_LEVELS ? std::max(wanted / 2, std::min(wanted, 2)) : wanted;
+}
+
+const char* QosGovernor::name(Level level) {
+    switch (level) {
+    case FULL:
+        return "full";
+    case NO_DITHER:
+        return "no dithering";
+    case FEWER_LEVELS:
+        return "fewer levels";
+    case HALF_RATE:
+        return "half rate";
+    case LOW_RESOLUTION:
+        return "low resolution";
+    }
+    return "?";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Degrades the host pipeline step by step while frames take longer than their
+// budget (the frame period of the video), and restores it one step at a time
+// once frames leave enough headroom. Going down takes max_misses frames over
+// budget among the last window frames; going up takes hold frames at the
+// level, then a whole window without a miss and a mean time under headroom of
+// the budget. The budget doubles at half rate, each frame has two periods.
+class QosGovernor {
+public:
+    // In the order they are applied, each one keeps the previous ones
+    enum Level { FULL, NO_DITHER, FEWER_LEVELS, HALF_RATE, LOW_RESOLUTION };
+
+    struct Change {
+        uint32_t frame;  // Frames recorded before the change
+        Level from;
+        Level to;
+        double mean_ms;  // Of the window that caused it
+    };
+
+    explicit QosGovernor(double budget_ms, int window = 10, int max_misses = 3, double headroom = 0.5,
+                         int hold = 30);
+
+    // Time spent on a frame. Returns true if the level changed.
+    bool record(double ms);
+
+    // New frame period (next clip of a playlist): the times of the old one no
+    // longer count, the level stays
+    void set_budget(double budget_ms) {
+        budget_ms_ = budget_ms;
+        times_.clear();
+    }
+
+    Level level() const { return level_; }
+    bool dither() const { return level_ < NO_DITHER; }
+    // Levels per colour to use instead of wanted
+    int plages(int wanted) const;
+    // Frame of the video not to process
+    bool skip(uint32_t frame) const { return level_ >= HALF_RATE && frame % 2 != 0; }
+    // Frames processed with half the rows and columns
+    bool low_resolution() const { return level_ >= LOW_RESOLUTION; }
+    const std::vector<Change>& changes() const { return changes_; }
+
+    static const char* name(Level level);
+
+private:
+    double budget_ms_;
+    size_t window_;
+    int max_misses_;
+    double headroom_;
+    int hold_;
+    Level level_ = FULL;
+    uint32_t frames_ = 0;
+    int at_level_ = 0;  // Frames since the last change
+    std::deque<double> times_;
+    std::vector<Change> changes_;
+};
@@ -0,0 +1,63 @@
+#include "scene_detect.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+FrameSignature frame_signature(const uint8_t* pixels, int width, int height) {
+    const int grid = FrameSignature::GRID;
+    FrameSignature signature;
+    size_t bytes = static_cast<size_t>(width) * height * 3;
+
+    // FNV-1a over 8 bytes at a time, the tail byte by byte
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, pixels + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < bytes; i++) {
+        hash = (hash ^ pixels[i]) * 0x100000001b3ull;
+    }
+    signature.hash = hash;
+
+    uint32_t sums[grid * grid * 3] = {};
+    uint32_t counts[grid * grid] = {};
+    for (int y = 0; y < height; y++) {
+        int row = y * grid / height * grid;
+        for (int x = 0; x < width; x++, pixels += 3) {
+            int block = row + x * grid / width;
+            counts[block]++;
+            sums[block * 3] += pixels[0];
+            sums[block * 3 + 1] += pixels[1];
+            sums[block * 3 + 2] += pixels[2];
+        }
+    }
+    for (int b = 0; b < grid * grid * 3; b++) {
+        uint32_t count = counts[b / 3];
+        signature.thumbnail[b] = static_cast<uint8_t>(count ? (sums[b] + count / 2) / count : 0);
+    }
+    return signature;
+}
+
+SceneDetector::Change SceneDetector::classify(const uint8_t* pixels, int width, int height) {
+    FrameSignature signature = frame_signature(pixels, width, height);
+    Change change = CUT;
+    if (frames_ > 0) {
+        int difference = 0;
+        for (size_t b = 0; b < signature.thumbnail.size(); b++) {
+            difference += std::abs(signature.thumbnail[b] - last_.thumbnail[b]);
+        }
+        if (signature.hash == last_.hash && difference == 0) {
+            change = REPEAT;
+        } else if (difference <= cut_threshold_ * static_cast<int>(signature.thumbnail.size())) {
+            change = SAME_SCENE;
+        }
+    }
+    frames_++;
+    repeats_ += change == REPEAT;
+    cuts_ += change == CUT;
+    last_ = signature;
+    return change;
+}
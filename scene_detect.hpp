@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// What a frame looks like, cheap to compare with the previous one
+struct FrameSignature {
+    static const int GRID = 8;
+
+    uint64_t hash = 0;                                    // Of every byte of the frame
+    std::array<uint8_t, GRID * GRID * 3> thumbnail = {};  // Mean of each block of a GRID x GRID grid, per channel
+};
+
+// Signature of width * height pixels of 3 channels, row by row
+FrameSignature frame_signature(const uint8_t* pixels, int width, int height);
+
+// Sorts the frames of a video against the previous one: repeated (same bytes),
+// same scene, or scene cut when the thumbnails differ by more than
+// cut_threshold on average. The first frame is a cut.
+class SceneDetector {
+public:
+    enum Change { REPEAT, SAME_SCENE, CUT };
+
+    explicit SceneDetector(int cut_threshold = 20) : cut_threshold_(cut_threshold) {}
+
+    Change classify(const uint8_t* pixels, int width, int height);
+
+    uint32_t frames() const { return frames_; }
+    uint32_t repeats() const { return repeats_; }
+    uint32_t cuts() const { return cuts_; }
+
+private:
+    int cut_threshold_;
+    FrameSignature last_;
+    uint32_t frames_ = 0;
+    uint32_t repeats_ = 0;
+    uint32_t cuts_ = 0;
+};
@@ -0,0 +1,177 @@
+#include "sharded_link.hpp"
+#include "frame_format.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ShardedLink::ShardedLink(const std::vector<std::string>& devices, Split split, double pulse_period_ms)
+    : split_(split), period_(pulse_period_ms), shards_(devices.size()) {
+    if (devices.empty()) {
+        throw std::logic_error("Sharded link needs at least one device");
+    }
+    if (split == COLOURS && devices.size() != BYTES_PER_PIXEL) {
+        throw std::logic_error("Sharding by colour needs one device per colour");
+    }
+    for (size_t i = 0; i < devices.size(); i++) {
+        shards_[i].link = std::make_unique<FrameLink>(devices[i]);
+    }
+    ends_done_ = shards_.size();
+    for (Shard& shard : shards_) {
+        shard.thread = std::thread([this, &shard] { run(shard); });
+    }
+}
+
+ShardedLink::~ShardedLink() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_idle(lock);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    for (Shard& shard : shards_) {
+        shard.thread.join();
+    }
+}
+
+std::vector<std::vector<uint8_t>> ShardedLink::split(const std::vector<uint8_t>& rgb, Split split, size_t shards) {
+    const size_t frame_size = LINES_PER_FRAME * PIXELS_PER_LINE * BYTES_PER_PIXEL;
+    std::vector<std::vector<uint8_t>> parts(shards);
+    if (split == LINE_BANDS) {
+        if (rgb.size() != shards * frame_size) {
+            throw std::logic_error("Frame size does not match the line bands of the controllers");
+        }
+        for (size_t i = 0; i < shards; i++) {
+            parts[i].assign(rgb.begin() + i * frame_size, rgb.begin() + (i + 1) * frame_size);
+        }
+        return parts;
+    }
+    if (rgb.size() != frame_size || shards != BYTES_PER_PIXEL) {
+        throw std::logic_error("Frame size does not match the projector geometry");
+    }
+    for (size_t c = 0; c < shards; c++) {
+        parts[c].assign(frame_size, 0);
+        for (size_t i = c; i < frame_size; i += BYTES_PER_PIXEL) {
+            parts[c][i] = rgb[i];
+        }
+    }
+    return parts;
+}
+
+void ShardedLink::wait_idle(std::unique_lock<std::mutex>& lock) {
+    changed_.wait(lock, [this] { return ends_done_ == shards_.size(); });
+}
+
+void ShardedLink::send_frame(const std::vector<uint8_t>& rgb) {
+    std::vector<std::vector<uint8_t>> parts = split(rgb, split_, shards_.size());
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_idle(lock);
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+        for (size_t i = 0; i < shards_.size(); i++) {
+            shards_[i].rgb = std::move(parts[i]);
+            shards_[i].link->set_frame_seq(frame_seq_);
+        }
+        frame_seq_++;
+        frames_++;
+        lines_done_ = 0;
+        ends_done_ = 0;
+        failed_ = false;
+        generation_++;
+    }
+    changed_.notify_all();
+}
+
+void ShardedLink::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wait_idle(lock);
+}
+
+void ShardedLink::scene_cut() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wait_idle(lock);
+    for (Shard& shard : shards_) {
+        shard.link->scene_cut();
+    }
+}
+
+uint32_t ShardedLink::late_pulses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return late_pulses_;
+}
+
+double ShardedLink::max_lines_skew_ms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_lines_skew_ms_;
+}
+
+void ShardedLink::run(Shard& shard) {
+    uint32_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+            return;
+        }
+        seen = generation_;
+
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            shard.link->send_frame_lines(shard.rgb);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        Clock::time_point done = Clock::now();
+        lock.lock();
+        if (error) {
+            failed_ = true;
+            error_ = error;
+        }
+        if (++lines_done_ == 1) {
+            first_lines_done_ = done;
+        }
+        if (lines_done_ == shards_.size()) {
+            max_lines_skew_ms_ = std::max(
+                max_lines_skew_ms_, std::chrono::duration<double, std::milli>(done - first_lines_done_).count());
+            // Pulse of frame n at n periods after the first one, or now if the lines are late
+            pulse_ = done;
+            if (period_.count() > 0) {
+                if (first_pulse_ == Clock::time_point()) {
+                    first_pulse_ = done;
+                }
+                Clock::time_point scheduled =
+                    first_pulse_ + std::chrono::duration_cast<Clock::duration>(period_ * (frames_ - 1));
+                if (scheduled >= done) {
+                    pulse_ = scheduled;
+                } else {
+                    late_pulses_++;
+                }
+            }
+            changed_.notify_all();
+        }
+        changed_.wait(lock, [this] { return lines_done_ == shards_.size(); });
+        bool send_end = !failed_;
+        Clock::time_point pulse = pulse_;
+
+        lock.unlock();
+        // A part missing on one controller: no frame published on any of them
+        if (send_end) {
+            std::this_thread::sleep_until(pulse);
+            try {
+                shard.link->end_frame();
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        lock.lock();
+        if (error) {
+            error_ = error;
+        }
+        ends_done_++;
+        changed_.notify_all();
+    }
+}
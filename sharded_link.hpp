@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_link.hpp"
+
+// Sends each frame to several projector controllers at once, one FrameLink
+// and one sender thread per controller, each with its part of the frame:
+//   LINE_BANDS: the frame has LINES_PER_FRAME lines per controller, controller
+//               i gets lines i * LINES_PER_FRAME to (i + 1) * LINES_PER_FRAME - 1
+//   COLOURS:    3 controllers, one per laser, controller c gets the frame with
+//               only its colour (the others at 0)
+// Every part of a frame goes out with the same frame sequence number. The
+// senders send their lines, wait for all the others, then send their END
+// packets together: the END packet is what makes a controller publish its
+// frame, so it is the sync pulse of the controllers. With pulse_period_ms the
+// pulses follow a schedule, frame n at n periods after the first one, or as
+// soon as all its lines are out if they are late.
+class ShardedLink {
+public:
+    enum Split { LINE_BANDS, COLOURS };
+
+    ShardedLink(const std::vector<std::string>& devices, Split split, double pulse_period_ms = 0);
+    ~ShardedLink();
+
+    ShardedLink(const ShardedLink&) = delete;
+    ShardedLink& operator=(const ShardedLink&) = delete;
+
+    // rgb: line by line in R G B order, LINES_PER_FRAME * PIXELS_PER_LINE
+    // pixels per controller for LINE_BANDS, per frame for COLOURS. Returns once
+    // the parts are handed to the senders, after the END packets of the previous
+    // frame. Rethrows the error of a sender on the previous frame.
+    void send_frame(const std::vector<uint8_t>& rgb);
+
+    // Waits for the END packets of the last frame
+    void flush();
+
+    void scene_cut();
+
+    // Part of rgb for each of shards controllers
+    static std::vector<std::vector<uint8_t>> split(const std::vector<uint8_t>& rgb, Split split, size_t shards);
+
+    size_t shards() const { return shards_.size(); }
+    uint16_t frame_seq() const { return frame_seq_; }
+    uint32_t frames() const { return frames_; }
+    // Frames whose lines were not all out at the time of their pulse
+    uint32_t late_pulses() const;
+    // Largest time between the first and the last controller done with the lines of a frame
+    double max_lines_skew_ms() const;
+
+private:
+    struct Shard {
+        std::unique_ptr<FrameLink> link;
+        std::vector<uint8_t> rgb;
+        std::thread thread;
+    };
+
+    void run(Shard& shard);
+    void wait_idle(std::unique_lock<std::mutex>& lock);
+
+    typedef std::chrono::steady_clock Clock;
+
+    Split split_;
+    std::chrono::duration<double, std::milli> period_;
+    std::vector<Shard> shards_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    uint32_t generation_ = 0;  // Frames handed to the senders
+    size_t lines_done_ = 0;
+    size_t ends_done_ = 0;
+    bool failed_ = false;  // A sender failed on the current frame, no END packets
+    bool stop_ = false;
+    std::exception_ptr error_;
+    Clock::time_point first_lines_done_;
+    Clock::time_point pulse_;
+    Clock::time_point first_pulse_;
+
+    uint16_t frame_seq_ = 0;
+    uint32_t frames_ = 0;
+    uint32_t late_pulses_ = 0;
+    double max_lines_skew_ms_ = 0;
+};
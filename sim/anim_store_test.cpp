@@ -0,0 +1,112 @@
+// Round trip of the flash animations on Linux: synthetic frames of palette
+// indices packed by the encoder of tools/anim_pack (anim_image.hpp), then
+// decoded line by line by the firmware (anim_store.h). Every line must come
+// back as its palette colours, identical lines must be stored once, and a
+// corrupted or truncated image must be rejected without reading out of it.
+// Exit status 1 on the first failure.
+#include "anim_image.hpp"
+#include "anim_store.h"
+#include "check.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int FRAMES = 40;
+static const size_t FRAME_PIXELS = LINES_PER_FRAME * PIXELS_PER_LINE;
+
+static std::vector<Rgb> test_palette(size_t colors) {
+    std::vector<Rgb> palette;
+    for (size_t i = 0; i < colors; i++) {
+        palette.push_back({static_cast<uint8_t>(i), static_cast<uint8_t>(255 - i), static_cast<uint8_t>(i * 7)});
+    }
+    return palette;
+}
+
+// A static background with a band moving over it, noisy lines and lines with
+// runs of every length around the ones the encoder treats apart
+static std::vector<std::vector<uint8_t>> test_frames(std::mt19937& rng, size_t colors) {
+    std::vector<std::vector<uint8_t>> frames;
+    for (int f = 0; f < FRAMES; f++) {
+        std::vector<uint8_t> frame(FRAME_PIXELS);
+        for (int y = 0; y < LINES_PER_FRAME; y++) {
+            uint8_t* line = &frame[y * PIXELS_PER_LINE];
+            for (int x = 0; x < PIXELS_PER_LINE; x++) {
+                if (y % 10 == 3) {
+                    line[x] = static_cast<uint8_t>(rng() % colors);
+                } else if (y % 10 == 5) {
+                    line[x] = static_cast<uint8_t>((x / (1 + y / 10)) % colors);
+                } else if (std::abs(y - f * 2) < 4) {
+                    line[x] = static_cast<uint8_t>((x * 3 + f) % colors);
+                } else {
+                    line[x] = static_cast<uint8_t>(y % colors);
+                }
+            }
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// Every line of the image decodes to the colours of its indices
+static bool round_trip(const anim_store_t& store, const std::vector<Rgb>& palette,
+                       const std::vector<std::vector<uint8_t>>& frames) {
+    uint8_t rgb[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+    for (size_t f = 0; f < frames.size(); f++) {
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            if (!anim_store_decode_line(&store, static_cast<uint32_t>(f), static_cast<uint16_t>(line), rgb)) {
+                return false;
+            }
+            for (int x = 0; x < PIXELS_PER_LINE; x++) {
+                const Rgb& color = palette[frames[f][line * PIXELS_PER_LINE + x]];
+                if (rgb[x][0] != color[0] || rgb[x][1] != color[1] || rgb[x][2] != color[2]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(3);
+    for (size_t colors : {1, 2, 16, 256}) {
+        std::vector<Rgb> palette = test_palette(colors);
+        std::vector<std::vector<uint8_t>> frames = test_frames(rng, colors);
+        AnimImage image = anim_encode(palette, frames, 12.5);
+        std::string name = std::to_string(colors) + " colours";
+        anim_store_t store;
+        check(anim_store_open(&store, image.bytes.data(), image.bytes.size()), name + ": image accepted");
+        check(store.width == PIXELS_PER_LINE && store.height == LINES_PER_FRAME && store.frame_count == FRAMES &&
+                  store.palette_size == colors && store.fps_x100 == 1250,
+              name + ": header");
+        check(round_trip(store, palette, frames), name + ": every line decoded");
+        check(image.shared_lines > 0, name + ": identical lines shared");
+        check(image.bytes.size() < FRAMES * FRAME_PIXELS, name + ": smaller than the indices");
+
+        // Truncated image: the header is rejected or the lines read past the end fail
+        for (size_t size : {size_t(10), image.bytes.size() / 2, image.bytes.size() - 1}) {
+            anim_store_t cut;
+            if (anim_store_open(&cut, image.bytes.data(), size)) {
+                check(!round_trip(cut, palette, frames), name + ": truncated image decoded");
+            }
+        }
+        // Corrupted line data: decoded or rejected, never read out of the image (ASan)
+        std::vector<uint8_t> corrupted = image.bytes;
+        size_t data_start = ANIM_STORE_HEADER_SIZE + colors * 3 + FRAMES * LINES_PER_FRAME * 4;
+        std::uniform_int_distribution<size_t> at(data_start, corrupted.size() - 1);
+        for (int i = 0; i < 200; i++) {
+            corrupted[at(rng)] = static_cast<uint8_t>(rng());
+        }
+        anim_store_t bad;
+        check(anim_store_open(&bad, corrupted.data(), corrupted.size()), name + ": corrupted data opened");
+        uint8_t rgb[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+        for (uint32_t f = 0; f < FRAMES; f++) {
+            for (uint16_t line = 0; line < LINES_PER_FRAME; line++) {
+                anim_store_decode_line(&bad, f, line, rgb);
+            }
+        }
+    }
+    return check_result("anim store");
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Checks of the host tests: every failure is printed and counted, and main
+// ends with check_result, 0 and "<name> OK" if none failed, else 1
+#include <iostream>
+#include <string>
+
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        check_failures()++;
+    }
+}
+
+inline int check_result(const std::string& name) {
+    if (check_failures() != 0) {
+        std::cerr << check_failures() << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << name << " OK" << std::endl;
+    return 0;
+}
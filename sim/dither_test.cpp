@@ -0,0 +1,160 @@
+// Checks of the ordered and temporal dithering (dither.hpp): every pixel lands
+// on one of the two levels around its value, or keeps its lookup outside the
+// levels (fixed split), flat areas average to their value over a Bayer cell
+// (and its 4 phases), and the dithered ramps are compared to the golden images
+// of the directory given as argument.
+// Usage: dither_test <golden dir> [--update]   (--update rewrites the golden images)
+// Exit status 1 on the first failure.
+#include "dither.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static const int WIDTH = 64;
+static const int HEIGHT = 16;
+
+// n levels spread over 0..255, every value on the nearest
+static LevelMap uniform_levels(int n) {
+    LevelMap map;
+    for (int k = 0; k < 3; k++) {
+        map.levels[k].clear();
+        for (int l = 0; l < n; l++) {
+            map.levels[k].push_back(static_cast<uint8_t>(l * 255 / (n - 1)));
+        }
+        for (int v = 0; v < 256; v++) {
+            map.lut[k][v] = static_cast<uint8_t>((v * (n - 1) + 127) / 255 * 255 / (n - 1));
+        }
+    }
+    return map;
+}
+
+// Horizontal ramp in red, vertical in green, diagonal in blue
+static std::vector<uint8_t> ramp() {
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 3);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t* p = &pixels[(y * WIDTH + x) * 3];
+            p[0] = static_cast<uint8_t>(x * 4);
+            p[1] = static_cast<uint8_t>(y * 16);
+            p[2] = static_cast<uint8_t>((x + y * 4) * 2);
+        }
+    }
+    return pixels;
+}
+
+// Frames of the ramp stacked vertically, as a binary PPM
+static std::string dithered_ramp(bool temporal, int frames) {
+    LevelMap map = uniform_levels(4);
+    Dither dither(temporal);
+    std::vector<uint8_t> in = ramp();
+    std::string ppm = "P6\n" + std::to_string(WIDTH) + " " + std::to_string(HEIGHT * frames) + "\n255\n";
+    std::vector<uint8_t> out(in.size());
+    for (int f = 0; f < frames; f++) {
+        dither.apply(map, in.data(), WIDTH, HEIGHT, out.data());
+        ppm.append(out.begin(), out.end());
+    }
+    return ppm;
+}
+
+static void golden(const std::string& dir, const std::string& name, const std::string& ppm, bool update) {
+    std::string path = dir + "/" + name;
+    if (update) {
+        std::ofstream(path, std::ios::binary) << ppm;
+        return;
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::string want((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    check(file.good() || file.eof(), "golden image " + path);
+    check(ppm == want, name + " differs from the golden image");
+}
+
+static void test_levels() {
+    LevelMap map = uniform_levels(4);
+    for (bool temporal : {false, true}) {
+        Dither dither(temporal);
+        bool between = true;
+        double worst = 0;
+        for (int v = 0; v < 256; v++) {
+            // Flat 4x4 area over the 4 phases
+            std::vector<uint8_t> flat(16 * 3, static_cast<uint8_t>(v));
+            std::vector<uint8_t> out(flat.size());
+            int lo = v / 85 * 85;
+            int hi = std::min(lo + 85, 255);
+            double sum = 0;
+            for (int f = 0; f < 4; f++) {
+                dither.apply(map, flat.data(), 4, 4, out.data());
+                for (uint8_t o : out) {
+                    between = between && (o == lo || o == hi);
+                    sum += o;
+                }
+            }
+            worst = std::max(worst, std::fabs(sum / (4 * out.size()) - v));
+        }
+        std::string mode = temporal ? "temporal" : "ordered";
+        check(between, mode + ": outputs on the levels around the value");
+        // Half a step of 64 (temporal) or 16 steps between two levels
+        check(worst <= 85.0 / (temporal ? 128 : 32), mode + ": flat area mean off by " + std::to_string(worst));
+    }
+
+    // Values on a level stay on it, the ordered dither is the same on every frame
+    Dither dither;
+    Dither ordered(false);
+    std::vector<uint8_t> in = ramp();
+    for (uint8_t& v : in) {
+        v = static_cast<uint8_t>(v / 85 * 85);
+    }
+    std::vector<uint8_t> out(in.size());
+    bool still = true;
+    for (int f = 0; f < 4; f++) {
+        dither.apply(map, in.data(), WIDTH, HEIGHT, out.data());
+        still = still && out == in;
+    }
+    check(still, "values on a level are not dithered");
+    in = ramp();
+    std::vector<uint8_t> first(in.size());
+    ordered.apply(map, in.data(), WIDTH, HEIGHT, first.data());
+    ordered.apply(map, in.data(), WIDTH, HEIGHT, out.data());
+    check(first == out, "ordered dither steady");
+    check(ordered.frame() == 2, "frames counted");
+
+    // Fixed split of 4: levels 0 16 32 48, the values from 64 up go to 0 as
+    // with the plain lookup, not to the top level
+    LevelMap fixed = LevelMap::fixed(4);
+    Dither fixed_dither;
+    bool kept = true;
+    bool around = true;
+    for (int v = 0; v < 256; v++) {
+        std::vector<uint8_t> flat(16 * 3, static_cast<uint8_t>(v));
+        std::vector<uint8_t> out(flat.size());
+        for (int f = 0; f < 4; f++) {
+            fixed_dither.apply(fixed, flat.data(), 4, 4, out.data());
+            for (uint8_t o : out) {
+                if (v >= 48) {
+                    kept = kept && o == fixed.lut[0][v];
+                } else {
+                    around = around && (o == v / 16 * 16 || o == v / 16 * 16 + 16);
+                }
+            }
+        }
+    }
+    check(kept, "fixed split: values from its top level keep their lookup");
+    check(around, "fixed split: outputs on the levels around the value");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: dither_test <golden dir> [--update]" << std::endl;
+        return 1;
+    }
+    bool update = argc > 2 && std::string(argv[2]) == "--update";
+    test_levels();
+    golden(argv[1], "dither_ordered.ppm", dithered_ramp(false, 1), update);
+    golden(argv[1], "dither_temporal.ppm", dithered_ramp(true, 4), update);
+    return check_result("dither");
+}
@@ -0,0 +1,133 @@
+// Checks of the front/back frame buffer of the firmware (frame_buffer.h) on
+// Linux: publish and swap, a swap while the receiver is still filling the back
+// frame, frames skipped while one waits for the swap and aborted writes, with
+// their counters. Then a receiver and a display thread run against each other:
+// the front frame must never change while it is shown, and frames come in order.
+// Exit status 1 on the first failure.
+#include "frame_buffer.h"
+#include "check.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+static const uint32_t STRESS_FRAMES = 2000;
+
+// Every word of the frame set to value
+static void fill(frame_t* frame, uint16_t value) {
+    for (auto& line : frame->phases) {
+        for (uint16_t& word : line) {
+            word = value;
+        }
+    }
+}
+
+// Value of every word of the frame, or -1 if they differ (torn frame)
+static int uniform(const frame_t* frame) {
+    uint16_t value = frame->phases[0][0];
+    for (const auto& line : frame->phases) {
+        for (uint16_t word : line) {
+            if (word != value) {
+                return -1;
+            }
+        }
+    }
+    return value;
+}
+
+static frame_buffer_stats_t stats(const frame_buffer_t* fb) {
+    frame_buffer_stats_t stats;
+    frame_buffer_get_stats(fb, &stats);
+    return stats;
+}
+
+static void test_sequence() {
+    std::unique_ptr<frame_buffer_t> fb(new frame_buffer_t);
+    frame_buffer_init(fb.get());
+    check(uniform(frame_buffer_front(fb.get())) == 0, "front cleared");
+    check(!frame_buffer_swap(fb.get()) && stats(fb.get()).late == 0, "still frame is not late");
+
+    // Published frame reaches the front at the next swap
+    frame_t* back = frame_buffer_begin_write(fb.get());
+    check(back != nullptr && back != frame_buffer_front(fb.get()), "writes go to the back frame");
+    fill(back, 1);
+    frame_buffer_publish(fb.get());
+    check(uniform(frame_buffer_front(fb.get())) == 0, "published frame waits for the swap");
+    check(frame_buffer_swap(fb.get()) && uniform(frame_buffer_front(fb.get())) == 1, "published frame swapped in");
+    check(!frame_buffer_swap(fb.get()), "one swap per published frame");
+
+    // Swap while the receiver holds the back frame: the front is shown again
+    back = frame_buffer_begin_write(fb.get());
+    check(back != nullptr && back != frame_buffer_front(fb.get()), "second write to the other frame");
+    fill(back, 2);
+    check(!frame_buffer_swap(fb.get()), "frame being written is not swapped in");
+    check(uniform(frame_buffer_front(fb.get())) == 1 && stats(fb.get()).late == 1, "previous frame shown late");
+    frame_buffer_publish(fb.get());
+    check(frame_buffer_swap(fb.get()) && uniform(frame_buffer_front(fb.get())) == 2, "frame swapped in once published");
+
+    // The back frame of a published frame is not handed out again before its swap
+    back = frame_buffer_begin_write(fb.get());
+    fill(back, 3);
+    frame_buffer_publish(fb.get());
+    check(frame_buffer_begin_write(fb.get()) == nullptr && stats(fb.get()).skipped == 1, "frame skipped while pending");
+    check(frame_buffer_swap(fb.get()) && uniform(frame_buffer_front(fb.get())) == 3, "pending frame kept");
+
+    // Aborted write: nothing published, the front stays
+    back = frame_buffer_begin_write(fb.get());
+    fill(back, 4);
+    frame_buffer_abort_write(fb.get());
+    check(!frame_buffer_swap(fb.get()) && uniform(frame_buffer_front(fb.get())) == 3, "aborted frame not shown");
+    frame_buffer_stats_t counters = stats(fb.get());
+    check(counters.shown == 3 && counters.late == 1 && counters.skipped == 1 && counters.aborted == 1,
+          "counters " + std::to_string(counters.shown) + " shown, " + std::to_string(counters.late) + " late, " +
+              std::to_string(counters.skipped) + " skipped, " + std::to_string(counters.aborted) + " aborted");
+}
+
+// Receiver thread publishing frames 1..STRESS_FRAMES as fast as it can, the display
+// swapping and reading the whole front frame in between
+static void test_threads() {
+    std::unique_ptr<frame_buffer_t> fb(new frame_buffer_t);
+    frame_buffer_init(fb.get());
+    std::atomic<bool> done(false);
+    std::thread receiver([&] {
+        for (uint32_t n = 1; n <= STRESS_FRAMES;) {
+            frame_t* back = frame_buffer_begin_write(fb.get());
+            if (!back) {
+                std::this_thread::yield();
+                continue;
+            }
+            fill(back, static_cast<uint16_t>(n));
+            if (n % 7 == 0) {
+                frame_buffer_abort_write(fb.get());
+                fill(frame_buffer_begin_write(fb.get()), static_cast<uint16_t>(n));
+            }
+            frame_buffer_publish(fb.get());
+            n++;
+        }
+        done = true;
+    });
+    int last = 0;
+    bool torn = false;
+    bool ordered = true;
+    while (!done || last < static_cast<int>(STRESS_FRAMES)) {
+        frame_buffer_swap(fb.get());
+        int shown = uniform(frame_buffer_front(fb.get()));
+        torn |= shown < 0;
+        ordered &= shown >= last;
+        last = shown < 0 ? last : shown;
+    }
+    receiver.join();
+    check(!torn, "front frame never torn");
+    check(ordered, "frames shown in order");
+    check(last == static_cast<int>(STRESS_FRAMES), "last frame shown");
+    frame_buffer_stats_t counters = stats(fb.get());
+    check(counters.aborted == STRESS_FRAMES / 7, "aborted writes counted");
+    check(counters.shown >= 1 && counters.shown <= STRESS_FRAMES, "frames shown counted");
+}
+
+int main() {
+    test_sequence();
+    test_threads();
+    return check_result("frame buffer");
+}
@@ -0,0 +1,90 @@
+// Checks of the frame loops of frame_kernels.hpp: the geometries specialised
+// at compile time give the same bytes as the generic loops and as a plain
+// per pixel reference, on padded rows too. Exit status 1 on the first failure.
+#include "frame_kernels.hpp"
+#include "check.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static void check_geometry(std::mt19937& rng, int width, int height, size_t padding) {
+    std::string name = std::to_string(width) + "x" + std::to_string(height);
+    size_t stride = size_t(width) * 3 + padding;
+    std::vector<uint8_t> bgr(stride * height);
+    for (uint8_t& v : bgr) {
+        v = static_cast<uint8_t>(rng());
+    }
+    LevelMap map = LevelMap::fixed(4);
+    map.lut[2][200] = 7;  // Not the same table on every channel
+
+    std::vector<uint8_t> quantized(size_t(width) * height * 3);
+    std::vector<uint8_t> reordered(quantized.size());
+    std::vector<uint8_t> expected_quantized;
+    std::vector<uint8_t> expected_reordered;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t* p = &bgr[y * stride + x * 3];
+            for (int c = 2; c >= 0; c--) {
+                expected_quantized.push_back(map.lut[c][p[c]]);
+                expected_reordered.push_back(p[c]);
+            }
+        }
+    }
+    quantize_rgb(map, bgr.data(), width, height, stride, quantized.data());
+    check(quantized == expected_quantized, "quantize " + name);
+    reorder_rgb(bgr.data(), width, height, stride, reordered.data());
+    check(reordered == expected_reordered, "reorder " + name);
+
+    std::vector<uint8_t> generic(quantized.size());
+    quantize_rgb(FrameGeometry<>(width, height), map, bgr.data(), stride, generic.data());
+    check(generic == quantized, "generic quantize " + name);
+    reorder_rgb(FrameGeometry<>(width, height), bgr.data(), stride, generic.data());
+    check(generic == reordered, "generic reorder " + name);
+}
+
+int main() {
+    std::mt19937 rng(5);
+    check(ProjectorGeometry().width() == PIXELS_PER_LINE && ProjectorGeometry().height() == LINES_PER_FRAME &&
+              ProjectorGeometry().bytes() == size_t(LINES_PER_FRAME) * PIXELS_PER_LINE * 3,
+          "projector geometry");
+    check(FrameGeometry<>(7, 5).bytes() == 105 && HalfProjectorGeometry(1, 1).width() == (PIXELS_PER_LINE + 1) / 2,
+          "run time and compile time bounds");
+
+    check_geometry(rng, PIXELS_PER_LINE, LINES_PER_FRAME, 0);
+    check_geometry(rng, PIXELS_PER_LINE, LINES_PER_FRAME, 12);
+    check_geometry(rng, (PIXELS_PER_LINE + 1) / 2, (LINES_PER_FRAME + 1) / 2, 0);
+    check_geometry(rng, 37, 23, 3);
+
+    // Half to full geometry doubles each pixel, as does the generic scaling
+    int half_width = (PIXELS_PER_LINE + 1) / 2;
+    int half_height = (LINES_PER_FRAME + 1) / 2;
+    std::vector<uint8_t> half(size_t(half_width) * half_height * 3);
+    for (uint8_t& v : half) {
+        v = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> full(ProjectorGeometry().bytes());
+    scale_nearest(half.data(), half_width, half_height, full.data(), PIXELS_PER_LINE, LINES_PER_FRAME);
+    std::vector<uint8_t> generic(full.size());
+    scale_nearest(FrameGeometry<>(half_width, half_height), half.data(),
+                  FrameGeometry<>(PIXELS_PER_LINE, LINES_PER_FRAME), generic.data());
+    check(full == generic, "specialised scaling");
+    bool nearest = true;
+    for (int y = 0; y < LINES_PER_FRAME; y++) {
+        for (int x = 0; x < PIXELS_PER_LINE; x++) {
+            for (int c = 0; c < 3; c++) {
+                nearest = nearest && full[(y * PIXELS_PER_LINE + x) * 3 + c] ==
+                                         half[(y * half_height / LINES_PER_FRAME * half_width +
+                                               x * half_width / PIXELS_PER_LINE) * 3 + c];
+            }
+        }
+    }
+    check(nearest, "nearest pixel");
+    std::vector<uint8_t> odd(5 * 4 * 3);
+    scale_nearest(full.data(), PIXELS_PER_LINE, LINES_PER_FRAME, odd.data(), 5, 4);
+    check(odd[0] == full[0] && odd[3] == full[20 * 3] && odd[5 * 3] == full[25 * PIXELS_PER_LINE * 3],
+          "generic scaling down");
+
+    return check_result("frame kernels");
+}
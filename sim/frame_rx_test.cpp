@@ -0,0 +1,169 @@
+// Random corruption of the byte stream parser of the firmware (frame_rx_feed,
+// frame_rx.h) on Linux. A show of frames goes through it in random chunks,
+// with bytes flipped, dropped, inserted or cut off in some frames. A published
+// frame must always be one of the frames sent, whole, a corrupted frame must
+// not be published torn, and the parser must resynchronise: every clean frame
+// after a clean frame is published. Pure garbage publishes nothing. Exit
+// status 1 on the first failure.
+#include "frame_rx.h"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if FRAME_PALETTE
+#error "frame_rx_test is built without FRAME_PALETTE"
+#endif
+
+static const int FRAMES = 300;
+
+// Word i of line of frame n
+static uint16_t word(int n, int line, int i) {
+    return static_cast<uint16_t>(n * 40503u + line * 977u + i * 31u);
+}
+
+static void append_packet(std::vector<uint8_t>& out, uint8_t type, uint16_t seq, uint16_t line,
+                          const uint8_t* payload, uint16_t len) {
+    frame_proto_header_t header = {};
+    header.type = type;
+    header.frame_seq = seq;
+    header.line = line;
+    header.payload_len = len;
+    header.payload_crc = len ? frame_proto_crc32(0, payload, len) : 0;
+    uint8_t buf[FRAME_PROTO_HEADER_SIZE];
+    frame_proto_encode_header(&header, buf);
+    out.insert(out.end(), buf, buf + sizeof(buf));
+    out.insert(out.end(), payload, payload + len);
+}
+
+// Packets of frame n, as FrameLink sends them
+static std::vector<uint8_t> frame_bytes(int n) {
+    std::vector<uint8_t> out;
+    uint8_t payload[FRAME_PROTO_LINE_SIZE];
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        for (int i = 0; i < PHASES_PER_LINE; i++) {
+            payload[2 * i] = static_cast<uint8_t>(word(n, line, i));
+            payload[2 * i + 1] = static_cast<uint8_t>(word(n, line, i) >> 8);
+        }
+        append_packet(out, FRAME_PROTO_LINE, static_cast<uint16_t>(n), static_cast<uint16_t>(line), payload,
+                      FRAME_PROTO_LINE_SIZE);
+    }
+    append_packet(out, FRAME_PROTO_END, static_cast<uint16_t>(n), 0, nullptr, 0);
+    return out;
+}
+
+// Frame the front holds, -1 if it is not one of the frames sent (torn)
+static int identify(const frame_t* frame) {
+    for (int n = 0; n < FRAMES; n++) {
+        bool same = true;
+        for (int line = 0; line < LINES_PER_FRAME && same; line++) {
+            for (int i = 0; i < PHASES_PER_LINE && same; i++) {
+                same = frame->phases[line][i] == word(n, line, i);
+            }
+        }
+        if (same) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+// Bytes fed in chunks of random size, as a UART or pty delivers them
+static void feed(frame_rx_t* rx, std::mt19937& rng, const std::vector<uint8_t>& bytes) {
+    std::uniform_int_distribution<size_t> chunk(1, 700);
+    for (size_t i = 0; i < bytes.size();) {
+        size_t n = std::min(chunk(rng), bytes.size() - i);
+        frame_rx_feed(rx, bytes.data() + i, n);
+        i += n;
+    }
+}
+
+static void corrupt(std::mt19937& rng, std::vector<uint8_t>& bytes) {
+    std::uniform_int_distribution<size_t> at(0, bytes.size() - 1);
+    size_t i = at(rng);
+    switch (rng() % 4) {
+        case 0:
+            bytes[i] ^= static_cast<uint8_t>(1 + rng() % 255);
+            break;
+        case 1:
+            bytes.erase(bytes.begin() + i);
+            break;
+        case 2: {
+            std::vector<uint8_t> garbage(1 + rng() % 64);
+            for (uint8_t& byte : garbage) {
+                byte = static_cast<uint8_t>(rng());
+            }
+            bytes.insert(bytes.begin() + i, garbage.begin(), garbage.end());
+            break;
+        }
+        default:
+            bytes.resize(i);
+            break;
+    }
+}
+
+static void test_corruption() {
+    std::mt19937 rng(7);
+    std::unique_ptr<frame_buffer_t> fb(new frame_buffer_t);
+    std::unique_ptr<frame_rx_t> rx(new frame_rx_t);
+    frame_buffer_init(fb.get());
+    frame_rx_init(rx.get(), fb.get());
+    std::vector<bool> corrupted(FRAMES);
+    int published = 0;
+    int missed = 0;
+    bool torn = false;
+    for (int n = 0; n < FRAMES; n++) {
+        std::vector<uint8_t> bytes = frame_bytes(n);
+        corrupted[n] = n % 3 == 1;
+        if (corrupted[n]) {
+            corrupt(rng, bytes);
+        }
+        feed(rx.get(), rng, bytes);
+        // The display swaps between frames: the next one finds the back frame free
+        if (frame_buffer_swap(fb.get())) {
+            int shown = identify(frame_buffer_front(fb.get()));
+            torn |= shown != n;
+            published++;
+        } else if (!corrupted[n] && (n == 0 || !corrupted[n - 1])) {
+            missed++;
+        }
+    }
+    check(!torn, "published frames are the frames sent, whole");
+    check(missed == 0, std::to_string(missed) + " clean frames lost after a clean frame");
+    check(published >= FRAMES / 3, "frames published: " + std::to_string(published));
+    check(rx->crc_errors + rx->bad_headers > 0 && rx->frames_incomplete > 0, "corruption counted");
+}
+
+static void test_garbage() {
+    std::mt19937 rng(11);
+    std::unique_ptr<frame_buffer_t> fb(new frame_buffer_t);
+    std::unique_ptr<frame_rx_t> rx(new frame_rx_t);
+    frame_buffer_init(fb.get());
+    frame_rx_init(rx.get(), fb.get());
+    std::vector<uint8_t> garbage(1 << 20);
+    for (size_t i = 0; i < garbage.size(); i++) {
+        // Magic bytes now and then so that headers get parsed and rejected
+        garbage[i] = i % 97 == 0 ? (FRAME_PROTO_MAGIC & 0xFF) : i % 97 == 1 ? (FRAME_PROTO_MAGIC >> 8)
+                                                                            : static_cast<uint8_t>(rng());
+    }
+    feed(rx.get(), rng, garbage);
+    check(!frame_buffer_swap(fb.get()) && rx->frames_completed == 0, "garbage publishes nothing");
+    check(rx->bad_headers > 0, "garbage headers rejected");
+    // The first frame after the garbage gets through: an END closes what the garbage left open
+    std::vector<uint8_t> bytes;
+    append_packet(bytes, FRAME_PROTO_END, 0xFFFF, 0, nullptr, 0);
+    std::vector<uint8_t> frame = frame_bytes(0);
+    bytes.insert(bytes.end(), frame.begin(), frame.end());
+    feed(rx.get(), rng, bytes);
+    check(frame_buffer_swap(fb.get()) && identify(frame_buffer_front(fb.get())) == 0, "frame after the garbage");
+}
+
+int main() {
+    test_corruption();
+    test_garbage();
+    return check_result("frame_rx");
+}
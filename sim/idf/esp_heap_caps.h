@@ -0,0 +1,16 @@
+#pragma once
+#include <stdlib.h>
+#include "sim_rtos.h"
+
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+// All host memory is DMA capable
+static inline void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
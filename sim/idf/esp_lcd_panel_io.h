@@ -0,0 +1,60 @@
+#pragma once
+#include "sim_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// I80 bus of the LCD_CAM peripheral. Only data transfers (lcd_cmd -1) are modelled:
+// each bus word drives its pins for one pixel clock period, seen through
+// Runtime::on_gpio_write, and the transfer done callback runs as an interrupt.
+
+#define ESP_LCD_I80_BUS_WIDTH_MAX 16
+
+typedef struct esp_lcd_i80_bus_t* esp_lcd_i80_bus_handle_t;
+typedef struct esp_lcd_panel_io_t* esp_lcd_panel_io_handle_t;
+
+typedef enum { LCD_CLK_SRC_DEFAULT } lcd_clock_source_t;
+
+typedef struct {
+    int reserved;
+} esp_lcd_panel_io_event_data_t;
+
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t panel_io,
+                                                       esp_lcd_panel_io_event_data_t* edata, void* user_ctx);
+
+typedef struct {
+    int dc_gpio_num;
+    int wr_gpio_num;
+    lcd_clock_source_t clk_src;
+    int data_gpio_nums[ESP_LCD_I80_BUS_WIDTH_MAX];
+    size_t bus_width;
+    size_t max_transfer_bytes;
+} esp_lcd_i80_bus_config_t;
+
+typedef struct {
+    int cs_gpio_num;
+    uint32_t pclk_hz;
+    size_t trans_queue_depth;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void* user_ctx;
+    int lcd_cmd_bits;
+    int lcd_param_bits;
+    struct {
+        unsigned int dc_idle_level: 1;
+        unsigned int dc_cmd_level: 1;
+        unsigned int dc_dummy_level: 1;
+        unsigned int dc_data_level: 1;
+    } dc_levels;
+} esp_lcd_panel_io_i80_config_t;
+
+esp_err_t esp_lcd_new_i80_bus(const esp_lcd_i80_bus_config_t* bus_config, esp_lcd_i80_bus_handle_t* ret_bus);
+esp_err_t esp_lcd_del_i80_bus(esp_lcd_i80_bus_handle_t bus);
+esp_err_t esp_lcd_new_panel_io_i80(esp_lcd_i80_bus_handle_t bus, const esp_lcd_panel_io_i80_config_t* io_config,
+                                   esp_lcd_panel_io_handle_t* ret_io);
+// Waits for a free slot when trans_queue_depth transfers are pending, like the driver
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void* color, size_t color_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+#include "sim_rtos.h"
+
+// Printed with -v only, but always charged the time the console UART would take.
+// Debug logs are below the default log level: compiled out, as on the target.
+#define ESP_LOGE(tag, format, ...) sim_log('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) sim_log('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) sim_log('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { if (0) sim_log('D', tag, format, ##__VA_ARGS__); } while (0)
@@ -0,0 +1,20 @@
+#pragma once
+#include "sim_rtos.h"
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ 100  // CONFIG_FREERTOS_HZ of sdkconfig
+#endif
+#define configMAX_PRIORITIES 25
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms) ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+// The simulator resumes whatever is earliest, there is no context switch to request
+#define portYIELD_FROM_ISR(x) ((void)(x))
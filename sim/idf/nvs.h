@@ -0,0 +1,20 @@
+#pragma once
+#include "sim_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+// Blobs are given to the simulator, see Runtime::set_nvs_blob
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length);
+void nvs_close(nvs_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
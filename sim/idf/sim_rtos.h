@@ -0,0 +1,45 @@
+#pragma once
+
+// Host side implementation of the ESP-IDF and FreeRTOS calls used by the firmware,
+// running in the virtual time of the simulator (see sim/sim_rtos.hpp).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int esp_err_t;
+#define ESP_OK                0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM        0x101
+#define ESP_ERR_INVALID_ARG   0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+const char* esp_err_to_name(esp_err_t err);
+void sim_error_check_failed(esp_err_t err, const char* expression, const char* file, int line);
+
+#define ESP_ERROR_CHECK(x) do {                                     \
+        esp_err_t err_rc_ = (x);                                    \
+        if (err_rc_ != ESP_OK) {                                    \
+            sim_error_check_failed(err_rc_, #x, __FILE__, __LINE__); \
+        }                                                           \
+    } while (0)
+
+// Placement attributes have no meaning on the host
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DMA_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+int64_t esp_timer_get_time(void);
+void esp_rom_delay_us(uint32_t us);
+
+void sim_log(char level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+// Checks of the laser calibration (laser.hpp): drive tables giving the target
+// light on a simulated diode, composed into the quantization tables, the
+// profile file and the fit of the curves on readings. Exit status 1 on the
+// first failure.
+#include "dither.hpp"
+#include "laser.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Light of the simulated diode of curve at a drive value
+static double light(const LaserCurve& curve, int drive) {
+    return drive > curve.black ? std::pow(double(drive - curve.black) / (255 - curve.black), curve.gamma) : 0.0;
+}
+
+static LaserProfile test_profile() {
+    LaserProfile profile;
+    profile.curves[0] = LaserCurve{1.6, 30, 230};
+    profile.curves[1] = LaserCurve{2.0, 20, 255};
+    profile.curves[2] = LaserCurve{1.2, 45, 200};
+    profile.target_gamma = 2.2;
+    return profile;
+}
+
+static void test_tables() {
+    LaserProfile profile = test_profile();
+    ChannelTables rgb = profile.drive_tables(false);
+    ChannelTables bgr = profile.drive_tables(true);
+    check(rgb[0] == bgr[2] && rgb[1] == bgr[1] && rgb[2] == bgr[0], "B G R order");
+    for (int c = 0; c < 3; c++) {
+        const LaserCurve& curve = profile.curves[c];
+        check(rgb[c][0] == 0 && rgb[c][255] == curve.max, "black at 0, max at 255, colour " + std::to_string(c));
+        double worst = 0;
+        for (int v = 1; v < 256; v++) {
+            double want = std::pow(v / 255.0, profile.target_gamma) * light(curve, curve.max);
+            worst = std::max(worst, std::fabs(light(curve, rgb[c][v]) - want) / light(curve, curve.max));
+            check(rgb[c][v] >= rgb[c][v - 1], "drive grows with the value");
+        }
+        // Half a drive step of the steepest part of the curve
+        check(worst < 0.015, "light off its target by " + std::to_string(worst) + ", colour " + std::to_string(c));
+    }
+
+    // One table per channel for the quantization and the calibration
+    ChannelTables drive = profile.drive_tables(true);
+    LevelMap map = LevelMap::fixed(8);
+    map.calibrate(drive);
+    bool composed = true;
+    for (int k = 0; k < 3; k++) {
+        for (int v = 0; v < 256; v++) {
+            composed = composed && map.lut[k][v] == drive[k][seuil(v, 8)];
+        }
+    }
+    check(composed, "calibration composed with seuil");
+
+    // Dithered levels go out calibrated too
+    std::vector<uint8_t> ramp(64 * 3);
+    for (size_t i = 0; i < ramp.size(); i++) {
+        ramp[i] = static_cast<uint8_t>(i / 6);
+    }
+    std::vector<uint8_t> out(ramp.size());
+    Dither dither;
+    dither.apply(map, ramp.data(), 64, 1, out.data());
+    bool calibrated = true;
+    for (size_t i = 0; i < out.size(); i++) {
+        int k = i % 3;
+        bool level = false;
+        for (uint8_t l : map.levels[k]) {
+            level = level || out[i] == drive[k][l];
+        }
+        calibrated = calibrated && level;
+    }
+    check(calibrated, "dithered levels calibrated");
+}
+
+static void test_file() {
+    const std::string path = "laser_test_profile.txt";
+    LaserProfile profile = test_profile();
+    profile.save(path);
+    LaserProfile read = LaserProfile::load(path);
+    check(read.drive_tables(false) == profile.drive_tables(false) && read.target_gamma == 2.2, "profile round trip");
+
+    std::ofstream(path) << "# partial\ngreen 1.5 10 250\n";
+    read = LaserProfile::load(path);
+    check(read.curves[0].gamma == 1.0 && read.curves[1].black == 10 && read.target_gamma == 1.0, "defaults kept");
+
+    for (const char* bad : {"purple 1 0 255\n", "red 1 200 100\n", "red 1.5\n", "target_gamma 0\n"}) {
+        std::ofstream(path) << bad;
+        bool thrown = false;
+        try {
+            LaserProfile::load(path);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        check(thrown, std::string("malformed profile rejected: ") + bad);
+    }
+    std::remove(path.c_str());
+}
+
+static void test_fit() {
+    LaserCurve truth{1.8, 40, 255};
+    std::vector<LaserReading> readings;
+    for (int drive = 0; drive <= 255; drive += 15) {
+        readings.push_back(LaserReading{drive, 5 + 1000 * light(truth, drive)});
+    }
+    readings.push_back(LaserReading{255, 1005});
+    LaserCurve fitted = LaserCurve::fit(readings);
+    check(std::abs(fitted.black - truth.black) <= 2 && std::fabs(fitted.gamma - truth.gamma) < 0.05 && fitted.max == 255,
+          "fit: gamma " + std::to_string(fitted.gamma) + ", black " + std::to_string(fitted.black));
+    LaserCurve capped = LaserCurve::fit(readings, 0.5);
+    check(std::fabs(light(truth, capped.max) - 0.5) < 0.01, "fit: max at half power, " + std::to_string(capped.max));
+}
+
+int main() {
+    test_tables();
+    test_file();
+    test_fit();
+    return check_result("laser");
+}
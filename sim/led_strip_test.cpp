@@ -0,0 +1,249 @@
+// Checks of the led_strip pixel kernels on Linux: the reordering against the
+// per-pixel stores of led_strip_rmt_set_pixel / led_strip_rmt_set_pixel_rgbw, at
+// every alignment and for lengths around the 4 pixel blocks, the SPI encoder
+// against the bit by bit encoding it replaced, the RMT symbol cache against the
+// MSB first bytes encoder, and the integer HSV conversion against the float one
+// of led_strip_set_pixel_hsv, for every input. Exit status 1 on the first failure.
+#include "led_strip_pixels.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_symbol_cache.h"
+#include "check.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// What set_pixel (set_pixel_rgbw with 4 input bytes) writes for each pixel
+static void reference(uint8_t* dst, int bytes_per_pixel, const uint8_t* src, int src_bytes, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, dst += bytes_per_pixel, src += src_bytes) {
+        dst[0] = src[1];
+        dst[1] = src[0];
+        dst[2] = src[2];
+        if (bytes_per_pixel > 3) {
+            dst[3] = src_bytes > 3 ? src[3] : 0;
+        }
+    }
+}
+
+// __led_strip_spi_bit of led_strip_spi_dev.c before the lookup table, on a zeroed buf
+static void reference_spi_bit(uint8_t data, uint8_t* buf) {
+    buf[2] |= data & 0x01 ? 0x06 : 0x04;
+    buf[2] |= data & 0x02 ? 0x30 : 0x20;
+    buf[2] |= data & 0x04 ? 0x80 : 0x00;
+    buf[1] |= 0x01;
+    buf[1] |= data & 0x08 ? 0x0C : 0x08;
+    buf[1] |= data & 0x10 ? 0x60 : 0x40;
+    buf[0] |= data & 0x20 ? 0x03 : 0x02;
+    buf[0] |= data & 0x40 ? 0x18 : 0x10;
+    buf[0] |= data & 0x80 ? 0xC0 : 0x80;
+}
+
+// led_strip_set_pixel_hsv before the integer conversion
+static void reference_hsv(uint16_t hue, uint8_t saturation, uint8_t value, uint8_t rgb[3]) {
+    uint32_t red = 0;
+    uint32_t green = 0;
+    uint32_t blue = 0;
+    uint32_t rgb_max = value;
+    uint32_t rgb_min = rgb_max * (255 - saturation) / 255.0f;
+    uint32_t i = hue / 60;
+    uint32_t diff = hue % 60;
+    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
+    switch (i) {
+    case 0:
+        red = rgb_max;
+        green = rgb_min + rgb_adj;
+        blue = rgb_min;
+        break;
+    case 1:
+        red = rgb_max - rgb_adj;
+        green = rgb_max;
+        blue = rgb_min;
+        break;
+    case 2:
+        red = rgb_min;
+        green = rgb_max;
+        blue = rgb_min + rgb_adj;
+        break;
+    case 3:
+        red = rgb_min;
+        green = rgb_max - rgb_adj;
+        blue = rgb_max;
+        break;
+    case 4:
+        red = rgb_min + rgb_adj;
+        green = rgb_min;
+        blue = rgb_max;
+        break;
+    default:
+        red = rgb_max;
+        green = rgb_min;
+        blue = rgb_max - rgb_adj;
+        break;
+    }
+    rgb[0] = static_cast<uint8_t>(red);
+    rgb[1] = static_cast<uint8_t>(green);
+    rgb[2] = static_cast<uint8_t>(blue);
+}
+
+// Every hue of the documented range with every saturation and value, then every
+// 16-bit hue at every saturation, one value per hue. One call per hue row.
+static void test_hsv() {
+    std::vector<led_strip_hsv_t> hsv(256 * 256);
+    std::vector<uint8_t> got(hsv.size() * 3);
+    uint8_t want[3];
+    uint32_t mismatches = 0;
+    for (uint32_t hue = 0; hue <= 0xFFFF; hue++) {
+        size_t n = 0;
+        for (int s = 0; s < 256; s++) {
+            for (int v = 0; v < 256; v++) {
+                if (hue <= 360 || v == static_cast<int>(hue % 256)) {
+                    hsv[n++] = {static_cast<uint16_t>(hue), static_cast<uint8_t>(s), static_cast<uint8_t>(v)};
+                }
+            }
+        }
+        led_strip_hsv_to_rgb(got.data(), hsv.data(), static_cast<uint32_t>(n));
+        for (size_t i = 0; i < n; i++) {
+            reference_hsv(hsv[i].hue, hsv[i].saturation, hsv[i].value, want);
+            if (memcmp(&got[i * 3], want, 3) != 0 && mismatches++ < 5) {
+                check(false, "HSV " + std::to_string(hsv[i].hue) + "," + std::to_string(hsv[i].saturation) + "," +
+                                 std::to_string(hsv[i].value));
+            }
+        }
+    }
+    check(mismatches == 0, std::to_string(mismatches) + " HSV colors differ from the float conversion");
+}
+
+static void test_spi_encoder(std::mt19937& rng) {
+    for (int v = 0; v < 256; v++) {
+        uint8_t want[3] = {};
+        reference_spi_bit(static_cast<uint8_t>(v), want);
+        uint8_t color = static_cast<uint8_t>(v);
+        uint8_t got[3];
+        led_strip_spi_encode(got, &color, 1);
+        check(memcmp(got, want, sizeof(want)) == 0, "SPI encoding of " + std::to_string(v));
+    }
+
+    // Only the changed pixels are encoded, the result is the full encoding
+    for (int bytes_per_pixel = 3; bytes_per_pixel <= 4; bytes_per_pixel++) {
+        const uint32_t count = 50;
+        std::vector<uint8_t> colors(count * bytes_per_pixel, 0);
+        std::vector<uint8_t> shadow(colors.size(), 0);
+        std::vector<uint8_t> spi(colors.size() * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+        led_strip_spi_encode(spi.data(), colors.data(), colors.size());
+        for (int round = 0; round < 20; round++) {
+            uint32_t changed = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                if (rng() % 4 == 0) {
+                    colors[i * bytes_per_pixel + rng() % bytes_per_pixel] ^= static_cast<uint8_t>(1 + rng() % 255);
+                    changed++;
+                }
+            }
+            uint32_t encoded = led_strip_spi_encode_changed(spi.data(), shadow.data(), colors.data(), count, bytes_per_pixel);
+            std::vector<uint8_t> full(spi.size());
+            led_strip_spi_encode(full.data(), colors.data(), colors.size());
+            check(spi == full, "changed pixels encoding matches the full encoding");
+            check(encoded == changed, "only the changed pixels encoded");
+        }
+    }
+}
+
+// What the RMT bytes encoder with msb_first produces
+static std::vector<uint32_t> reference_symbols(const std::vector<uint8_t>& colors, uint32_t bit0, uint32_t bit1) {
+    std::vector<uint32_t> symbols;
+    for (uint8_t c : colors) {
+        for (int bit = 7; bit >= 0; bit--) {
+            symbols.push_back(c & (1 << bit) ? bit1 : bit0);
+        }
+    }
+    return symbols;
+}
+
+static void test_symbol_cache(std::mt19937& rng) {
+    const uint32_t bit0 = 0x00098003;  // WS2812 at 10 MHz: 3 ticks high, 9 low
+    const uint32_t bit1 = 0x00038009;
+    for (int bytes_per_pixel = 3; bytes_per_pixel <= 4; bytes_per_pixel++) {
+        // Lengths on both sides of the 32 pixel words of the dirty bitmap
+        for (uint32_t count : {1u, 31u, 32u, 33u, 100u}) {
+            std::vector<uint8_t> colors(count * bytes_per_pixel);
+            for (uint8_t& b : colors) {
+                b = static_cast<uint8_t>(rng());
+            }
+            led_strip_symbol_cache_t cache;
+            check(led_strip_symbol_cache_init(&cache, bit0, bit1, count, bytes_per_pixel), "symbol cache allocated");
+            check(led_strip_symbol_cache_update(&cache, colors.data()) == count, "every pixel built the first time");
+            check(led_strip_symbol_cache_update(&cache, colors.data()) == 0, "nothing rebuilt without a change");
+            for (int round = 0; round < 20; round++) {
+                // A run of pixels like set_pixels, and single pixels like set_pixel
+                uint32_t start = rng() % count;
+                uint32_t run = rng() % (count - start + 1);
+                std::vector<bool> dirty(count, false);
+                for (uint32_t i = start; i < start + run; i++) {
+                    colors[i * bytes_per_pixel] = static_cast<uint8_t>(rng());
+                    dirty[i] = true;
+                }
+                led_strip_symbol_cache_mark(&cache, start, run);
+                for (int n = 0; n < 3; n++) {
+                    uint32_t i = rng() % count;
+                    colors[i * bytes_per_pixel + bytes_per_pixel - 1] = static_cast<uint8_t>(rng());
+                    led_strip_symbol_cache_mark(&cache, i, 1);
+                    dirty[i] = true;
+                }
+                uint32_t marked = 0;
+                for (bool d : dirty) {
+                    marked += d;
+                }
+                check(led_strip_symbol_cache_update(&cache, colors.data()) == marked, "only the marked pixels rebuilt");
+                std::vector<uint32_t> want = reference_symbols(colors, bit0, bit1);
+                check(led_strip_symbol_cache_size(&cache) == want.size() * sizeof(uint32_t), "symbol cache size");
+                check(memcmp(cache.symbols, want.data(), want.size() * sizeof(uint32_t)) == 0,
+                      "cached symbols match the bytes encoder, " + std::to_string(count) + " pixels");
+            }
+            led_strip_symbol_cache_free(&cache);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(1);
+    struct Case {
+        const char* name;
+        int bytes_per_pixel;
+        led_strip_color_format_t format;
+        int src_bytes;
+    };
+    const Case cases[] = {
+        {"RGB to GRB", 3, LED_STRIP_COLOR_RGB, 3},
+        {"RGB to GRBW", 4, LED_STRIP_COLOR_RGB, 3},
+        {"RGBW to GRBW", 4, LED_STRIP_COLOR_RGBW, 4},
+    };
+    for (const Case& c : cases) {
+        for (uint32_t count = 0; count <= 19; count++) {
+            for (int offset = 0; offset < 4; offset++) {
+                std::vector<uint8_t> src(offset + count * c.src_bytes);
+                for (uint8_t& b : src) {
+                    b = static_cast<uint8_t>(rng());
+                }
+                // Guard bytes on both sides catch writes outside the range
+                size_t len = count * c.bytes_per_pixel;
+                std::vector<uint8_t> got(offset + len + 8, 0xA5);
+                std::vector<uint8_t> want(got);
+                reference(&want[offset + 4], c.bytes_per_pixel, &src[offset], c.src_bytes, count);
+                check(led_strip_pixels_convert(&got[offset + 4], c.bytes_per_pixel, &src[offset], c.format, count),
+                      std::string(c.name) + ": accepted");
+                check(got == want, std::string(c.name) + ": " + std::to_string(count) + " pixels at offset " +
+                                       std::to_string(offset));
+            }
+        }
+    }
+
+    test_spi_encoder(rng);
+    test_symbol_cache(rng);
+    test_hsv();
+
+    uint8_t buf[8] = {};
+    check(!led_strip_pixels_convert(buf, 3, buf, LED_STRIP_COLOR_RGBW, 1), "RGBW refused on a GRB strip");
+
+    return check_result("led_strip");
+}
@@ -0,0 +1,138 @@
+// Checks of the host quantization levels (levels.hpp): the fixed map is the
+// seuil split of main.cpp, the histogram matches a plain count, the adaptive
+// levels use all their levels on dark and bright frames and move slowly from
+// one frame to the next. Exit status 1 on the first failure.
+#include "levels.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const size_t PIXELS = 100 * 100;
+
+// Noisy gradient between lo and hi on every channel
+static std::vector<uint8_t> frame_between(std::mt19937& rng, int lo, int hi) {
+    std::vector<uint8_t> pixels(PIXELS * 3);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        int v = lo + static_cast<int>((i / 3) * (hi - lo) / PIXELS) + static_cast<int>(rng() % 5) - 2;
+        pixels[i] = static_cast<uint8_t>(std::min(std::max(v, lo), hi));
+    }
+    return pixels;
+}
+
+// Distinct output values of channel k over a frame
+static size_t used_levels(const LevelMap& map, const std::vector<uint8_t>& pixels, int k) {
+    std::vector<uint8_t> out(pixels.size());
+    map.apply(pixels.data(), pixels.size() / 3, out.data());
+    std::vector<uint8_t> values;
+    for (size_t i = k; i < out.size(); i += 3) {
+        values.push_back(out[i]);
+    }
+    std::sort(values.begin(), values.end());
+    return std::unique(values.begin(), values.end()) - values.begin();
+}
+
+static void test_fixed() {
+    bool same = true;
+    for (int plages = 1; plages <= 16; plages++) {
+        LevelMap map = LevelMap::fixed(plages);
+        for (int k = 0; k < 3; k++) {
+            for (int v = 0; v < 256; v++) {
+                same = same && map.lut[k][v] == seuil(v, plages);
+            }
+            same = same && std::is_sorted(map.levels[k].begin(), map.levels[k].end());
+        }
+    }
+    check(same, "fixed map is seuil");
+}
+
+static void test_histogram(std::mt19937& rng) {
+    for (size_t count : {PIXELS, PIXELS + 1, size_t(3), size_t(0)}) {
+        std::vector<uint8_t> pixels(count * 3);
+        for (uint8_t& p : pixels) {
+            p = static_cast<uint8_t>(rng() % 7 == 0 ? rng() : 40);
+        }
+        ChannelHistogram hist;
+        channel_histogram(pixels.data(), count, hist);
+        ChannelHistogram want = {};
+        for (size_t i = 0; i < pixels.size(); i++) {
+            want[i % 3][pixels[i]]++;
+        }
+        check(hist == want, "histogram of " + std::to_string(count) + " pixels");
+    }
+}
+
+static void test_adaptive(std::mt19937& rng) {
+    std::vector<uint8_t> dark = frame_between(rng, 0, 50);
+    std::vector<uint8_t> bright = frame_between(rng, 160, 255);
+    for (const std::vector<uint8_t>* frame : {&dark, &bright}) {
+        AdaptiveLevels levels(8);
+        const LevelMap& map = levels.update(frame->data(), PIXELS);
+        for (int k = 0; k < 3; k++) {
+            check(used_levels(map, *frame, k) == 8, "8 levels used, channel " + std::to_string(k));
+            check(std::is_sorted(map.lut[k].begin(), map.lut[k].end()), "levels in order");
+        }
+    }
+    check(used_levels(LevelMap::fixed(8), bright, 0) == 1, "bright frame on one fixed level");
+
+    // A frame with a single value: one level, that value
+    std::vector<uint8_t> flat(PIXELS * 3, 77);
+    AdaptiveLevels one(8);
+    one.update(flat.data(), PIXELS);
+    check(one.map().levels[0] == std::vector<uint8_t>{77}, "flat frame");
+
+    // Levels follow a change of scene over a few frames, immediately after reset
+    AdaptiveLevels smooth(8);
+    AdaptiveLevels raw(8, 0.0f);
+    for (int i = 0; i < 10; i++) {
+        smooth.update(dark.data(), PIXELS);
+    }
+    raw.update(bright.data(), PIXELS);
+    uint8_t dark_top = smooth.map().levels[0].back();
+    smooth.update(bright.data(), PIXELS);
+    check(smooth.map().levels[0].back() > dark_top && smooth.map().lut[0][200] < raw.map().lut[0][200],
+          "levels move part of the way");
+    for (int i = 0; i < 40; i++) {
+        smooth.update(bright.data(), PIXELS);
+    }
+    check(smooth.map().levels[0] == raw.map().levels[0], "levels settle on the new scene");
+    smooth.update(dark.data(), PIXELS);
+    smooth.reset();
+    smooth.update(bright.data(), PIXELS);
+    check(smooth.map().lut == raw.map().lut, "reset forgets the past frames");
+
+    // Noise between frames of a scene: the smoothed levels barely move
+    AdaptiveLevels noisy(8);
+    AdaptiveLevels unsmoothed(8, 0.0f);
+    int jumps = 0;
+    int raw_jumps = 0;
+    std::vector<uint8_t> last = noisy.update(dark.data(), PIXELS).levels[0];
+    std::vector<uint8_t> raw_last = unsmoothed.update(dark.data(), PIXELS).levels[0];
+    for (int i = 0; i < 30; i++) {
+        std::vector<uint8_t> frame = frame_between(rng, 0, 50 + i % 2 * 10);
+        const std::vector<uint8_t>& now = noisy.update(frame.data(), PIXELS).levels[0];
+        const std::vector<uint8_t>& raw_now = unsmoothed.update(frame.data(), PIXELS).levels[0];
+        for (size_t l = 0; l < now.size() && l < last.size(); l++) {
+            jumps += std::abs(now[l] - last[l]);
+        }
+        for (size_t l = 0; l < raw_now.size() && l < raw_last.size(); l++) {
+            raw_jumps += std::abs(raw_now[l] - raw_last[l]);
+        }
+        last = now;
+        raw_last = raw_now;
+    }
+    check(jumps * 2 < raw_jumps, "smoothing: level changes " + std::to_string(jumps) + ", without " +
+                                     std::to_string(raw_jumps));
+}
+
+int main() {
+    std::mt19937 rng(1);
+    test_fixed();
+    test_histogram(rng);
+    test_adaptive(rng);
+    return check_result("levels");
+}
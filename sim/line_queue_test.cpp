@@ -0,0 +1,107 @@
+// Stress test of the line queue between the two cores of the firmware
+// (line_queue.h) on Linux: a producer and a consumer thread pass LINES_SENT
+// lines, the consumer dropping the rest of a frame now and then as the
+// scan-out does on a motor edge. Every line must arrive whole, in order, and
+// the queue never holds more than LINE_QUEUE_DEPTH lines. Exit status 1 on
+// the first failure.
+#include "line_queue.h"
+#include "check.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+static const uint32_t LINES_SENT = 200000;
+
+// Word i of line n of the show
+static uint16_t word(uint32_t n, int i) {
+    return static_cast<uint16_t>(n * 2654435761u + i);
+}
+
+static void test_limits() {
+    std::unique_ptr<line_queue_t> q(new line_queue_t);
+    line_queue_init(q.get());
+    check(line_queue_peek(q.get()) == nullptr && line_queue_count(q.get()) == 0, "empty queue");
+    for (uint16_t n = 0; n < LINE_QUEUE_DEPTH; n++) {
+        line_slot_t* slot = line_queue_reserve(q.get());
+        check(slot != nullptr, "slot " + std::to_string(n) + " free");
+        if (slot) {
+            slot->line = n;
+            line_queue_commit(q.get());
+        }
+    }
+    check(line_queue_reserve(q.get()) == nullptr && line_queue_count(q.get()) == LINE_QUEUE_DEPTH, "full queue");
+    const line_slot_t* slot = line_queue_peek(q.get());
+    check(slot != nullptr && slot->line == 0, "oldest line first");
+    line_queue_release(q.get());
+    check(line_queue_reserve(q.get()) != nullptr, "released slot free again");
+}
+
+static void test_threads() {
+    std::unique_ptr<line_queue_t> q(new line_queue_t);
+    line_queue_init(q.get());
+    std::thread producer([&] {
+        for (uint32_t n = 0; n < LINES_SENT; n++) {
+            line_slot_t* slot;
+            while ((slot = line_queue_reserve(q.get())) == nullptr) {
+                std::this_thread::yield();
+            }
+            slot->line = static_cast<uint16_t>(n % LINES_PER_FRAME);
+            slot->frame = static_cast<uint16_t>(n / LINES_PER_FRAME);
+            for (int i = 0; i < PHASES_PER_LINE; i++) {
+                slot->phases[i] = word(n, i);
+            }
+            line_queue_commit(q.get());
+        }
+    });
+    uint32_t next = 0;  // Line of the show expected next
+    uint32_t received = 0;
+    uint32_t dropped = 0;
+    bool whole = true;
+    bool ordered = true;
+    bool bounded = true;
+    while (next < LINES_SENT) {
+        bounded &= line_queue_count(q.get()) <= LINE_QUEUE_DEPTH;
+        const line_slot_t* slot = line_queue_peek(q.get());
+        if (!slot) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= slot->line == next % LINES_PER_FRAME;
+        ordered &= slot->frame == static_cast<uint16_t>(next / LINES_PER_FRAME);
+        for (int i = 0; i < PHASES_PER_LINE; i++) {
+            whole &= slot->phases[i] == word(next, i);
+        }
+        line_queue_release(q.get());
+        received++;
+        next++;
+        // Motor edge in the middle of a frame: the rest of it is dropped, as
+        // ETAT_SWAP_BUFFER does by frame number, up to line 0 of the next frame
+        if (next % 1013 == 0) {
+            while (next < LINES_SENT && next % LINES_PER_FRAME != 0) {
+                const line_slot_t* rest = line_queue_peek(q.get());
+                if (!rest) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ordered &= rest->line == next % LINES_PER_FRAME;
+                line_queue_release(q.get());
+                dropped++;
+                next++;
+            }
+        }
+    }
+    producer.join();
+    check(whole, "lines arrive whole");
+    check(ordered, "lines arrive in order");
+    check(bounded, "never more than LINE_QUEUE_DEPTH lines queued");
+    check(received + dropped == LINES_SENT && dropped > 0, "every line received or dropped");
+    check(line_queue_peek(q.get()) == nullptr && line_queue_count(q.get()) == 0, "queue empty at the end");
+}
+
+int main() {
+    test_limits();
+    test_threads();
+    return check_result("line queue");
+}
@@ -0,0 +1,186 @@
+// Checks of the indexed frames (FRAME_PALETTE, this test is built with it) on
+// Linux: the host palette builder and scene tracking, then FrameLink through a
+// pipe into the firmware reassembler, whose lines expanded from the palette must
+// be the bus words of the palette colours. A frame whose palette was lost must
+// not be published. Exit status 1 on the first failure.
+#include "frame_link.hpp"
+#include "frame_rx.h"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if !FRAME_PALETTE
+#error "palette_test is built with FRAME_PALETTE=1"
+#endif
+
+static const size_t PIXELS = LINES_PER_FRAME * PIXELS_PER_LINE;
+
+// Smooth gradient with some noise, like a resized video frame
+static std::vector<uint8_t> gradient(std::mt19937& rng, int shift) {
+    std::vector<uint8_t> rgb(PIXELS * 3);
+    for (int y = 0; y < LINES_PER_FRAME; y++) {
+        for (int x = 0; x < PIXELS_PER_LINE; x++) {
+            uint8_t* p = &rgb[(y * PIXELS_PER_LINE + x) * 3];
+            p[0] = static_cast<uint8_t>((x * 255 / PIXELS_PER_LINE + shift) & 0xFF);
+            p[1] = static_cast<uint8_t>(y * 255 / LINES_PER_FRAME);
+            p[2] = static_cast<uint8_t>(128 + 64 * std::sin((x + y + shift) / 10.0) + rng() % 8);
+        }
+    }
+    return rgb;
+}
+
+static void test_builder(std::mt19937& rng) {
+    // At most PALETTE_SIZE colours, one per histogram bin: found exactly
+    std::vector<uint8_t> rgb(PIXELS * 3);
+    for (size_t i = 0; i < PIXELS; i++) {
+        int color = static_cast<int>(rng() % 200);
+        rgb[i * 3] = static_cast<uint8_t>(color * 8 % 256);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(color / 32 * 32);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(255 - color);
+    }
+    for (unsigned threads : {1u, 4u}) {
+        PaletteBuilder builder(threads);
+        std::vector<Rgb> palette = builder.build(rgb.data(), PIXELS);
+        std::vector<uint8_t> indices(PIXELS);
+        check(palette.size() <= PALETTE_SIZE, "palette size");
+        check(builder.map(rgb.data(), PIXELS, palette, indices.data()) == 0, "few colours kept exactly, " +
+                                                                                  std::to_string(threads) + " threads");
+    }
+
+    // Same result whatever the number of threads
+    std::vector<uint8_t> frame = gradient(rng, 0);
+    std::vector<uint8_t> one(PIXELS);
+    std::vector<uint8_t> four(PIXELS);
+    std::vector<Rgb> palette = PaletteBuilder(1).build(frame.data(), PIXELS);
+    double error = PaletteBuilder(1).map(frame.data(), PIXELS, palette, one.data());
+    check(PaletteBuilder(4).build(frame.data(), PIXELS) == palette, "palette independent of the threads");
+    PaletteBuilder(4).map(frame.data(), PIXELS, palette, four.data());
+    check(one == four, "indices independent of the threads");
+    // Well below a uniform palette of 6 levels per colour
+    std::vector<Rgb> uniform;
+    for (int i = 0; i < 216; i++) {
+        uniform.push_back(Rgb{{static_cast<uint8_t>(i / 36 * 51), static_cast<uint8_t>(i / 6 % 6 * 51),
+                               static_cast<uint8_t>(i % 6 * 51)}});
+    }
+    double uniform_error = PaletteBuilder(1).map(frame.data(), PIXELS, uniform, four.data());
+    check(error * 3 < uniform_error, "gradient error " + std::to_string(error) + ", uniform palette " +
+                                         std::to_string(uniform_error));
+
+    // The scene keeps its palette while the frames fit it
+    ScenePalette scene;
+    std::vector<uint8_t> indices;
+    check(scene.index(frame.data(), PIXELS, indices), "first frame builds a palette");
+    check(!scene.index(gradient(rng, 1).data(), PIXELS, indices), "next frame of the scene reuses it");
+    std::vector<uint8_t> cut(PIXELS * 3);
+    for (size_t i = 0; i < cut.size(); i++) {
+        cut[i] = static_cast<uint8_t>(i % 3 == 0 ? 250 - i % 7 : i % 5);
+    }
+    check(scene.index(cut.data(), PIXELS, indices), "scene change rebuilds it");
+    check(scene.rebuilds() == 2, "two palettes");
+}
+
+// FrameLink writes to a pipe, read back and fed to the firmware parser
+struct Loop {
+    int fds[2];
+    std::unique_ptr<FrameLink> link;
+    std::unique_ptr<frame_buffer_t> fb = std::make_unique<frame_buffer_t>();
+    std::unique_ptr<frame_rx_t> rx = std::make_unique<frame_rx_t>();
+
+    Loop() {
+        if (pipe(fds) < 0) {
+            throw std::runtime_error("pipe");
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        link = std::make_unique<FrameLink>("/proc/self/fd/" + std::to_string(fds[1]));
+        frame_buffer_init(fb.get());
+        frame_rx_init(rx.get(), fb.get());
+    }
+    ~Loop() {
+        link.reset();
+        close(fds[0]);
+        close(fds[1]);
+    }
+    // Deliver what was sent, with one byte flipped at corrupt if >= 0
+    void deliver(long corrupt = -1) {
+        std::vector<uint8_t> buf(1 << 16);
+        ssize_t n;
+        long offset = 0;
+        while ((n = read(fds[0], buf.data(), buf.size())) > 0) {
+            if (corrupt >= offset && corrupt < offset + n) {
+                buf[corrupt - offset] ^= 0x01;
+            }
+            offset += n;
+            frame_rx_feed(rx.get(), buf.data(), n);
+        }
+    }
+};
+
+static void test_link(std::mt19937& rng) {
+    bus_map_t map;
+    bus_map_init(&map);
+    Loop loop;
+    std::vector<uint8_t> rgb = gradient(rng, 0);
+    loop.link->send_frame(rgb);
+    loop.deliver();
+    check(loop.rx->frames_completed == 1, "indexed frame received");
+    check(frame_buffer_swap(loop.fb.get()), "indexed frame published");
+
+    // Expanded lines are the bus words of the palette colours of the pixels
+    const frame_t* frame = frame_buffer_front(loop.fb.get());
+    const std::vector<Rgb>& palette = loop.link->scene_palette().palette();
+    uint16_t got[PHASES_PER_LINE];
+    uint16_t want[PHASES_PER_LINE];
+    uint8_t colors[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+    bool same = true;
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        bus_expand_indices(frame->palette, frame->indices[line], got);
+        for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+            const Rgb& c = palette[frame->indices[line][pixel]];
+            std::copy(c.begin(), c.end(), colors[pixel]);
+        }
+        bus_pack_phases(&map, colors, want);
+        same = same && memcmp(got, want, sizeof(got)) == 0;
+    }
+    check(same, "expanded lines match the packed palette colours");
+
+    // Palette of a new scene corrupted: its frames are dropped until it is sent again
+    std::vector<uint8_t> cut(PIXELS * 3, 0);
+    for (size_t i = 0; i < PIXELS; i++) {
+        cut[i * 3 + 2] = static_cast<uint8_t>(i);
+    }
+    loop.link->send_frame(cut);
+    loop.deliver(FRAME_PROTO_HEADER_SIZE + 100);
+    check(loop.rx->frames_completed == 1 && loop.rx->frames_incomplete == 1, "frame without its palette dropped");
+    check(loop.rx->crc_errors == 1, "corrupt palette counted");
+    for (int i = 0; i < 10; i++) {
+        loop.link->send_frame(cut);
+        loop.deliver();
+        frame_buffer_swap(loop.fb.get());
+    }
+    check(loop.rx->frames_completed > 1, "palette resent, frames published again");
+    check(loop.link->scene_palette().rebuilds() == 2, "palette built once per scene");
+
+    // A scene cut found by the host rebuilds the palette on the next frame
+    loop.link->scene_cut();
+    loop.link->send_frame(cut);
+    loop.deliver();
+    check(loop.link->scene_palette().rebuilds() == 3, "palette rebuilt after a scene cut");
+}
+
+int main() {
+    std::mt19937 rng(1);
+    test_builder(rng);
+    test_link(rng);
+    return check_result("palette");
+}
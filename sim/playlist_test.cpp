@@ -0,0 +1,181 @@
+// Checks of the playlist (playlist.hpp): file parsing, and on made-up clips
+// and stills whose decoder takes DECODE_MS per frame, items played one after
+// the other with no wait at the transitions, cut to their time on screen,
+// looped, and prepared within the memory limit. Exit status 1 on the first
+// failure.
+#include "playlist.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+static const int DECODE_MS = 2;
+
+// Clip of a given number of frames, or still repeated for ever. Every byte of
+// frame n of a clip is n, of a still 255.
+class FakeItem : public FrameSource {
+public:
+    FakeItem(const PlaylistItem& item, uint32_t frames)
+        : still_(item.still), frames_(frames), bytes_(size_t(item.columns) * item.rows * 3) {}
+
+    bool seek(uint32_t frame) override {
+        position_ = frame;
+        return true;
+    }
+
+    bool read(PrefetchedFrame& frame) override {
+        if (!still_ && position_ >= frames_) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(DECODE_MS));
+        frame.index = position_;
+        frame.pixels.assign(bytes_, static_cast<uint8_t>(still_ ? 255 : position_));
+        position_++;
+        return true;
+    }
+
+private:
+    bool still_;
+    uint32_t frames_;
+    size_t bytes_;
+    uint32_t position_ = 0;
+};
+
+// Clips of the length in their name
+static std::unique_ptr<FrameSource> open_item(const PlaylistItem& item) {
+    return std::make_unique<FakeItem>(item, item.still ? 0 : std::stoul(item.name));
+}
+
+static PlaylistItem item(const std::string& name, bool still = false, double seconds = 0) {
+    PlaylistItem item;
+    item.name = name;
+    item.still = still;
+    item.fps = 20;
+    item.columns = 10;
+    item.rows = 10;
+    item.seconds = seconds;
+    return item;
+}
+
+// (item, frame index) of every frame played, at the pace of a show slower than the decoder
+static std::vector<std::pair<size_t, uint32_t>> play(PlaylistPlayer& player, size_t max_frames = 1000) {
+    std::vector<std::pair<size_t, uint32_t>> played;
+    PrefetchedFrame frame;
+    size_t index;
+    while (played.size() < max_frames) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DECODE_MS * 2));
+        if (!player.next(frame, index)) {
+            break;
+        }
+        played.emplace_back(index, frame.index);
+    }
+    return played;
+}
+
+static std::vector<std::pair<size_t, uint32_t>> expected(const std::vector<std::pair<size_t, uint32_t>>& items) {
+    std::vector<std::pair<size_t, uint32_t>> frames;
+    for (const auto& item : items) {
+        for (uint32_t i = 0; i < item.second; i++) {
+            frames.emplace_back(item.first, i);
+        }
+    }
+    return frames;
+}
+
+// Playlist file of this run
+static std::string playlist_path() {
+    return "playlist_test." + std::to_string(getpid()) + ".txt";
+}
+
+static bool load_throws(const std::string& text) {
+    std::string path = playlist_path();
+    std::ofstream(path) << text;
+    bool thrown = false;
+    try {
+        load_playlist(path);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    std::remove(path.c_str());
+    return thrown;
+}
+
+int main() {
+    // Playlist file
+    std::string path = playlist_path();
+    std::ofstream(path) << "# show\n"
+                           "video Video.mp4\n"
+                           "\n"
+                           "image logo.png seconds=5 plages=2\n"
+                           "video intro.mp4 fps=25 size=50x40 seconds=2.5\n";
+    std::vector<PlaylistItem> items = load_playlist(path);
+    std::remove(path.c_str());
+    check(items.size() == 3, "three items");
+    check(!items[0].still && items[0].name == "Video.mp4" && items[0].fps == 0 && items[0].plages == 0 &&
+              items[0].columns == 0 && items[0].seconds == 0,
+          "item without overrides");
+    check(items[1].still && items[1].name == "logo.png" && items[1].seconds == 5 && items[1].plages == 2, "still");
+    check(items[2].fps == 25 && items[2].columns == 50 && items[2].rows == 40 && items[2].frames() == 63,
+          "clip with overrides");
+    check(load_throws("clip a.mp4\n"), "unknown kind");
+    check(load_throws("video\n"), "no file");
+    check(load_throws("video a.mp4 fps=0\n"), "bad frame rate");
+    check(load_throws("video a.mp4 size=50\n"), "bad size");
+    check(load_throws("video a.mp4 plages=4x\n"), "trailing characters");
+    check(load_throws("video a.mp4 speed=2\n"), "unknown option");
+
+    // Items one after the other, the still and the last clip cut to their time
+    {
+        PlaylistPlayer player({item("15"), item("still", true, 0.5), item("30", false, 0.6)}, open_item, 4, 1 << 20);
+        check(play(player) == expected({{0, 15}, {1, 10}, {2, 12}}), "items in order, cut to their time");
+        check(player.stalls() <= 1, "no wait at the transitions: " + std::to_string(player.stalls()));
+    }
+
+    // Items with no frame are passed
+    {
+        PlaylistPlayer player({item("0"), item("5"), item("0"), item("3")}, open_item, 4, 1 << 20);
+        check(play(player) == expected({{1, 5}, {3, 3}}), "empty items passed");
+    }
+
+    // Loop round the playlist
+    {
+        PlaylistPlayer player({item("5"), item("4")}, open_item, 4, 1 << 20, true);
+        check(play(player, 27) == expected({{0, 5}, {1, 4}, {0, 5}, {1, 4}, {0, 5}, {1, 4}}), "loops");
+        check(player.stalls() <= 1, "no wait at the loops: " + std::to_string(player.stalls()));
+        PlaylistPlayer single({item("3")}, open_item, 4, 1 << 20, true);
+        check(play(single, 7) == expected({{0, 3}, {0, 3}, {0, 1}}), "single item loop");
+    }
+
+    // Memory limit of the prepared item: frames of 10x10 pixels are 300 bytes
+    {
+        PlaylistPlayer player({item("5"), item("5")}, open_item, 8, 1000);
+        check(player.prepared_depth(item("5")) == 3, "prepared frames within the limit");
+        PlaylistItem large = item("5");
+        large.columns = 100;
+        large.rows = 100;
+        check(player.prepared_depth(large) == 1, "at least one frame prepared");
+        PlaylistPlayer roomy({item("5")}, open_item, 8, 1 << 20);
+        check(roomy.prepared_depth(large) == 8, "no more than the depth");
+        check(play(player) == expected({{0, 5}, {1, 5}}), "playing with the limit");
+    }
+
+    bool thrown = false;
+    try {
+        PlaylistItem unresolved = item("5");
+        unresolved.fps = 0;
+        PlaylistPlayer player({unresolved}, open_item, 4, 1 << 20);
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    check(thrown, "items need their frame rate and size");
+
+    return check_result("playlist");
+}
@@ -0,0 +1,159 @@
+// Checks of the decode-ahead buffer (prefetch.hpp) on a made-up video file
+// whose decoder takes DECODE_MS per frame and seeks from the keyframe before
+// its target: frames in order, no wait once the buffer is full, cue jumps and
+// loops that land on their frame with no wait, and decoder errors passed on.
+// Exit status 1 on the first failure.
+#include "prefetch.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint32_t FRAMES = 60;
+static const uint32_t KEYFRAME_INTERVAL = 12;
+static const int DECODE_MS = 2;
+static const size_t DEPTH = 4;
+
+// Frame n holds n in each of its bytes
+class FakeVideo : public FrameSource {
+public:
+    explicit FakeVideo(uint32_t fail_at = FRAMES + 1) : fail_at_(fail_at) {}
+
+    bool seek(uint32_t frame) override {
+        if (frame >= FRAMES) {
+            return false;
+        }
+        // Decodes from the keyframe before, as a video decoder does
+        std::this_thread::sleep_for(std::chrono::milliseconds(DECODE_MS * (frame % KEYFRAME_INTERVAL)));
+        position_ = frame;
+        return true;
+    }
+
+    bool read(PrefetchedFrame& frame) override {
+        if (position_ == fail_at_) {
+            throw std::runtime_error("Corrupt frame");
+        }
+        if (position_ >= FRAMES) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(DECODE_MS));
+        frame.index = position_;
+        frame.pixels.assign(30, static_cast<uint8_t>(position_));
+        position_++;
+        return true;
+    }
+
+private:
+    uint32_t position_ = 0;
+    uint32_t fail_at_;
+};
+
+static SourceFactory fake_video(uint32_t fail_at = FRAMES + 1) {
+    return [fail_at] { return std::make_unique<FakeVideo>(fail_at); };
+}
+
+// Frames at the pace of a show slower than the decoder
+static bool next_frame(FramePrefetcher& prefetcher, PrefetchedFrame& frame) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(DECODE_MS * 2));
+    return prefetcher.next(frame);
+}
+
+static void wait_ready(const FramePrefetcher& prefetcher, size_t cue) {
+    while (!prefetcher.cue_ready(cue)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+int main() {
+    // The whole file in order, then the end
+    {
+        FramePrefetcher prefetcher(fake_video(), DEPTH);
+        PrefetchedFrame frame;
+        bool in_order = true;
+        uint32_t count = 0;
+        while (next_frame(prefetcher, frame)) {
+            in_order = in_order && frame.index == count && frame.pixels[0] == count;
+            count++;
+        }
+        check(in_order && count == FRAMES, "every frame in order");
+        // Only the first frame is waited for, the decoder stays ahead
+        check(prefetcher.stalls() <= 1, "no wait once started: " + std::to_string(prefetcher.stalls()));
+        check(!prefetcher.next(frame), "end of the file");
+    }
+
+    // Cue jumps land on their frame, prepared in the background
+    {
+        FramePrefetcher prefetcher(fake_video(), DEPTH, {35, 11});
+        PrefetchedFrame frame;
+        for (int i = 0; i < 5; i++) {
+            next_frame(prefetcher, frame);
+        }
+        wait_ready(prefetcher, 0);
+        uint32_t stalls = prefetcher.stalls();
+        prefetcher.jump(0);
+        bool at_cue = next_frame(prefetcher, frame) && frame.index == 35;
+        bool after = true;
+        for (uint32_t i = 36; i < 45; i++) {
+            after = after && next_frame(prefetcher, frame) && frame.index == i;
+        }
+        check(at_cue && after, "jump to a cue and on from there");
+        wait_ready(prefetcher, 1);
+        prefetcher.jump(1);
+        check(next_frame(prefetcher, frame) && frame.index == 11, "second cue");
+        // The cue left is ready again for the next jump
+        wait_ready(prefetcher, 0);
+        prefetcher.jump(0);
+        check(next_frame(prefetcher, frame) && frame.index == 35, "same cue twice");
+        check(prefetcher.stalls() == stalls && prefetcher.jumps() == 3, "no wait on jumps");
+
+        bool thrown = false;
+        try {
+            prefetcher.jump(2);
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        check(thrown, "unknown cue");
+    }
+
+    // Loop: the first frame follows the last one with no wait
+    {
+        FramePrefetcher prefetcher(fake_video(), DEPTH, {}, true);
+        PrefetchedFrame frame;
+        bool in_order = true;
+        for (uint32_t i = 0; i < FRAMES * 2 + 10; i++) {
+            in_order = in_order && next_frame(prefetcher, frame) && frame.index == i % FRAMES;
+        }
+        check(in_order && prefetcher.loops() == 2, "seamless loops");
+        check(prefetcher.stalls() <= 1, "no wait at the loop: " + std::to_string(prefetcher.stalls()));
+    }
+
+    // Jumps in quick succession, decoders stopped mid seek
+    {
+        FramePrefetcher prefetcher(fake_video(), DEPTH, {23, 47, 5});
+        PrefetchedFrame frame;
+        for (int i = 0; i < 20; i++) {
+            prefetcher.jump(i % 3);
+        }
+        check(prefetcher.next(frame) && frame.index == 47, "last jump wins");
+    }
+
+    // Decoder errors reach the show
+    {
+        FramePrefetcher prefetcher(fake_video(3), DEPTH);
+        PrefetchedFrame frame;
+        bool thrown = false;
+        try {
+            while (prefetcher.next(frame)) {
+            }
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        check(thrown && frame.index == 2, "decoder error after the frames before it");
+    }
+
+    return check_result("prefetch");
+}
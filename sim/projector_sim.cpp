@@ -0,0 +1,376 @@
+// Runs the firmware state machine against simulated motor and mirror signals and
+// renders what the projector would show, from the GPIO writes and their timing.
+// Usage: projector_sim [options] <out.png>
+//   --seconds S       simulated duration (2)
+//   --motor-hz F      motor interrupts per second (10)
+//   --mirror-hz F     mirror interrupts per second (1000)
+//   --jitter-us J     standard deviation of the edge times (2)
+//   --glitch-rate G   spurious mirror edges per second (0)
+//   --facets N        facets of the polygon mirror (1)
+//   --facet-error-us E  standard deviation of the facet angle errors (0)
+//   --image FILE      still frame received on the link
+//   --anim FILE       content of the animation partition (tools/anim_pack)
+//   --calib FILE      calibration table in NVS (tools/calib_gen)
+//   --backend B       scan-out backend, i80 (DMA) or gpio (i80)
+//   --gpio-us T       cost of one gpio_set_level (0.1)
+//   --isr-us T        cost of one GPIO interrupt (2)
+//   --baud B          console UART speed, 0 for free logs (115200)
+//   --frame N         revolution to render, default the last one
+//   --scale K         output pixel size (4)
+//   --min-fps F       exit with status 1 below this frame rate
+//   --seed N          random seed (1)
+//   -v                print the firmware logs
+#include "sim_rtos.hpp"
+#include "sim_firmware.h"
+#include "anim_flash.h"
+#include "calib.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Options {
+    double seconds = 2;
+    double motor_hz = 10;
+    double mirror_hz = 1000;
+    double jitter_us = 2;
+    double glitch_rate = 0;
+    int facets = 1;
+    double facet_error_us = 0;
+    std::string image;
+    std::string anim;
+    std::string calib;
+    std::string backend = "i80";
+    double gpio_us = 0.1;
+    double isr_us = 2;
+    uint32_t baud = 115200;
+    int frame = -1;
+    int scale = 4;
+    double min_fps = 0;
+    unsigned seed = 1;
+    bool verbose = false;
+    std::string output;
+};
+
+static Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-v") {
+            options.verbose = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            options.output = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--seconds") options.seconds = std::stod(value);
+        else if (arg == "--motor-hz") options.motor_hz = std::stod(value);
+        else if (arg == "--mirror-hz") options.mirror_hz = std::stod(value);
+        else if (arg == "--jitter-us") options.jitter_us = std::stod(value);
+        else if (arg == "--glitch-rate") options.glitch_rate = std::stod(value);
+        else if (arg == "--image") options.image = value;
+        else if (arg == "--anim") options.anim = value;
+        else if (arg == "--calib") options.calib = value;
+        else if (arg == "--facets") options.facets = std::stoi(value);
+        else if (arg == "--facet-error-us") options.facet_error_us = std::stod(value);
+        else if (arg == "--backend") options.backend = value;
+        else if (arg == "--gpio-us") options.gpio_us = std::stod(value);
+        else if (arg == "--isr-us") options.isr_us = std::stod(value);
+        else if (arg == "--baud") options.baud = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--frame") options.frame = std::stoi(value);
+        else if (arg == "--scale") options.scale = std::stoi(value);
+        else if (arg == "--min-fps") options.min_fps = std::stod(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned>(std::stoul(value));
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+    if (options.output.empty()) {
+        throw std::invalid_argument("Usage: projector_sim [options] <out.png>");
+    }
+    if (options.backend != "i80" && options.backend != "gpio") {
+        throw std::invalid_argument("Unknown backend " + options.backend);
+    }
+    return options;
+}
+
+// What the generator knows about an edge and the firmware does not
+struct EdgeInfo {
+    bool glitch;
+    double sweep_offset_us;  // Start of the optical sweep relative to the mirror edge
+};
+
+// Discrete-event generator of the sensor edges. Edges are the nominal positions of
+// the rotating parts plus independent noise, so the jitter does not accumulate.
+// Each mirror facet has its own angle error: its edge comes early or late, and its
+// sweep starts at its own offset from the edge.
+class SignalGenerator {
+public:
+    SignalGenerator(const Options& options, const sim_pins_t& pins)
+        : pins_(pins), rng_(options.seed), jitter_(0, options.jitter_us),
+          motor_period_(1e6 / options.motor_hz), mirror_period_(1e6 / options.mirror_hz),
+          glitch_rate_(options.glitch_rate) {
+        next_glitch_ = glitch_rate_ > 0 ? draw_glitch(0) : 1e300;
+        std::normal_distribution<double> facet_error(0, options.facet_error_us);
+        for (int f = 0; f < std::max(1, options.facets); f++) {
+            edge_error_.push_back(options.facet_error_us > 0 ? facet_error(rng_) : 0);
+            sweep_offset_.push_back(options.facet_error_us > 0 ? facet_error(rng_) : 0);
+        }
+    }
+
+    // Next edge in time order
+    sim::Edge next(EdgeInfo& info) {
+        // First motor edge after one period, mirror edges half a line later than the motor
+        size_t facet = mirror_index_ % edge_error_.size();
+        double motor = motor_period_ * (motor_index_ + 1);
+        double mirror = mirror_period_ * (mirror_index_ + 0.5) + edge_error_[facet];
+        info = {false, 0};
+        sim::Edge edge;
+        if (next_glitch_ < motor && next_glitch_ < mirror) {
+            edge = {next_glitch_, pins_.mirror};
+            next_glitch_ = draw_glitch(next_glitch_);
+            info.glitch = true;
+        } else if (motor <= mirror) {
+            edge = {motor + jitter_(rng_), pins_.motor};
+            motor_index_++;
+        } else {
+            edge = {mirror + jitter_(rng_), pins_.mirror};
+            info.sweep_offset_us = sweep_offset_[facet];
+            mirror_index_++;
+        }
+        // Noise must not reorder the edges
+        edge.time_us = std::max(edge.time_us, last_time_);
+        last_time_ = edge.time_us;
+        return edge;
+    }
+
+    double mirror_period() const { return mirror_period_; }
+
+private:
+    double draw_glitch(double after) {
+        return after + std::exponential_distribution<double>(glitch_rate_ / 1e6)(rng_);
+    }
+
+    sim_pins_t pins_;
+    std::mt19937 rng_;
+    std::normal_distribution<double> jitter_;
+    double motor_period_;
+    double mirror_period_;
+    double glitch_rate_;
+    double next_glitch_;
+    std::vector<double> edge_error_;
+    std::vector<double> sweep_offset_;
+    uint64_t motor_index_ = 0;
+    uint64_t mirror_index_ = 0;
+    double last_time_ = 0;
+};
+
+// Light that reached the screen: a colour select pulse shows the data bus at the
+// position the mirror had at that moment
+class Screen {
+public:
+    Screen(const sim_pins_t& pins, double mirror_period, int render_frame)
+        : pins_(pins), mirror_period_(mirror_period), render_frame_(render_frame) {
+        new_revolution();
+    }
+
+    // The sweep in progress still belongs to the revolution, it ends at the next mirror edge
+    void motor_edge() {
+        closing_ = true;
+    }
+
+    void mirror_edge(double time_us, const EdgeInfo& info) {
+        if (info.glitch) {
+            return;
+        }
+        if (closing_) {
+            close_revolution();
+        }
+        row_++;
+        line_start_ = time_us + info.sweep_offset_us;
+    }
+
+    void gpio_write(int pin, int level, double time_us) {
+        bool was_high = levels_[pin];
+        levels_[pin] = level;
+        for (int channel = 0; channel < BYTES_PER_PIXEL; channel++) {
+            if (pin == pins_.select[channel] && level && !was_high) {
+                latch(channel, time_us);
+            }
+        }
+    }
+
+    uint64_t revolutions = 0;
+    uint64_t complete_frames = 0;
+    uint64_t lines_displayed = 0;
+    uint64_t pixels_shown = 0;
+    uint64_t off_screen = 0;
+    cv::Mat image;
+    int rendered = -1;
+
+private:
+    void close_revolution() {
+        closing_ = false;
+        if (revolution_ >= 0) {
+            // The revolution before the first motor edge is only the start-up
+            revolutions++;
+            int complete_lines = 0;
+            for (int row = 0; row < LINES_PER_FRAME; row++) {
+                complete_lines += row_pixels_[row] >= PIXELS_PER_LINE;
+                pixels_shown += std::min(row_pixels_[row], PIXELS_PER_LINE);
+            }
+            lines_displayed += complete_lines;
+            if (complete_lines == LINES_PER_FRAME) {
+                complete_frames++;
+            }
+            if (render_frame_ < 0 || revolution_ == render_frame_) {
+                image = canvas_.clone();
+                rendered = revolution_;
+            }
+        }
+        revolution_++;
+        new_revolution();
+    }
+
+    void new_revolution() {
+        canvas_ = cv::Mat::zeros(LINES_PER_FRAME, PIXELS_PER_LINE, CV_8UC3);
+        std::fill(std::begin(row_pixels_), std::end(row_pixels_), 0);
+        row_ = -1;
+    }
+
+    void latch(int channel, double time_us) {
+        int column = static_cast<int>((time_us - line_start_) / mirror_period_ * PIXELS_PER_LINE);
+        if (revolution_ < 0 || row_ < 0 || row_ >= LINES_PER_FRAME || column < 0 || column >= PIXELS_PER_LINE) {
+            off_screen++;
+            return;
+        }
+        uint8_t value = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            value |= levels_[pins_.data[bit]] << bit;
+        }
+        // The canvas is BGR for imwrite
+        canvas_.at<cv::Vec3b>(row_, column)[2 - channel] = value;
+        if (channel == 0) {
+            row_pixels_[row_]++;  // A pixel is a red, green, blue pulse sequence
+        }
+    }
+
+    sim_pins_t pins_;
+    double mirror_period_;
+    int render_frame_;
+    int revolution_ = -1;
+    int row_ = -1;
+    bool closing_ = false;
+    int row_pixels_[LINES_PER_FRAME] = {};
+    double line_start_ = 0;
+    uint8_t levels_[64] = {};
+    cv::Mat canvas_;
+};
+
+int main(int argc, char** argv) {
+    Options options = parse_options(argc, argv);
+    sim::Runtime& runtime = sim::Runtime::instance();
+    runtime.verbose = options.verbose;
+    runtime.cost.gpio_us = options.gpio_us;
+    runtime.cost.isr_us = options.isr_us;
+    runtime.cost.console_baud = options.baud;
+    sim_firmware_use_i80(options.backend == "i80");
+
+    cv::Mat frame;
+    if (!options.image.empty()) {
+        frame = cv::imread(options.image, cv::IMREAD_COLOR);
+        if (frame.empty()) {
+            throw std::runtime_error("Could not read " + options.image);
+        }
+        cv::resize(frame, frame, cv::Size(PIXELS_PER_LINE, LINES_PER_FRAME), 0, 0, cv::INTER_AREA);
+        cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+        sim_link_set_frame(frame.data);
+    }
+    if (!options.anim.empty()) {
+        std::ifstream file(options.anim, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Could not read " + options.anim);
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        runtime.add_partition(ANIM_PARTITION_LABEL, ANIM_PARTITION_SUBTYPE, std::move(data));
+    }
+    if (!options.calib.empty()) {
+        std::ifstream file(options.calib, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Could not read " + options.calib);
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        runtime.set_nvs_blob(CALIB_NVS_NAMESPACE, CALIB_NVS_KEY, std::move(data));
+    }
+
+    sim_pins_t pins;
+    sim_firmware_pins(&pins);
+    SignalGenerator generator(options, pins);
+    Screen screen(pins, generator.mirror_period(), options.frame);
+
+    uint64_t motor_edges = 0;
+    uint64_t mirror_edges = 0;
+    uint64_t glitches = 0;
+    std::deque<EdgeInfo> edge_infos;
+    runtime.on_gpio_write = [&](int pin, int level, double time_us) { screen.gpio_write(pin, level, time_us); };
+    runtime.on_edge = [&](const sim::Edge& edge) {
+        EdgeInfo info = edge_infos.front();
+        edge_infos.pop_front();
+        if (edge.pin == pins.motor) {
+            motor_edges++;
+            screen.motor_edge();
+        } else {
+            mirror_edges += !info.glitch;
+            glitches += info.glitch;
+            screen.mirror_edge(edge.time_us, info);
+        }
+    };
+    runtime.run(app_main, options.seconds * 1e6, [&] {
+        EdgeInfo info;
+        sim::Edge edge = generator.next(info);
+        edge_infos.push_back(info);
+        return edge;
+    });
+
+    sim_counters_t counters;
+    sim_firmware_counters(&counters);
+    double fps = screen.complete_frames / options.seconds;
+    double pixels = static_cast<double>(LINES_PER_FRAME) * PIXELS_PER_LINE;
+    double shown = screen.revolutions ? screen.pixels_shown / static_cast<double>(screen.revolutions) : 0;
+    std::cout << std::fixed << std::setprecision(1)
+              << "Simulated " << options.seconds << " s: " << motor_edges << " motor edges, "
+              << mirror_edges << " mirror edges, " << glitches << " glitches" << std::endl
+              << "Frames: " << screen.complete_frames << " complete of " << screen.revolutions
+              << " revolutions, " << fps << " fps (motor " << options.motor_hz << " Hz), "
+              << (screen.revolutions ? screen.lines_displayed / static_cast<double>(screen.revolutions) : 0)
+              << " complete lines per revolution" << std::endl
+              << "Pixels: " << shown << " of " << pixels << " per revolution ("
+              << 100.0 * std::max(0.0, pixels - shown) / pixels << "% dropped), " << screen.off_screen
+              << " colour pulses off screen" << std::endl
+              << "Lines: " << counters.overrun << " overrun, " << counters.underrun << " underrun, "
+              << counters.dropped << " dropped" << std::endl;
+
+    if (screen.image.empty()) {
+        std::cerr << "No complete revolution to render" << std::endl;
+    } else {
+        cv::Mat out;
+        cv::resize(screen.image, out, cv::Size(), options.scale, options.scale, cv::INTER_NEAREST);
+        cv::imwrite(options.output, out);
+        std::cout << "Revolution " << screen.rendered << " written to " << options.output << std::endl;
+    }
+    return fps < options.min_fps ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+// Checks of the QoS governor (qos.hpp) on made-up frame times: it degrades in
+// order under load, holds its level within the hysteresis band and comes back
+// one step at a time with headroom, logging each change. Exit status 1 on the
+// first failure.
+#include "qos.hpp"
+#include "check.hpp"
+
+#include <iostream>
+#include <string>
+
+// Records frames frames of ms each, returns the number of level changes
+static int run(QosGovernor& qos, int frames, double ms) {
+    int changes = 0;
+    for (int i = 0; i < frames; i++) {
+        changes += qos.record(ms);
+    }
+    return changes;
+}
+
+int main() {
+    QosGovernor qos(100.0);
+    check(run(qos, 100, 90) == 0 && qos.level() == QosGovernor::FULL, "frames within budget");
+    check(qos.dither() && qos.plages(8) == 8 && !qos.skip(1) && !qos.low_resolution(), "nothing degraded");
+
+    // Isolated misses do not count
+    for (int i = 0; i < 50; i++) {
+        qos.record(i % 5 == 0 ? 150 : 60);
+    }
+    check(run(qos, 10, 60) == 0 && qos.level() == QosGovernor::FULL, "two misses in a window are tolerated");
+
+    // Sustained overload: one level per 3 misses, in order, down to the last one
+    check(run(qos, 3, 150) == 1 && qos.level() == QosGovernor::NO_DITHER, "first step: no dithering");
+    check(!qos.dither() && qos.plages(8) == 8, "only the dithering is off");
+    run(qos, 3, 150);
+    check(qos.level() == QosGovernor::FEWER_LEVELS && qos.plages(8) == 4 && qos.plages(3) == 2 && qos.plages(1) == 1,
+          "second step: half the levels");
+    run(qos, 3, 150);
+    check(qos.level() == QosGovernor::HALF_RATE && qos.skip(1) && !qos.skip(2), "third step: every other frame");
+    // At half rate the budget is two periods
+    check(run(qos, 50, 150) == 0, "half rate absorbs 1.5 periods");
+    run(qos, 3, 250);
+    check(qos.level() == QosGovernor::LOW_RESOLUTION && qos.low_resolution(), "fourth step: low resolution");
+    check(run(qos, 50, 500) == 0, "nothing below the last level");
+
+    // The log has every change, in order
+    const std::vector<QosGovernor::Change>& down = qos.changes();
+    bool steps = down.size() == 4;
+    for (size_t i = 0; i < down.size(); i++) {
+        steps = steps && down[i].to == down[i].from + 1 && (i == 0 || down[i].frame > down[i - 1].frame);
+    }
+    check(steps, "one level at a time, logged");
+    check(down[0].from == QosGovernor::FULL && down[0].mean_ms > 80, "change logged with its load");
+    check(std::string(QosGovernor::name(QosGovernor::HALF_RATE)) == "half rate", "level names");
+
+    // From the last level: between half the budget and the budget the level holds
+    QosGovernor slow(100.0);
+    run(slow, 12, 1000);
+    check(slow.level() == QosGovernor::LOW_RESOLUTION, "straight down under heavy load");
+    check(run(slow, 200, 150) == 0, "hysteresis band");
+    // Headroom: one level up after the hold of 30 frames at the level, no sooner
+    QosGovernor fast(100.0);
+    run(fast, 12, 1000);
+    check(run(fast, 29, 50) == 0, "held 30 frames");
+    check(run(fast, 1, 50) == 1 && fast.level() == QosGovernor::HALF_RATE, "one step up");
+    check(run(fast, 29, 10) == 0 && run(fast, 1, 10) == 1 && fast.level() == QosGovernor::FEWER_LEVELS,
+          "next step after another hold");
+    run(fast, 60, 10);
+    check(fast.level() == QosGovernor::FULL && fast.changes().size() == 8, "back to full");
+
+    return check_result("qos");
+}
@@ -0,0 +1,85 @@
+// Checks of the area downscaler (area_resize.hpp) against the plain mean of
+// each block of source pixels: integer ratios of their own code, other ratios,
+// padded source rows and blocks too tall for 16 bit sums. Exit status 1 on the
+// first failure.
+#include "area_resize.hpp"
+#include "check.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Mean of the whole pixel blocks, one pixel at a time
+static std::vector<uint8_t> reference(const std::vector<uint8_t>& src, int sw, int sh, size_t stride, int dw, int dh) {
+    std::vector<uint8_t> out(size_t(dw) * dh * 3);
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            int y0 = int(int64_t(y) * sh / dh), y1 = int(int64_t(y + 1) * sh / dh);
+            int x0 = int(int64_t(x) * sw / dw), x1 = int(int64_t(x + 1) * sw / dw);
+            for (int c = 0; c < 3; c++) {
+                uint64_t sum = 0;
+                for (int j = y0; j < y1; j++) {
+                    for (int i = x0; i < x1; i++) {
+                        sum += src[j * stride + i * 3 + c];
+                    }
+                }
+                uint64_t count = uint64_t(y1 - y0) * (x1 - x0);
+                out[(size_t(y) * dw + x) * 3 + c] = static_cast<uint8_t>((sum + count / 2) / count);
+            }
+        }
+    }
+    return out;
+}
+
+static void check_resize(std::mt19937& rng, int sw, int sh, int dw, int dh, size_t padding = 0) {
+    size_t stride = size_t(sw) * 3 + padding;
+    std::vector<uint8_t> src(stride * sh);
+    for (uint8_t& v : src) {
+        v = static_cast<uint8_t>(rng());
+    }
+    AreaDownscaler area;
+    std::vector<uint8_t> out(size_t(dw) * dh * 3);
+    area.resize(src.data(), sw, sh, stride, out.data(), dw, dh);
+    check(out == reference(src, sw, sh, stride, dw, dh),
+          std::to_string(sw) + "x" + std::to_string(sh) + " to " + std::to_string(dw) + "x" + std::to_string(dh));
+}
+
+int main() {
+    std::mt19937 rng(3);
+    // Integer ratios of their own code, and the same ratio that is not
+    check_resize(rng, 200, 200, 100, 100);
+    check_resize(rng, 300, 150, 100, 50);
+    check_resize(rng, 400, 400, 100, 100);
+    check_resize(rng, 500, 250, 100, 50);
+    check_resize(rng, 800, 800, 100, 100);
+    check_resize(rng, 1000, 1000, 100, 100, 5);
+    check_resize(rng, 600, 600, 100, 100);
+    check_resize(rng, 800, 400, 100, 100);
+    // Blocks of different sizes, and no scaling on one axis
+    check_resize(rng, 1920, 1080, 100, 100, 64);
+    check_resize(rng, 640, 480, 100, 100);
+    check_resize(rng, 101, 99, 100, 99);
+    check_resize(rng, 100, 100, 100, 100);
+    // Blocks taller than 257 rows
+    check_resize(rng, 30, 1200, 10, 2);
+
+    // Flat images stay flat, even with uneven blocks
+    std::vector<uint8_t> grey(1920 * 1080 * 3, 77);
+    std::vector<uint8_t> out(100 * 100 * 3);
+    AreaDownscaler area;
+    area.resize(grey.data(), 1920, 1080, 1920 * 3, out.data(), 100, 100);
+    check(out == std::vector<uint8_t>(out.size(), 77), "flat image");
+
+    bool thrown = false;
+    try {
+        area.resize(grey.data(), 50, 50, 150, out.data(), 100, 100);
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    check(thrown, "no upscaling");
+
+    return check_result("resize");
+}
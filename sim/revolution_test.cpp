@@ -0,0 +1,134 @@
+// Rows of the revolutions of the firmware state machine (machine_etats.c) on
+// the simulated runtime, with a mirror that is not phase-locked to the motor:
+// more or fewer than LINES_PER_FRAME mirror edges per revolution. The still
+// frame of the link has its line number in the red of every pixel, and each
+// row of every revolution must show its own line of the frame, or stay dark,
+// never another one (the picture rolling). Exit status 1 on the first failure.
+// Usage: revolution_test <mirror Hz>
+#include "sim_rtos.hpp"
+#include "sim_firmware.h"
+#include "line_queue.h"
+#include "check.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if FRAME_PALETTE
+#error "revolution_test is built without FRAME_PALETTE: the line numbers would go through the palette"
+#endif
+
+static const double SECONDS = 2;
+static const double MOTOR_HZ = 10;
+
+// Red of line l is l + 1, so that a dark row (0) is told apart from line 0
+static std::vector<uint8_t> numbered_frame() {
+    std::vector<uint8_t> rgb(LINES_PER_FRAME * PIXELS_PER_LINE * BYTES_PER_PIXEL);
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+            uint8_t* p = &rgb[(line * PIXELS_PER_LINE + pixel) * BYTES_PER_PIXEL];
+            p[0] = static_cast<uint8_t>(line + 1);
+            p[1] = static_cast<uint8_t>(pixel);
+            p[2] = 0x55;
+        }
+    }
+    return rgb;
+}
+
+// Rows counted from the mirror edge after each motor edge, as the screen sees
+// them. A row shows the line of the last red latched on it.
+struct Rows {
+    sim_pins_t pins;
+    uint8_t levels[64] = {};
+    bool closing = false;
+    int revolution = -1;  // The one before the first motor edge is the start-up
+    int row = -1;
+    int shown = 0;        // Rows showing their own line
+    int misplaced = 0;    // Rows showing another line
+    int revolutions = 0;
+    std::vector<int> lines = std::vector<int>(LINES_PER_FRAME, -1);
+
+    void close_revolution() {
+        if (revolution >= 0) {
+            for (int r = 0; r < LINES_PER_FRAME; r++) {
+                shown += lines[r] == r;
+                misplaced += lines[r] >= 0 && lines[r] != r;
+            }
+            revolutions++;
+        }
+        revolution++;
+        row = -1;
+        lines.assign(LINES_PER_FRAME, -1);
+    }
+
+    void mirror_edge() {
+        if (closing) {
+            closing = false;
+            close_revolution();
+        }
+        row++;
+    }
+
+    void gpio_write(int pin, int level) {
+        bool rising = level && !levels[pin];
+        levels[pin] = static_cast<uint8_t>(level);
+        if (pin != pins.select[0] || !rising || row < 0 || row >= LINES_PER_FRAME) {
+            return;
+        }
+        int red = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            red |= levels[pins.data[bit]] << bit;
+        }
+        if (red > 0) {
+            lines[row] = red - 1;
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: revolution_test <mirror Hz>" << std::endl;
+        return 2;
+    }
+    double mirror_hz = std::atof(argv[1]);
+    std::vector<uint8_t> frame = numbered_frame();
+    sim_link_set_frame(frame.data());
+
+    Rows rows;
+    sim_firmware_pins(&rows.pins);
+    sim::Runtime& runtime = sim::Runtime::instance();
+    runtime.on_gpio_write = [&](int pin, int level, double) { rows.gpio_write(pin, level); };
+    runtime.on_edge = [&](const sim::Edge& edge) {
+        if (edge.pin == rows.pins.motor) {
+            rows.closing = true;
+        } else {
+            rows.mirror_edge();
+        }
+    };
+    // Motor edges every period, mirror edges half a line after the motor at the start
+    uint64_t motor_index = 0;
+    uint64_t mirror_index = 0;
+    runtime.run(app_main, SECONDS * 1e6, [&] {
+        double motor = 1e6 / MOTOR_HZ * (motor_index + 1);
+        double mirror = 1e6 / mirror_hz * (mirror_index + 0.5);
+        if (motor <= mirror) {
+            motor_index++;
+            return sim::Edge{motor, rows.pins.motor};
+        }
+        mirror_index++;
+        return sim::Edge{mirror, rows.pins.mirror};
+    });
+
+    std::string name = std::to_string(static_cast<int>(mirror_hz)) + " Hz mirror";
+    int rows_seen = rows.revolutions * LINES_PER_FRAME;
+    check(rows.revolutions >= static_cast<int>(SECONDS * MOTOR_HZ) - 2, name + ": revolutions");
+    check(rows.misplaced == 0, name + ": " + std::to_string(rows.misplaced) + " rows showing another line");
+    // A slow mirror leaves the last rows out, never more than the rows it misses.
+    // In the first revolution a few rows wait for the lines queued at start-up.
+    int missing = static_cast<int>(LINES_PER_FRAME * (1 - mirror_hz / (MOTOR_HZ * LINES_PER_FRAME)) + 0.999);
+    int allowed = rows.revolutions * (missing > 0 ? missing : 0) + LINE_QUEUE_DEPTH;
+    check(rows_seen - rows.shown <= allowed,
+          name + ": " + std::to_string(rows_seen - rows.shown) + " of " + std::to_string(rows_seen) + " rows dark");
+    return check_result("revolution");
+}
@@ -0,0 +1,289 @@
+// Checks of the scan-out backends on Linux: the bus word packing on its own, then
+// the GPIO and the I80 backends driving the mocked pins and LCD_CAM peripheral of
+// sim/idf. Both must put on the pins of pin_map.h what the original affiche_pixel
+// (copied below, on RGB pixels) did, bit for bit, whenever a select is high.
+// Exit status 1 on the first failure.
+#include "sim_rtos.hpp"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "bus_pack.h"
+#include "scan_out.h"
+#include "check.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef uint8_t Line[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+
+static const int DATA_PINS[8] = PIN_MAP_DATA;
+static const int SELECT_PINS[BYTES_PER_PIXEL] = PIN_MAP_SELECT;
+
+static bus_map_t bus_map;
+static void random_line(std::mt19937& rng, Line line) {
+    for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+        for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+            line[pixel][color] = static_cast<uint8_t>(rng());
+        }
+    }
+}
+
+static void test_pack(std::mt19937& rng) {
+    Line line;
+    Line unpacked;
+    uint16_t phases[PHASES_PER_LINE];
+    std::vector<uint16_t> words(BUS_LINE_WORDS);
+    uint16_t signals = bus_map.select_mask | bus_map.data[0xFF];
+    for (int round = 0; round < 100; round++) {
+        random_line(rng, line);
+        // Extremes: the data bus toggles every bit between colours
+        if (round == 0) {
+            for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+                line[pixel][0] = line[pixel][2] = pixel & 1 ? 0x00 : 0xFF;
+                line[pixel][1] = pixel & 1 ? 0xFF : 0x00;
+            }
+        }
+        bus_pack_phases(&bus_map, line, phases);
+        bus_expand_line(&bus_map, phases, words.data());
+        size_t pulses = bus_unpack_line(&bus_map, words.data(), words.size(), unpacked);
+        check(pulses == PHASES_PER_LINE, "one select pulse per colour");
+        check(memcmp(line, unpacked, sizeof(line)) == 0, "packed line decodes to the same pixels");
+        check(words.back() == 0, "line ends with every output low");
+
+        uint16_t previous = 0;
+        for (size_t i = 0; i < words.size(); i++) {
+            uint16_t select = words[i] & bus_map.select_mask;
+            check((words[i] & ~signals) == 0, "unconnected bus bits stay low");
+            check((select & (select - 1)) == 0, "at most one select high");
+            if (select != 0) {
+                // The data must be on the bus before the select goes up, and hold while it is up
+                check((words[i] & ~bus_map.select_mask) == (previous & ~bus_map.select_mask),
+                      "data stable around the select pulse");
+            }
+            previous = words[i];
+        }
+
+        // Line gain on the packed words, same as on the pixels
+        uint8_t lut[256];
+        for (int v = 0; v < 256; v++) {
+            lut[v] = static_cast<uint8_t>(255 - v / 2);
+        }
+        bus_apply_lut(&bus_map, lut, phases, PHASES_PER_LINE);
+        Line scaled;
+        for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+            for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+                scaled[pixel][color] = lut[line[pixel][color]];
+            }
+        }
+        Line repacked;
+        bus_expand_line(&bus_map, phases, words.data());
+        bus_unpack_line(&bus_map, words.data(), words.size(), repacked);
+        check(memcmp(scaled, repacked, sizeof(scaled)) == 0, "gain on bus words matches gain on pixels");
+    }
+}
+
+// Pins as the modulator sees them. Writes at the same time are simultaneous: the
+// pins settle once time moves on, and the settled states with a select high are
+// what the modulator latches.
+struct Bus {
+    std::map<int, int> levels;
+    std::vector<uint16_t> latched;  // Select (bits 8-10) and data (bits 0-7) of each settled pulse
+    std::vector<double> pulse_us;   // Length of each select pulse
+    double settle_us = -1;
+    double rise_us = -1;
+    double first_us = -1;
+    double last_us = 0;
+
+    uint16_t sample() {
+        uint16_t state = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            state |= levels[DATA_PINS[bit]] << bit;
+        }
+        for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+            state |= levels[SELECT_PINS[color]] << (8 + color);
+        }
+        return state;
+    }
+
+    void settle() {
+        if (settle_us < 0) {
+            return;
+        }
+        uint16_t state = sample();
+        if (state >> 8) {
+            if (rise_us < 0 || state != latched.back()) {
+                if (rise_us >= 0) {
+                    pulse_us.push_back(settle_us - rise_us);
+                }
+                latched.push_back(state);
+                rise_us = settle_us;
+            }
+        } else if (rise_us >= 0) {
+            pulse_us.push_back(settle_us - rise_us);
+            rise_us = -1;
+        }
+    }
+
+    void write(int pin, int level, double time_us) {
+        if (time_us != settle_us) {
+            settle();
+            settle_us = time_us;
+        }
+        levels[pin] = level;
+        if (first_us < 0) {
+            first_us = time_us;
+        }
+        last_us = time_us;
+    }
+
+    bool matches(const std::vector<Line*>& lines) const {
+        if (latched.size() != lines.size() * PHASES_PER_LINE) {
+            return false;
+        }
+        for (size_t i = 0; i < latched.size(); i++) {
+            const Line& line = *lines[i / PHASES_PER_LINE];
+            int pixel = i % PHASES_PER_LINE / BYTES_PER_PIXEL;
+            int color = i % BYTES_PER_PIXEL;
+            if (latched[i] != ((1 << (8 + color)) | line[pixel][color])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static Bus bus;
+static std::vector<Bus> captures;
+static int lines_done = 0;
+static const int LINES = 20;
+static const double LINE_US = 900;
+static std::vector<Line*> sent;
+
+// affiche_pixel of the state machine before lines became bus words
+static void reference_affiche_pixel(const uint8_t rgb[BYTES_PER_PIXEL]) {
+    // Set all RGB select pins low initially
+    for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+        gpio_set_level(static_cast<gpio_num_t>(SELECT_PINS[color]), 0);
+    }
+
+    // Red, green then blue: data first, then a pulse on the select of the colour
+    for (int color = 0; color < BYTES_PER_PIXEL; color++) {
+        for (int i = 0; i < 8; i++) {
+            gpio_set_level(static_cast<gpio_num_t>(DATA_PINS[i]), (rgb[color] >> i) & 0x01);
+        }
+        gpio_set_level(static_cast<gpio_num_t>(SELECT_PINS[color]), 1);
+        esp_rom_delay_us(10);
+        gpio_set_level(static_cast<gpio_num_t>(SELECT_PINS[color]), 0);
+    }
+}
+
+static bool count_line_done(void* ctx) {
+    (void)ctx;
+    lines_done++;
+    return false;
+}
+
+static void send_line(scan_out_t* out, const Line line) {
+    static uint16_t phases[PHASES_PER_LINE];
+    if (out == nullptr) {
+        for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+            reference_affiche_pixel(line[pixel]);
+        }
+    } else {
+        bus_pack_phases(&bus_map, line, phases);
+        check(out->write_line(out, phases) == ESP_OK, "line accepted");
+        // The words can be reused as soon as write_line returns
+        memset(phases, 0x55, sizeof(phases));
+    }
+    Line* copy = new Line[1];
+    memcpy(*copy, line, sizeof(Line));
+    sent.push_back(copy);
+}
+
+static void send_lines(scan_out_t* out) {
+    std::mt19937 rng(7);
+    for (int i = 0; i < LINES; i++) {
+        Line line;
+        random_line(rng, line);
+        while (out != nullptr && !out->line_done(out)) {
+            esp_rom_delay_us(1);
+        }
+        send_line(out, line);
+    }
+    while (out != nullptr && !out->line_done(out)) {
+        esp_rom_delay_us(1);
+    }
+}
+
+static void reference_main(void) {
+    send_lines(nullptr);
+}
+
+static void gpio_main(void) {
+    scan_out_t* out;
+    check(scan_out_new_gpio(&bus_map, &out) == ESP_OK, "GPIO backend created");
+    send_lines(out);
+}
+
+static void i80_main(void) {
+    scan_out_i80_config_t config = {};
+    config.map = &bus_map;
+    config.pclk_hz = BUS_PCLK_HZ(LINE_US);
+    config.on_line_done = count_line_done;
+    scan_out_t* out;
+    check(scan_out_new_i80(&config, &out) == ESP_OK, "I80 backend created");
+    double start = sim::Runtime::instance().now();
+    send_lines(out);
+    double elapsed = sim::Runtime::instance().now() - start;
+    // Back to back lines, the bus only pauses while the next transfer is queued
+    check(elapsed >= LINES * LINE_US && elapsed < LINES * (LINE_US + 20), "I80 lines at the pixel clock");
+
+    // A line is refused while the previous one is going out
+    Line line = {};
+    uint16_t phases[PHASES_PER_LINE] = {};
+    send_line(out, line);
+    check(out->write_line(out, phases) == ESP_ERR_INVALID_STATE, "second line refused while busy");
+
+    // Refused pixel clock: the error comes back, the bus and the buffer are freed
+    config.pclk_hz = 0;
+    scan_out_t* refused = nullptr;
+    check(scan_out_new_i80(&config, &refused) == ESP_ERR_INVALID_ARG && refused == nullptr, "I80 error returned");
+}
+
+static void run_backend(const char* name, void (*app_main)(void)) {
+    sim::Runtime& runtime = sim::Runtime::instance();
+    bus = Bus();
+    sent.clear();
+    runtime.on_gpio_write = [](int pin, int level, double time_us) { bus.write(pin, level, time_us); };
+    runtime.run(app_main, 1e9, [] { return sim::Edge{INFINITY, -1}; });
+    bus.settle();
+    check(bus.matches(sent), std::string(name) + ": modulator latches the pixels of every line");
+    std::cout << name << ": " << sent.size() << " lines, " << (bus.last_us - bus.first_us) / sent.size()
+              << " us per line, select pulse " << bus.pulse_us.front() << " us" << std::endl;
+    // Only the lines sent by send_lines, for the comparison with the reference
+    bus.latched.resize(std::min<size_t>(bus.latched.size(), LINES * PHASES_PER_LINE));
+    captures.push_back(bus);
+}
+
+int main() {
+    check(bus_map_init(&bus_map), "every data and select pin on the bus");
+    std::mt19937 rng(1);
+    test_pack(rng);
+
+    // Free GPIO writes so that the backends are judged on their timing only
+    sim::Runtime::instance().cost.gpio_us = 0;
+    sim::Runtime::instance().cost.console_baud = 0;
+    run_backend("reference", reference_main);
+    run_backend("gpio", gpio_main);
+    run_backend("i80", i80_main);
+    check(lines_done == LINES + 1, "I80 done callback once per line");
+    check(captures[1].latched == captures[0].latched, "GPIO backend pins identical to affiche_pixel");
+    check(captures[2].latched == captures[0].latched, "I80 backend pins identical to affiche_pixel");
+
+    return check_result("scan-out");
+}
@@ -0,0 +1,84 @@
+// Checks of the frame signatures and of the scene detection (scene_detect.hpp):
+// repeated frames, frames of a moving scene and scene cuts, and the counters.
+// Exit status 1 on the first failure.
+#include "scene_detect.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int WIDTH = 100;
+static const int HEIGHT = 100;
+
+// Disc moving on a gradient, with noise
+static std::vector<uint8_t> scene_frame(std::mt19937& rng, int t, int base) {
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 3);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t* p = &pixels[(y * WIDTH + x) * 3];
+            bool disc = std::hypot(x - 30 - t, y - 50) < 12;
+            p[0] = static_cast<uint8_t>(disc ? 250 : base + x / 2);
+            p[1] = static_cast<uint8_t>(base + y / 2);
+            p[2] = static_cast<uint8_t>(base + rng() % 6);
+        }
+    }
+    return pixels;
+}
+
+static void test_signature(std::mt19937& rng) {
+    std::vector<uint8_t> frame = scene_frame(rng, 0, 40);
+    FrameSignature a = frame_signature(frame.data(), WIDTH, HEIGHT);
+    check(frame_signature(frame.data(), WIDTH, HEIGHT).hash == a.hash, "same frame, same hash");
+    for (size_t byte : {size_t(0), size_t(5), frame.size() - 1}) {
+        std::vector<uint8_t> changed = frame;
+        changed[byte] ^= 1;
+        check(frame_signature(changed.data(), WIDTH, HEIGHT).hash != a.hash, "one bit changes the hash");
+    }
+
+    // Block means, blocks of unequal sizes included
+    std::vector<uint8_t> flat(20 * 12 * 3);
+    for (size_t i = 0; i < flat.size(); i++) {
+        flat[i] = static_cast<uint8_t>(i % 3 * 100);
+    }
+    FrameSignature small = frame_signature(flat.data(), 20, 12);
+    bool means = true;
+    for (size_t b = 0; b < small.thumbnail.size(); b++) {
+        means = means && small.thumbnail[b] == (b % 3) * 100;
+    }
+    check(means, "flat frame, flat thumbnail");
+    FrameSignature big = frame_signature(frame.data(), WIDTH, HEIGHT);
+    int top_left = 0;
+    for (int y = 0; y < 13; y++) {
+        for (int x = 0; x < 13; x++) {
+            top_left += frame[(y * WIDTH + x) * 3 + 1];
+        }
+    }
+    check(big.thumbnail[1] == (top_left + 84) / 169, "block mean");
+}
+
+static void test_detector(std::mt19937& rng) {
+    SceneDetector scenes;
+    std::vector<uint8_t> first = scene_frame(rng, 0, 40);
+    check(scenes.classify(first.data(), WIDTH, HEIGHT) == SceneDetector::CUT, "first frame is a cut");
+    check(scenes.classify(first.data(), WIDTH, HEIGHT) == SceneDetector::REPEAT, "repeated frame");
+    bool same = true;
+    for (int t = 1; t < 30; t++) {
+        std::vector<uint8_t> frame = scene_frame(rng, t, 40);
+        same = same && scenes.classify(frame.data(), WIDTH, HEIGHT) == SceneDetector::SAME_SCENE;
+    }
+    check(same, "moving disc stays in the scene");
+    std::vector<uint8_t> other = scene_frame(rng, 0, 140);
+    check(scenes.classify(other.data(), WIDTH, HEIGHT) == SceneDetector::CUT, "brighter scene is a cut");
+    check(scenes.classify(other.data(), WIDTH, HEIGHT) == SceneDetector::REPEAT, "hold on the new scene");
+    check(scenes.frames() == 33 && scenes.repeats() == 2 && scenes.cuts() == 2, "counters");
+}
+
+int main() {
+    std::mt19937 rng(1);
+    test_signature(rng);
+    test_detector(rng);
+    return check_result("scene");
+}
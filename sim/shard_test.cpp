@@ -0,0 +1,211 @@
+// Checks of the sharded link (sharded_link.hpp) on loopback controllers: one
+// pty pair per controller, reassembled with the firmware parser. Every
+// controller must publish every frame, with its part of the frame, and the
+// controllers must publish the same frame within SKEW_BUDGET_MS of each other,
+// on the pulse schedule when there is one. Exit status 1 on the first failure.
+#include "bus_pack.h"
+#include "frame_rx.h"
+#include "sharded_link.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const double SKEW_BUDGET_MS = 20.0;
+static const int FRAMES = 20;
+static const size_t FRAME_SIZE = LINES_PER_FRAME * PIXELS_PER_LINE * BYTES_PER_PIXEL;
+
+typedef std::chrono::steady_clock Clock;
+
+// Frame number n of the show, controllers frames
+static std::vector<uint8_t> show_frame(int n, size_t controllers) {
+    std::vector<uint8_t> rgb(controllers * FRAME_SIZE);
+    for (size_t j = 0; j < rgb.size(); j++) {
+        rgb[j] = static_cast<uint8_t>(n * 31 + j * 7 + j / FRAME_SIZE);
+    }
+    return rgb;
+}
+
+// Controller on the master side of a pty pair: when each frame was published,
+// and whether it held its part of the show frame
+class Controller {
+public:
+    Controller() {
+        if (openpty(&master_, &slave_, name_, nullptr, nullptr) < 0) {
+            throw std::runtime_error("Could not open a pty pair");
+        }
+        termios tio;
+        tcgetattr(slave_, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave_, TCSANOW, &tio);
+        frame_buffer_init(fb_.get());
+        frame_rx_init(rx_.get(), fb_.get());
+        bus_map_init(&bus_map_);
+    }
+
+    ~Controller() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        close(slave_);
+        close(master_);
+    }
+
+    std::string device() const { return name_; }
+
+    void start(size_t index, ShardedLink::Split split, size_t controllers) {
+        thread_ = std::thread([=] { receive(index, split, controllers); });
+    }
+
+    void join() { thread_.join(); }
+
+    std::vector<Clock::time_point> published;  // Time of each frame, by frame number
+    bool parts_ok = true;
+    uint32_t incomplete = 0;
+
+private:
+    void receive(size_t index, ShardedLink::Split split, size_t controllers) {
+        published.assign(FRAMES, Clock::time_point());
+        std::vector<uint8_t> buf(4096);
+        int count = 0;
+        while (count < FRAMES) {
+            pollfd pfd = {master_, POLLIN, 0};
+            if (poll(&pfd, 1, 2000) <= 0) {
+                break;
+            }
+            ssize_t n = read(master_, buf.data(), buf.size());
+            if (n <= 0) {
+                break;
+            }
+            // Header sized pieces, a revolution in between: the published frame reaches
+            // the front before the next one starts
+            for (ssize_t i = 0; i < n; i += FRAME_PROTO_HEADER_SIZE) {
+                uint32_t completed = rx_->frames_completed;
+                frame_rx_feed(rx_.get(), buf.data() + i, std::min<ssize_t>(FRAME_PROTO_HEADER_SIZE, n - i));
+                if (rx_->frames_completed == completed) {
+                    continue;
+                }
+                Clock::time_point now = Clock::now();
+                frame_buffer_swap(fb_.get());
+                int frame = rx_->frame_seq;
+                if (frame >= FRAMES) {
+                    parts_ok = false;
+                    continue;
+                }
+                published[frame] = now;
+                count++;
+                std::vector<uint8_t> show = show_frame(frame, split == ShardedLink::LINE_BANDS ? controllers : 1);
+                parts_ok = parts_ok && holds(ShardedLink::split(show, split, controllers)[index]);
+            }
+        }
+        incomplete = rx_->frames_incomplete;
+    }
+
+    // The front frame is rgb packed for the bus
+    bool holds(const std::vector<uint8_t>& rgb) {
+        const frame_t* front = frame_buffer_front(fb_.get());
+        uint16_t phases[PHASES_PER_LINE];
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            const uint8_t* pixels = &rgb[line * PIXELS_PER_LINE * BYTES_PER_PIXEL];
+            bus_pack_phases(&bus_map_, reinterpret_cast<const uint8_t(*)[BYTES_PER_PIXEL]>(pixels), phases);
+            if (!std::equal(phases, phases + PHASES_PER_LINE, front->phases[line])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int master_ = -1;
+    int slave_ = -1;
+    char name_[64];
+    std::unique_ptr<frame_buffer_t> fb_ = std::make_unique<frame_buffer_t>();
+    std::unique_ptr<frame_rx_t> rx_ = std::make_unique<frame_rx_t>();
+    bus_map_t bus_map_;
+    std::thread thread_;
+};
+
+static void check_show(ShardedLink::Split split, size_t controllers, double period_ms, const std::string& name) {
+    std::vector<std::unique_ptr<Controller>> receivers;
+    std::vector<std::string> devices;
+    for (size_t i = 0; i < controllers; i++) {
+        receivers.push_back(std::make_unique<Controller>());
+        devices.push_back(receivers.back()->device());
+        receivers.back()->start(i, split, controllers);
+    }
+    {
+        ShardedLink link(devices, split, period_ms);
+        for (int n = 0; n < FRAMES; n++) {
+            link.send_frame(show_frame(n, split == ShardedLink::LINE_BANDS ? controllers : 1));
+        }
+        link.flush();
+        check(link.frame_seq() == FRAMES && link.frames() == FRAMES, name + ": frame sequence");
+    }
+    for (auto& receiver : receivers) {
+        receiver->join();
+    }
+
+    double max_skew_ms = 0;
+    bool all_published = true;
+    bool on_schedule = true;
+    Clock::time_point start = Clock::time_point::max();
+    for (auto& receiver : receivers) {
+        start = std::min(start, receiver->published[0]);
+    }
+    for (int n = 0; n < FRAMES; n++) {
+        Clock::time_point first = Clock::time_point::max();
+        Clock::time_point last = Clock::time_point::min();
+        for (auto& receiver : receivers) {
+            all_published = all_published && receiver->published[n] != Clock::time_point();
+            first = std::min(first, receiver->published[n]);
+            last = std::max(last, receiver->published[n]);
+        }
+        max_skew_ms = std::max(max_skew_ms, std::chrono::duration<double, std::milli>(last - first).count());
+        // Never before its pulse, 2 ms left for the receivers reading late
+        double since_start = std::chrono::duration<double, std::milli>(first - start).count();
+        on_schedule = on_schedule && since_start >= n * period_ms - 2.0;
+    }
+    check(all_published, name + ": every controller publishes every frame");
+    bool parts_ok = true;
+    for (auto& receiver : receivers) {
+        parts_ok = parts_ok && receiver->parts_ok && receiver->incomplete == 0;
+    }
+    check(parts_ok, name + ": each controller holds its part");
+    check(max_skew_ms <= SKEW_BUDGET_MS, name + ": skew " + std::to_string(max_skew_ms) + " ms");
+    check(on_schedule, name + ": pulse schedule");
+}
+
+int main() {
+    // Parts of the frame
+    std::vector<uint8_t> rgb = show_frame(3, 2);
+    std::vector<std::vector<uint8_t>> bands = ShardedLink::split(rgb, ShardedLink::LINE_BANDS, 2);
+    check(bands.size() == 2 && std::equal(bands[0].begin(), bands[0].end(), rgb.begin()) &&
+              std::equal(bands[1].begin(), bands[1].end(), rgb.begin() + FRAME_SIZE),
+          "line bands");
+    rgb.resize(FRAME_SIZE);
+    std::vector<std::vector<uint8_t>> colours = ShardedLink::split(rgb, ShardedLink::COLOURS, 3);
+    check(colours[1][4] == rgb[4] && colours[1][3] == 0 && colours[1][5] == 0 && colours[2][5] == rgb[5],
+          "colours");
+    bool thrown = false;
+    try {
+        ShardedLink::split(rgb, ShardedLink::LINE_BANDS, 2);
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    check(thrown, "frame size of the line bands");
+
+    check_show(ShardedLink::LINE_BANDS, 3, 0, "line bands");
+    check_show(ShardedLink::COLOURS, 3, 15, "colours on a schedule");
+
+    return check_result("shard");
+}
@@ -0,0 +1,66 @@
+// The state machine is included rather than linked so that the simulator can
+// read its pins and counters without the firmware exporting them.
+#include "machine_etats.c"
+#include "sim_firmware.h"
+
+static frame_rx_t sim_rx;
+static const uint8_t* sim_link_frame = NULL;
+
+void sim_link_set_frame(const uint8_t* rgb) {
+    sim_link_frame = rgb;
+}
+
+void frame_link_start(frame_buffer_t* fb) {
+    frame_rx_init(&sim_rx, fb);
+    if (sim_link_frame != NULL) {
+        // Packed into bus words like the host does before sending
+        frame_t* frame = frame_buffer_begin_write(fb);
+        const uint8_t(*lines)[PIXELS_PER_LINE][BYTES_PER_PIXEL] = (const void*)sim_link_frame;
+#if FRAME_PALETTE
+        // Uniform 6x6x6 palette rather than the scene palette of the host
+        uint8_t colors[216][BYTES_PER_PIXEL];
+        for (int i = 0; i < 216; i++) {
+            colors[i][0] = (uint8_t)(i / 36 * 51);
+            colors[i][1] = (uint8_t)(i / 6 % 6 * 51);
+            colors[i][2] = (uint8_t)(i % 6 * 51);
+        }
+        bus_pack_colors(&bus_map, colors, 216, frame->palette);
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            for (int pixel = 0; pixel < PIXELS_PER_LINE; pixel++) {
+                const uint8_t* rgb = lines[line][pixel];
+                frame->indices[line][pixel] = (uint8_t)((rgb[0] + 25) / 51 * 36 + (rgb[1] + 25) / 51 * 6 + (rgb[2] + 25) / 51);
+            }
+        }
+#else
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            bus_pack_phases(&bus_map, lines[line], frame->phases[line]);
+        }
+#endif
+        frame_buffer_publish(fb);
+    }
+}
+
+const frame_rx_t* frame_link_get_rx(void) {
+    return &sim_rx;
+}
+
+void sim_firmware_pins(sim_pins_t* pins) {
+    pins->motor = MOTOR_PIN;
+    pins->mirror = MIRROR_PIN;
+    pins->select[0] = RED_SELECT_PIN;
+    pins->select[1] = GREEN_SELECT_PIN;
+    pins->select[2] = BLUE_SELECT_PIN;
+    for (int i = 0; i < 8; i++) {
+        pins->data[i] = DATA_PINS[i];
+    }
+}
+
+void sim_firmware_use_i80(bool i80) {
+    use_i80 = i80;
+}
+
+void sim_firmware_counters(sim_counters_t* counters) {
+    counters->underrun = atomic_load(&lines_underrun);
+    counters->dropped = atomic_load(&lines_dropped);
+    counters->overrun = atomic_load(&lines_overrun);
+}
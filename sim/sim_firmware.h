@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Host build of machine_etats.c, with the link replaced by a still frame
+
+typedef struct {
+    int motor;
+    int mirror;
+    int select[BYTES_PER_PIXEL];  // Red, green, blue
+    int data[8];                  // LSB first
+} sim_pins_t;
+
+typedef struct {
+    uint32_t underrun;
+    uint32_t dropped;
+    uint32_t overrun;
+} sim_counters_t;
+
+void sim_firmware_pins(sim_pins_t* pins);
+void sim_firmware_counters(sim_counters_t* counters);
+
+// Scan-out backend, before app_main: LCD_CAM I80 bus (the default of the firmware) or GPIO writes
+void sim_firmware_use_i80(bool i80);
+
+// Frame received on the link when the firmware starts it (LINES_PER_FRAME x PIXELS_PER_LINE RGB)
+void sim_link_set_frame(const uint8_t* rgb);
+
+void app_main(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,624 @@
+#include "sim_rtos.hpp"
+#include "driver/gpio.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_partition.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+static const double FOREVER = std::numeric_limits<double>::infinity();
+static const double TICK_US = 1e6 / configTICK_RATE_HZ;
+
+struct sim_task {
+    std::string name;
+    TaskFunction_t entry;
+    void* arg;
+    int core;
+    unsigned priority;
+    int id;
+    double clock = 0;  // Virtual time reached by the task
+    double wake = 0;   // When it can run again
+    bool done = false;
+    bool preempted = false;  // Stopped in the middle of consuming time
+    bool waiting_notify = false;
+    uint32_t notify = 0;
+    std::condition_variable resume;
+};
+
+namespace {
+
+struct Partition {
+    esp_partition_t info;
+    std::vector<uint8_t> data;
+};
+
+struct Isr {
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+    int core = 0;
+};
+
+// Peripheral activity at a given time. Interrupts run in ISR context and take
+// the core from its task, the other events only change pins.
+struct Event {
+    int core = -1;  // Core of the interrupt, -1 for no interrupt
+    std::function<void()> run;
+};
+
+// Never destroyed: task threads are still parked on it when the process exits
+struct State {
+    std::mutex mutex;
+    std::condition_variable scheduler;
+    std::vector<sim_task*> tasks;
+    sim_task* current = nullptr;
+    bool in_isr = false;
+    double isr_time = 0;
+    sim::Edge pending_edge = {FOREVER, -1};
+    std::map<int, int> levels;
+    std::map<int, Isr> isrs;
+    std::multimap<double, Event> interrupts;
+    std::multimap<double, Event> hardware;
+    std::vector<Partition*> partitions;
+    std::vector<std::string> nvs_namespaces;  // Index + 1 is the handle
+    std::map<std::pair<std::string, std::string>, std::vector<uint8_t>> nvs_blobs;
+};
+
+State& state() {
+    static State* s = new State;
+    return *s;
+}
+
+sim_task* self() {
+    sim_task* task = state().current;
+    if (task == nullptr) {
+        throw std::logic_error("Firmware call outside of a task");
+    }
+    return task;
+}
+
+// Hand control back to the scheduler and wait to be resumed
+void yield(sim_task* task) {
+    State& s = state();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    s.current = nullptr;
+    s.scheduler.notify_one();
+    task->resume.wait(lock, [&] { return s.current == task; });
+    task->clock = std::max(task->clock, task->wake);
+}
+
+void block_until(sim_task* task, double wake) {
+    task->wake = wake;
+    yield(task);
+}
+
+// Next time after the running task's clock at which something else happens
+double horizon(const sim_task* task) {
+    State& s = state();
+    double t = FOREVER;
+    if (s.pending_edge.time_us > task->clock) {
+        t = s.pending_edge.time_us;
+    }
+    auto next_interrupt = s.interrupts.upper_bound(task->clock);
+    if (next_interrupt != s.interrupts.end()) {
+        t = std::min(t, next_interrupt->first);
+    }
+    for (const sim_task* other : s.tasks) {
+        if (other != task && !other->done && other->wake > task->clock) {
+            t = std::min(t, other->wake);
+        }
+    }
+    return t;
+}
+
+// Advance the running task's clock, stopping at every event on the way so that
+// interrupts and other tasks see the state the task had at that time
+void consume(double us) {
+    State& s = state();
+    if (s.in_isr) {
+        return;  // Already accounted for by CostModel::isr_us
+    }
+    sim_task* task = self();
+    double end = task->clock + us;
+    while (true) {
+        double next = horizon(task);
+        if (end <= next) {
+            task->clock = end;
+            return;
+        }
+        task->clock = next;
+        task->preempted = true;
+        block_until(task, next);
+        task->preempted = false;
+        end += task->clock - next;  // Time taken by the ISRs meanwhile
+    }
+}
+
+void task_main(sim_task* task) {
+    State& s = state();
+    {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        task->resume.wait(lock, [&] { return s.current == task; });
+    }
+    task->entry(task->arg);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    task->done = true;
+    s.current = nullptr;
+    s.scheduler.notify_one();
+}
+
+sim_task* create_task(TaskFunction_t entry, const char* name, void* arg, unsigned priority, int core, double clock) {
+    State& s = state();
+    sim_task* task = new sim_task;
+    task->name = name;
+    task->entry = entry;
+    task->arg = arg;
+    task->core = core;
+    task->priority = priority;
+    task->id = static_cast<int>(s.tasks.size());
+    task->clock = clock;
+    task->wake = clock;
+    s.tasks.push_back(task);
+    std::thread(task_main, task).detach();
+    return task;
+}
+
+void schedule(double time_us, int core, std::function<void()> run) {
+    State& s = state();
+    Event event;
+    event.core = core;
+    event.run = std::move(run);
+    (core >= 0 ? s.interrupts : s.hardware).emplace(time_us, std::move(event));
+}
+
+// Run an interrupt handler at time_us on the given core
+void interrupt(double time_us, int core, const std::function<void()>& handler) {
+    State& s = state();
+    s.in_isr = true;
+    s.isr_time = time_us;
+    handler();
+    s.in_isr = false;
+    // The interrupted task of that core loses the time of the ISR
+    for (sim_task* interrupted : s.tasks) {
+        if (interrupted->core == core && interrupted->preempted) {
+            interrupted->clock += sim::Runtime::instance().cost.isr_us;
+            interrupted->wake = interrupted->clock;
+        }
+    }
+}
+
+// Next task to resume: earliest wake, then highest priority, then creation order
+sim_task* next_task() {
+    sim_task* best = nullptr;
+    for (sim_task* task : state().tasks) {
+        if (task->done || task->wake == FOREVER) {
+            continue;
+        }
+        if (best == nullptr || task->wake < best->wake ||
+            (task->wake == best->wake && task->priority > best->priority)) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+namespace sim {
+
+Runtime& Runtime::instance() {
+    static Runtime* runtime = new Runtime;
+    return *runtime;
+}
+
+void Runtime::add_partition(const std::string& label, int subtype, std::vector<uint8_t> data) {
+    Partition* partition = new Partition;
+    partition->info = {};
+    partition->info.type = ESP_PARTITION_TYPE_DATA;
+    partition->info.subtype = subtype;
+    partition->info.size = static_cast<uint32_t>(data.size());
+    snprintf(partition->info.label, sizeof(partition->info.label), "%s", label.c_str());
+    partition->data = std::move(data);
+    state().partitions.push_back(partition);
+}
+
+void Runtime::set_nvs_blob(const std::string& name_space, const std::string& key, std::vector<uint8_t> data) {
+    state().nvs_blobs[std::make_pair(name_space, key)] = std::move(data);
+}
+
+double Runtime::now() const {
+    const State& s = state();
+    if (s.in_isr) {
+        return s.isr_time;
+    }
+    return s.current != nullptr ? s.current->clock : s.isr_time;
+}
+
+void Runtime::run(void (*app_main)(void), double end_us, std::function<Edge()> next_edge) {
+    State& s = state();
+    // app_main is started by the IDF main task, on core 0 at priority 1
+    create_task([](void* arg) { reinterpret_cast<void (*)(void)>(arg)(); }, "main",
+                reinterpret_cast<void*>(app_main), 1, 0, 0);
+    s.pending_edge = next_edge();
+
+    while (true) {
+        sim_task* task = next_task();
+        double task_time = task != nullptr ? task->wake : FOREVER;
+        // Peripheral events first, in time order, they may be due before the next edge
+        double interrupt_time = s.interrupts.empty() ? FOREVER : s.interrupts.begin()->first;
+        double hardware_time = s.hardware.empty() ? FOREVER : s.hardware.begin()->first;
+        double event_time = std::min(interrupt_time, hardware_time);
+        if (event_time <= std::min(task_time, s.pending_edge.time_us)) {
+            if (event_time > end_us) {
+                break;
+            }
+            std::multimap<double, Event>& queue = interrupt_time <= hardware_time ? s.interrupts : s.hardware;
+            Event event = std::move(queue.begin()->second);
+            queue.erase(queue.begin());
+            if (event.core >= 0) {
+                interrupt(event_time, event.core, event.run);
+            } else {
+                s.isr_time = event_time;
+                event.run();
+            }
+            continue;
+        }
+        if (s.pending_edge.time_us <= task_time) {
+            Edge edge = s.pending_edge;
+            if (edge.time_us > end_us) {
+                break;
+            }
+            if (on_edge) {
+                on_edge(edge);
+            }
+            s.levels[edge.pin] ^= 1;
+            auto isr = s.isrs.find(edge.pin);
+            if (isr != s.isrs.end()) {
+                interrupt(edge.time_us, isr->second.core, [&] { isr->second.handler(isr->second.arg); });
+            }
+            s.pending_edge = next_edge();
+            continue;
+        }
+        if (task_time > end_us) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.isr_time = task_time;
+        s.current = task;
+        task->resume.notify_one();
+        s.scheduler.wait(lock, [&] { return s.current == nullptr; });
+    }
+    s.isr_time = end_us;
+}
+
+} // namespace sim
+
+using sim::Runtime;
+
+extern "C" {
+
+const char* esp_err_to_name(esp_err_t err) {
+    switch (err) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    default: return "ESP_FAIL";
+    }
+}
+
+void sim_error_check_failed(esp_err_t err, const char* expression, const char* file, int line) {
+    fprintf(stderr, "ESP_ERROR_CHECK failed: %s (%s) at %s:%d\n", esp_err_to_name(err), expression, file, line);
+    abort();
+}
+
+int64_t esp_timer_get_time(void) {
+    return static_cast<int64_t>(Runtime::instance().now());
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    consume(us);
+}
+
+void sim_log(char level, const char* tag, const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    Runtime& runtime = Runtime::instance();
+    if (runtime.verbose) {
+        printf("%c (%.0f) %s: %s\n", level, runtime.now() / 1000, tag, text);
+    }
+    if (runtime.cost.console_baud != 0 && !state().in_isr) {
+        // "I (timestamp) TAG: " prefix and line end, 10 bits per character on the UART
+        double chars = len + 16 + strlen(tag);
+        consume(chars * 10 * 1e6 / runtime.cost.console_baud);
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+    (void)pin;
+    (void)type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_glitch_filter(gpio_num_t pin, bool enable) {
+    (void)pin;
+    (void)enable;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    (void)flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    // Interrupts are allocated on the core of the task that installs them
+    Isr& isr = state().isrs[pin];
+    isr.handler = handler;
+    isr.arg = arg;
+    isr.core = self()->core;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    Runtime& runtime = Runtime::instance();
+    state().levels[pin] = level ? 1 : 0;
+    if (runtime.on_gpio_write) {
+        runtime.on_gpio_write(pin, level ? 1 : 0, runtime.now());
+    }
+    consume(runtime.cost.gpio_us);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    return state().levels[pin];
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t entry, const char* name, uint32_t stack_size, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)stack_size;
+    sim_task* task = create_task(entry, name, arg, priority, core, self()->clock);
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    sim_task* task = self();
+    // Wakes on a tick interrupt, the first tick may come right away
+    block_until(task, (std::floor(task->clock / TICK_US) + ticks) * TICK_US);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t timeout) {
+    sim_task* task = self();
+    if (task->notify == 0 && timeout != 0) {
+        task->waiting_notify = true;
+        block_until(task, timeout == portMAX_DELAY ? FOREVER : task->clock + timeout * TICK_US);
+        task->waiting_notify = false;
+    }
+    uint32_t value = task->notify;
+    task->notify = clear_on_exit ? 0 : (value ? value - 1 : 0);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    task->notify++;
+    if (task->waiting_notify) {
+        task->wake = std::max(task->clock, Runtime::instance().now());
+    }
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken) {
+    bool waiting = task->waiting_notify;
+    xTaskNotifyGive(task);
+    if (higher_priority_woken != nullptr && waiting) {
+        *higher_priority_woken = pdTRUE;
+    }
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return self()->core;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (Partition* partition : state().partitions) {
+        if (partition->info.type == type && partition->info.subtype == subtype &&
+            (label == nullptr || partition->info.label == std::string(label))) {
+            return &partition->info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle) {
+    (void)memory;
+    for (Partition* p : state().partitions) {
+        if (&p->info == partition && offset + size <= p->data.size()) {
+            *out_ptr = p->data.data() + offset;
+            *out_handle = 0;
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {
+    (void)mode;
+    State& s = state();
+    s.nvs_namespaces.push_back(name);
+    *handle = static_cast<nvs_handle_t>(s.nvs_namespaces.size());
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length) {
+    State& s = state();
+    auto blob = s.nvs_blobs.find(std::make_pair(s.nvs_namespaces.at(handle - 1), std::string(key)));
+    if (blob == s.nvs_blobs.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out != nullptr) {
+        if (*length < blob->second.size()) {
+            return ESP_FAIL;
+        }
+        memcpy(out, blob->second.data(), blob->second.size());
+    }
+    *length = blob->second.size();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+struct esp_lcd_i80_bus_t {
+    int pins[ESP_LCD_I80_BUS_WIDTH_MAX];
+    size_t width;
+    size_t max_transfer_bytes;
+    uint32_t word = 0;  // Levels on the bus
+};
+
+struct esp_lcd_panel_io_t {
+    esp_lcd_i80_bus_t* bus;
+    uint32_t pclk_hz;
+    size_t queue_depth;
+    esp_lcd_panel_io_color_trans_done_cb_t on_done;
+    void* user_ctx;
+    int core;                      // Interrupt allocated on the core that created the IO
+    std::deque<double> pending;    // End times of the queued transfers
+};
+
+esp_err_t esp_lcd_new_i80_bus(const esp_lcd_i80_bus_config_t* bus_config, esp_lcd_i80_bus_handle_t* ret_bus) {
+    if (bus_config->bus_width != 8 && bus_config->bus_width != 16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_lcd_i80_bus_t* bus = new esp_lcd_i80_bus_t;
+    for (size_t i = 0; i < bus_config->bus_width; i++) {
+        // The driver routes every bit of the bus to a pin
+        if (bus_config->data_gpio_nums[i] < 0) {
+            delete bus;
+            return ESP_ERR_INVALID_ARG;
+        }
+        bus->pins[i] = bus_config->data_gpio_nums[i];
+    }
+    bus->width = bus_config->bus_width;
+    bus->max_transfer_bytes = bus_config->max_transfer_bytes;
+    *ret_bus = bus;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_del_i80_bus(esp_lcd_i80_bus_handle_t bus) {
+    delete bus;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_io_i80(esp_lcd_i80_bus_handle_t bus, const esp_lcd_panel_io_i80_config_t* io_config,
+                                   esp_lcd_panel_io_handle_t* ret_io) {
+    if (io_config->pclk_hz == 0 || io_config->trans_queue_depth == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_lcd_panel_io_t* io = new esp_lcd_panel_io_t;
+    io->bus = bus;
+    io->pclk_hz = io_config->pclk_hz;
+    io->queue_depth = io_config->trans_queue_depth;
+    io->on_done = io_config->on_color_trans_done;
+    io->user_ctx = io_config->user_ctx;
+    io->core = self()->core;
+    *ret_io = io;
+    return ESP_OK;
+}
+
+// The DMA reads each word from memory when it goes out, one event per word
+static void i80_send_word(esp_lcd_panel_io_t* io, const uint8_t* data, size_t index, size_t count, double start) {
+    esp_lcd_i80_bus_t* bus = io->bus;
+    size_t word_bytes = bus->width / 8;
+    uint32_t word = data[index * word_bytes];
+    if (word_bytes == 2) {
+        word |= static_cast<uint32_t>(data[index * word_bytes + 1]) << 8;  // Little endian words
+    }
+    Runtime& runtime = Runtime::instance();
+    double time_us = start + index * 1e6 / io->pclk_hz;
+    for (size_t bit = 0; bit < bus->width; bit++) {
+        int level = (word >> bit) & 1;
+        if (level != static_cast<int>((bus->word >> bit) & 1)) {
+            state().levels[bus->pins[bit]] = level;
+            if (runtime.on_gpio_write) {
+                runtime.on_gpio_write(bus->pins[bit], level, time_us);
+            }
+        }
+    }
+    bus->word = word;
+    if (index + 1 < count) {
+        schedule(start + (index + 1) * 1e6 / io->pclk_hz, -1,
+                 [=] { i80_send_word(io, data, index + 1, count, start); });
+    }
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void* color, size_t color_size) {
+    if (lcd_cmd != -1) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (color_size > io->bus->max_transfer_bytes || color_size % (io->bus->width / 8) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Runtime& runtime = Runtime::instance();
+    sim_task* task = self();
+    while (!io->pending.empty() && io->pending.front() <= task->clock) {
+        io->pending.pop_front();
+    }
+    if (io->pending.size() >= io->queue_depth) {
+        block_until(task, io->pending.front());
+        io->pending.pop_front();
+    }
+    consume(runtime.cost.dma_start_us);
+
+    double start = std::max(task->clock, io->pending.empty() ? 0.0 : io->pending.back());
+    size_t count = color_size / (io->bus->width / 8);
+    double end = start + count * 1e6 / io->pclk_hz;
+    const uint8_t* data = static_cast<const uint8_t*>(color);
+    schedule(start, -1, [=] { i80_send_word(io, data, 0, count, start); });
+    schedule(end, io->core, [=] {
+        esp_lcd_panel_io_event_data_t edata = {};
+        if (io->on_done != nullptr) {
+            io->on_done(io, &edata, io->user_ctx);
+        }
+    });
+    io->pending.push_back(end);
+    return ESP_OK;
+}
+
+} // extern "C"
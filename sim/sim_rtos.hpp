@@ -0,0 +1,68 @@
+#pragma once
+
+#include "sim_rtos.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Discrete-event host runtime for the firmware.
+//
+// Every FreeRTOS task of the firmware runs in its own thread but only one of them
+// executes at a time, in virtual time: a task has its own clock, which advances by
+// the cost of what it does (GPIO writes, busy waits, console output) and jumps
+// when it blocks (vTaskDelay, notifications). The scheduler always resumes whatever
+// is earliest, a task or an input edge, so runs are deterministic and GPIO ISRs
+// interrupt the task of their core in the middle of its work.
+//
+// Simplification: tasks pinned to the same core do not compete for it, each one
+// behaves as if it had the core to itself. On the projector the scan-out core only
+// runs the scan-out task, and the ingestion core is mostly idle.
+
+namespace sim {
+
+// Execution time charged for the calls the firmware makes
+struct CostModel {
+    double gpio_us = 0.1;            // gpio_set_level through the driver
+    double isr_us = 2.0;             // Interrupt dispatch plus the handler
+    uint32_t console_baud = 115200;  // Logs wait for the UART, 0 to make them free
+    double dma_start_us = 5.0;       // esp_lcd_panel_io_tx_color: queueing and starting the transfer
+};
+
+struct Edge {
+    double time_us;
+    int pin;
+};
+
+class Runtime {
+public:
+    CostModel cost;
+    bool verbose = false;
+
+    // Called for every gpio_set_level and every pin change made by a peripheral,
+    // at the virtual time of the change
+    std::function<void(int pin, int level, double time_us)> on_gpio_write;
+
+    // Called before the ISR of each input edge
+    std::function<void(const Edge& edge)> on_edge;
+
+    static Runtime& instance();
+
+    // Content returned by esp_partition_find_first/esp_partition_mmap
+    void add_partition(const std::string& label, int subtype, std::vector<uint8_t> data);
+
+    // Content returned by nvs_get_blob
+    void set_nvs_blob(const std::string& name_space, const std::string& key, std::vector<uint8_t> data);
+
+    // Start app_main as the main task and run until end_us. next_edge gives the input
+    // edges in time order, they toggle their pin and call its ISR.
+    void run(void (*app_main)(void), double end_us, std::function<Edge()> next_edge);
+
+    double now() const;
+
+private:
+    Runtime() = default;
+};
+
+} // namespace sim
@@ -0,0 +1,58 @@
+// Checks of the edge timing telemetry of the firmware (telemetry.h) on Linux:
+// jitter buckets of a steady signal, a glitch, and a motor stopped for longer
+// than a 32 bit period in 1/16 us can hold, which must show as the longest
+// interval rather than a short one, and not leave the mean period behind. The
+// export must parse back to the same histograms. Exit status 1 on the first
+// failure.
+#include "telemetry.h"
+#include "check.hpp"
+
+#include <cstring>
+#include <string>
+
+static const int64_t PERIOD_US = 100000;  // Motor revolution at 10 Hz
+
+int main() {
+    telemetry_t tlm;
+    int64_t now = 1000;
+    telemetry_init(&tlm, now);
+    for (int i = 0; i < 20; i++) {
+        telemetry_edge(&tlm, TELEMETRY_MOTOR, now += PERIOD_US);
+    }
+    const telemetry_window_t& window = tlm.windows[tlm.active];
+    check(window.buckets[TELEMETRY_MOTOR_JITTER][TELEMETRY_BUCKETS / 2] == 18, "steady edges in the middle bucket");
+    check(tlm.edges[TELEMETRY_MOTOR].mean_period_x16 >> 4 == PERIOD_US, "mean period");
+
+    telemetry_edge(&tlm, TELEMETRY_MOTOR, now + PERIOD_US / 10);
+    check(window.glitches[TELEMETRY_MOTOR] == 1, "glitch counted apart");
+
+    // Stopped for 300 s: past the 268 s where the interval in 1/16 us wrapped
+    telemetry_edge(&tlm, TELEMETRY_MOTOR, now += 300 * 1000000LL);
+    check(window.buckets[TELEMETRY_MOTOR_JITTER][TELEMETRY_BUCKETS - 1] == 1, "long stop in the last bucket");
+    check(window.max_us[TELEMETRY_MOTOR_JITTER] > 100 * 1000000u, "long stop as the largest deviation");
+    uint32_t short_deviations = 0;
+    for (int b = 0; b < TELEMETRY_BUCKETS / 2; b++) {
+        short_deviations += window.buckets[TELEMETRY_MOTOR_JITTER][b];
+    }
+    check(short_deviations == 0, "long stop not taken for a short interval");
+    for (int i = 0; i < 20; i++) {
+        telemetry_edge(&tlm, TELEMETRY_MOTOR, now += PERIOD_US);
+    }
+    check(window.glitches[TELEMETRY_MOTOR] == 1, "no glitch after the stop");
+    check(tlm.edges[TELEMETRY_MOTOR].mean_period_x16 >> 4 == PERIOD_US, "mean period after the stop");
+
+    uint8_t out[TELEMETRY_MAX_EXPORT];
+    telemetry_window_t recorded = window;
+    size_t len = telemetry_export(&tlm, now + 1000, out);
+    telemetry_report_t report;
+    check(len > 0 && len <= TELEMETRY_MAX_EXPORT && telemetry_parse(out, len, &report), "export parsed");
+    check(std::memcmp(&report.window, &recorded, sizeof(recorded)) == 0, "histograms exported");
+
+    // First interval past 2^28 us: not taken for the short one it wrapped to
+    telemetry_t stopped;
+    telemetry_init(&stopped, 0);
+    telemetry_edge(&stopped, TELEMETRY_MIRROR, 1000);
+    telemetry_edge(&stopped, TELEMETRY_MIRROR, 1000 + (1LL << 28) + 500);
+    check(stopped.edges[TELEMETRY_MIRROR].mean_period_x16 >> 4 != 500, "first interval saturated, not wrapped");
+    return check_result("telemetry");
+}
@@ -0,0 +1,183 @@
+// Packs videos and images into the compressed animation image of Video-proj/main/anim_store.h,
+// ready to be written to the "anim" flash partition.
+// Usage: anim_pack <output.bin> <fps> <video or image>...
+#include <opencv2/opencv.hpp>
+#include "anim_image.hpp"
+#include "anim_store.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const size_t ANIM_PARTITION_SIZE = 0x130000;  // Video-proj/partitions.csv
+
+typedef std::vector<uint8_t> Bytes;
+
+static bool is_image(const std::string& path) {
+    std::string ext = path.substr(path.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == "png" || ext == "jpg" || ext == "jpeg" || ext == "bmp";
+}
+
+// Frames at the projector geometry, in BGR as read by OpenCV
+static std::vector<cv::Mat> load_frames(const std::vector<std::string>& inputs) {
+    std::vector<cv::Mat> frames;
+    for (const std::string& input : inputs) {
+        std::vector<cv::Mat> decoded;
+        if (is_image(input)) {
+            decoded.push_back(cv::imread(input, cv::IMREAD_COLOR));
+        } else {
+            cv::VideoCapture video(input);
+            if (!video.isOpened()) {
+                throw std::runtime_error("Could not open video file " + input);
+            }
+            cv::Mat frame;
+            while (video.read(frame)) {
+                decoded.push_back(frame.clone());
+            }
+        }
+        for (const cv::Mat& frame : decoded) {
+            if (frame.empty()) {
+                throw std::runtime_error("Could not read " + input);
+            }
+            cv::Mat resized;
+            cv::resize(frame, resized, cv::Size(PIXELS_PER_LINE, LINES_PER_FRAME), 0, 0, cv::INTER_AREA);
+            frames.push_back(resized);
+        }
+    }
+    return frames;
+}
+
+static int bin_of(const cv::Vec3b& bgr) {
+    return ((bgr[2] >> 3) << 10) | ((bgr[1] >> 3) << 5) | (bgr[0] >> 3);
+}
+
+// Popularity palette: the 256 most used 15 bit colors, each one the mean of its pixels
+static std::vector<cv::Vec3b> build_palette(const std::vector<cv::Mat>& frames) {
+    std::vector<uint32_t> count(1 << 15, 0);
+    std::vector<std::array<uint64_t, 3>> sum(1 << 15, {0, 0, 0});
+    for (const cv::Mat& frame : frames) {
+        for (int i = 0; i < frame.rows; i++) {
+            for (int j = 0; j < frame.cols; j++) {
+                const cv::Vec3b& p = frame.at<cv::Vec3b>(i, j);
+                int bin = bin_of(p);
+                count[bin]++;
+                for (int k = 0; k < 3; k++) {
+                    sum[bin][k] += p[k];
+                }
+            }
+        }
+    }
+    std::vector<int> bins;
+    for (int bin = 0; bin < (1 << 15); bin++) {
+        if (count[bin]) {
+            bins.push_back(bin);
+        }
+    }
+    std::sort(bins.begin(), bins.end(), [&](int a, int b) { return count[a] > count[b]; });
+    bins.resize(std::min<size_t>(bins.size(), 256));
+
+    std::vector<cv::Vec3b> palette;
+    for (int bin : bins) {
+        cv::Vec3b color;
+        for (int k = 0; k < 3; k++) {
+            color[k] = static_cast<uint8_t>(sum[bin][k] / count[bin]);
+        }
+        palette.push_back(color);
+    }
+    return palette;
+}
+
+static uint8_t nearest(const std::vector<cv::Vec3b>& palette, const cv::Vec3b& p) {
+    int best = 0;
+    int best_dist = 1 << 30;
+    for (size_t i = 0; i < palette.size(); i++) {
+        int dist = 0;
+        for (int k = 0; k < 3; k++) {
+            int d = palette[i][k] - p[k];
+            dist += d * d;
+        }
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return static_cast<uint8_t>(best);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: anim_pack <output.bin> <fps> <video or image>..." << std::endl;
+        return 1;
+    }
+    std::vector<cv::Mat> frames = load_frames(std::vector<std::string>(argv + 3, argv + argc));
+    if (frames.empty()) {
+        throw std::runtime_error("No frame to pack");
+    }
+    std::vector<cv::Vec3b> palette = build_palette(frames);
+
+    // Palette indices of every pixel, nearest color cached per 15 bit bin
+    std::vector<int> cache(1 << 15, -1);
+    std::vector<Bytes> indexed;
+    for (const cv::Mat& frame : frames) {
+        Bytes indices(LINES_PER_FRAME * PIXELS_PER_LINE);
+        for (int i = 0; i < LINES_PER_FRAME; i++) {
+            for (int j = 0; j < PIXELS_PER_LINE; j++) {
+                const cv::Vec3b& p = frame.at<cv::Vec3b>(i, j);
+                int& index = cache[bin_of(p)];
+                if (index < 0) {
+                    index = nearest(palette, p);
+                }
+                indices[i * PIXELS_PER_LINE + j] = static_cast<uint8_t>(index);
+            }
+        }
+        indexed.push_back(indices);
+    }
+
+    std::vector<Rgb> colors;
+    for (const cv::Vec3b& color : palette) {
+        colors.push_back({color[2], color[1], color[0]});
+    }
+    AnimImage packed = anim_encode(colors, indexed, std::stod(argv[2]));
+    const Bytes& image = packed.bytes;
+
+    // Round trip through the firmware decoder before writing anything
+    anim_store_t store;
+    if (!anim_store_open(&store, image.data(), image.size())) {
+        throw std::runtime_error("Packed image rejected by the decoder");
+    }
+    uint8_t rgb[PIXELS_PER_LINE][BYTES_PER_PIXEL];
+    for (size_t f = 0; f < indexed.size(); f++) {
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            if (!anim_store_decode_line(&store, static_cast<uint32_t>(f), static_cast<uint16_t>(line), rgb)) {
+                throw std::runtime_error("Decoder failed on frame " + std::to_string(f));
+            }
+            for (int j = 0; j < PIXELS_PER_LINE; j++) {
+                const cv::Vec3b& color = palette[indexed[f][line * PIXELS_PER_LINE + j]];
+                if (rgb[j][0] != color[2] || rgb[j][1] != color[1] || rgb[j][2] != color[0]) {
+                    throw std::runtime_error("Round trip mismatch on frame " + std::to_string(f));
+                }
+            }
+        }
+    }
+
+    std::ofstream out(argv[1], std::ios::binary);
+    out.write(reinterpret_cast<const char*>(image.data()), image.size());
+    if (!out) {
+        throw std::runtime_error(std::string("Could not write ") + argv[1]);
+    }
+
+    size_t raw = frames.size() * LINES_PER_FRAME * PIXELS_PER_LINE * BYTES_PER_PIXEL;
+    std::cout << frames.size() << " frames, " << palette.size() << " colors, " << image.size() << " bytes ("
+              << raw / image.size() << "x smaller than raw), " << packed.shared_lines << " shared lines" << std::endl;
+    if (image.size() > ANIM_PARTITION_SIZE) {
+        std::cerr << "Warning: image does not fit in the anim partition (" << ANIM_PARTITION_SIZE << " bytes)" << std::endl;
+        return 1;
+    }
+    return 0;
+}
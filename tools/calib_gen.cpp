@@ -0,0 +1,259 @@
+// Builds the facet/line calibration table of Video-proj/main/calib.h from a photo of
+// the projected test pattern and the CAL: line the firmware logs every second.
+// Usage: calib_gen pattern <pattern.png>
+//        calib_gen <capture.png> <monitor.log> <calib.bin> [previous calib.bin] [--line0 facet]
+// The capture must be cropped to the projected area and expose a single revolution
+// when the mirror is not locked to the motor. calib.bin is written with a CSV for
+// nvs_partition_gen.py next to it.
+#include <opencv2/opencv.hpp>
+#include "calib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const int PATTERN_BARS[] = {20, 50, 80};  // Columns of the vertical bars of the test pattern
+static const int SUBPIXELS = 8;                  // Horizontal resolution of the measure, per projector pixel
+static const double MIN_BAR_ENERGY = 64;         // Below this a bar is considered missing on the line
+
+// What the firmware reports about the mirror
+struct MirrorInfo {
+    int facet_count = 0;
+    int line0_facet = -1;  // Facet that drew line 0, -1 if it was not constant
+    double line_period_us = 0;
+    std::vector<int16_t> signature;
+};
+
+static MirrorInfo read_cal_line(const std::string& path) {
+    std::ifstream log(path);
+    if (!log) {
+        throw std::runtime_error("Could not read " + path);
+    }
+    std::string line;
+    std::string last;
+    while (std::getline(log, line)) {
+        size_t pos = line.find("CAL:");
+        if (pos != std::string::npos) {
+            last = line.substr(pos + 4);
+        }
+    }
+    if (last.empty()) {
+        throw std::runtime_error("No CAL: line in " + path);
+    }
+
+    // facets:line0:period:s0,s1,...
+    MirrorInfo info;
+    std::istringstream in(last);
+    char sep;
+    in >> info.facet_count >> sep;
+    if (in.peek() == '-') {
+        in.get();
+    } else {
+        in >> info.line0_facet;
+    }
+    in >> sep >> info.line_period_us >> sep;
+    for (int f = 0; f < info.facet_count; f++) {
+        int value = 0;
+        in >> value;
+        info.signature.push_back(static_cast<int16_t>(value));
+        in >> sep;
+    }
+    if (!in && !in.eof()) {
+        throw std::runtime_error("Malformed CAL: line " + last);
+    }
+    if (info.facet_count < 1 || info.facet_count > CALIB_MAX_FACETS || info.line_period_us <= 0) {
+        throw std::runtime_error("Malformed CAL: line " + last);
+    }
+    return info;
+}
+
+static void write_pattern(const std::string& path) {
+    cv::Mat pattern = cv::Mat::zeros(LINES_PER_FRAME, PIXELS_PER_LINE, CV_8UC3);
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        for (int column : PATTERN_BARS) {
+            pattern.at<cv::Vec3b>(line, column) = cv::Vec3b(255, 255, 255);
+        }
+    }
+    cv::imwrite(path, pattern);
+}
+
+// Horizontal error (projector pixels, positive to the right) and brightness of one line
+struct LineMeasure {
+    bool valid = false;
+    double offset = 0;
+    double energy = 0;
+};
+
+static std::vector<LineMeasure> measure_capture(const std::string& path) {
+    cv::Mat capture = cv::imread(path, cv::IMREAD_COLOR);
+    if (capture.empty()) {
+        throw std::runtime_error("Could not read " + path);
+    }
+    cv::Mat gray;
+    cv::cvtColor(capture, gray, cv::COLOR_BGR2GRAY);
+    cv::resize(gray, gray, cv::Size(PIXELS_PER_LINE * SUBPIXELS, LINES_PER_FRAME), 0, 0, cv::INTER_AREA);
+
+    const int bars = sizeof(PATTERN_BARS) / sizeof(PATTERN_BARS[0]);
+    const int half_window = (PATTERN_BARS[1] - PATTERN_BARS[0]) / 2 * SUBPIXELS;
+    std::vector<LineMeasure> lines(LINES_PER_FRAME);
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        const uint8_t* row = gray.ptr<uint8_t>(line);
+        double offset_sum = 0;
+        double energy_sum = 0;
+        int found = 0;
+        for (int column : PATTERN_BARS) {
+            int center = column * SUBPIXELS + SUBPIXELS / 2;
+            int begin = std::max(0, center - half_window);
+            int end = std::min(PIXELS_PER_LINE * SUBPIXELS, center + half_window);
+            uint8_t low = *std::min_element(row + begin, row + end);
+            uint8_t high = *std::max_element(row + begin, row + end);
+            double threshold = (low + high) / 2.0;
+            double weight = 0;
+            double moment = 0;
+            double energy = 0;
+            for (int x = begin; x < end; x++) {
+                energy += row[x] - low;
+                if (row[x] > threshold) {
+                    weight += row[x] - threshold;
+                    moment += (row[x] - threshold) * (x + 0.5);
+                }
+            }
+            if (energy / SUBPIXELS < MIN_BAR_ENERGY || weight == 0) {
+                continue;
+            }
+            offset_sum += (moment / weight - center) / SUBPIXELS;
+            energy_sum += energy;
+            found++;
+        }
+        if (found == bars) {
+            lines[line].valid = true;
+            lines[line].offset = offset_sum / found;
+            lines[line].energy = energy_sum / found;
+        }
+    }
+    return lines;
+}
+
+static calib_table_t read_table(const std::string& path, int facet_count) {
+    calib_table_t table;
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file || !calib_parse(blob.data(), blob.size(), &table) || table.facet_count != facet_count) {
+        throw std::runtime_error(path + " is not a calibration table for this mirror");
+    }
+    return table;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string(argv[1]) == "pattern") {
+        write_pattern(argv[2]);
+        return 0;
+    }
+    std::vector<std::string> args;
+    int line0_override = -1;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--line0" && i + 1 < argc) {
+            line0_override = std::stoi(argv[++i]);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.size() < 3) {
+        std::cerr << "Usage: calib_gen pattern <pattern.png>" << std::endl
+                  << "       calib_gen <capture.png> <monitor.log> <calib.bin> [previous calib.bin] [--line0 facet]"
+                  << std::endl;
+        return 1;
+    }
+
+    MirrorInfo mirror = read_cal_line(args[1]);
+    int line0 = line0_override >= 0 ? line0_override : mirror.line0_facet;
+    if (line0 < 0) {
+        throw std::runtime_error("Line 0 was not always drawn by the same facet, pass --line0 for this capture");
+    }
+    int facets = mirror.facet_count;
+
+    // Corrections add up to the table in use when the capture was taken
+    calib_table_t table;
+    if (args.size() > 3) {
+        table = read_table(args[3], facets);
+    } else {
+        calib_identity(&table, static_cast<uint8_t>(facets));
+    }
+    for (int f = 0; f < facets; f++) {
+        table.facet_signature[f] = mirror.signature[f];
+    }
+
+    std::vector<LineMeasure> lines = measure_capture(args[0]);
+
+    // Start delays: a facet landing to the right has to start earlier. Delays can
+    // only be positive, the earliest facet gets none.
+    double pixel_us = mirror.line_period_us / PIXELS_PER_LINE;
+    std::vector<double> delay(facets, 0);
+    for (int f = 0; f < facets; f++) {
+        double sum = 0;
+        int count = 0;
+        for (int line = 0; line < LINES_PER_FRAME; line++) {
+            if (lines[line].valid && (line0 + line) % facets == f) {
+                sum += lines[line].offset;
+                count++;
+            }
+        }
+        if (count == 0) {
+            throw std::runtime_error("Facet " + std::to_string(f) + " drew no measurable line");
+        }
+        delay[f] = table.facet_delay_us[f] - sum / count * pixel_us;
+    }
+    double earliest = *std::min_element(delay.begin(), delay.end());
+    for (int f = 0; f < facets; f++) {
+        table.facet_delay_us[f] = static_cast<uint16_t>(std::lround(delay[f] - earliest));
+    }
+
+    // Line gains: even out to the median line, brighter lines are dimmed, darker ones boosted
+    std::vector<double> energies;
+    for (const LineMeasure& measure : lines) {
+        if (measure.valid) {
+            energies.push_back(measure.energy);
+        }
+    }
+    std::nth_element(energies.begin(), energies.begin() + energies.size() / 2, energies.end());
+    double target = energies[energies.size() / 2];
+    for (int line = 0; line < LINES_PER_FRAME; line++) {
+        if (lines[line].valid) {
+            long gain = std::lround(table.line_gain[line] * target / lines[line].energy);
+            table.line_gain[line] = static_cast<uint8_t>(std::min(255L, std::max(1L, gain)));
+        }
+    }
+
+    uint8_t blob[CALIB_BLOB_SIZE];
+    calib_serialize(&table, blob);
+    std::ofstream out(args[2], std::ios::binary);
+    out.write(reinterpret_cast<const char*>(blob), sizeof(blob));
+    std::string csv_path = args[2].substr(0, args[2].find_last_of('.')) + ".csv";
+    std::ofstream csv(csv_path);
+    csv << "key,type,encoding,value" << std::endl
+        << CALIB_NVS_NAMESPACE << ",namespace,," << std::endl
+        << CALIB_NVS_KEY << ",file,binary," << args[2] << std::endl;
+    if (!out || !csv) {
+        throw std::runtime_error("Could not write " + args[2]);
+    }
+
+    std::cout << facets << " facets, line period " << mirror.line_period_us << " us, "
+              << std::count_if(lines.begin(), lines.end(), [](const LineMeasure& m) { return m.valid; })
+              << " lines measured" << std::endl;
+    for (int f = 0; f < facets; f++) {
+        std::cout << "  facet " << f << ": delay " << table.facet_delay_us[f] << " us, signature "
+                  << table.facet_signature[f] << " us" << std::endl;
+    }
+    auto gains = std::minmax_element(table.line_gain, table.line_gain + LINES_PER_FRAME);
+    std::cout << "  line gains " << *gains.first * 100 / CALIB_GAIN_ONE << "% to "
+              << *gains.second * 100 / CALIB_GAIN_ONE << "%" << std::endl
+              << "Flash with: nvs_partition_gen.py generate " << csv_path << " nvs.bin 0x6000 && "
+              << "parttool.py write_partition --partition-name nvs --input nvs.bin" << std::endl;
+    return 0;
+}
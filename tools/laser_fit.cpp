@@ -0,0 +1,78 @@
+// Fits the laser curves of laser.hpp on photodiode readings and writes the
+// profile read by main --laser.
+// Usage: laser_fit <readings.csv> <profile.txt> [--max-power fraction] [--target-gamma gamma]
+// readings.csv has one reading per line: colour,drive,reading (colour red, green
+// or blue, drive 0-255, reading in any unit proportional to the light), a header
+// line is skipped. Each colour needs a few drive values spread over its range,
+// including its highest and, for the ambient light, one below the threshold.
+// --max-power caps each laser at that fraction of its light at the highest drive
+// measured (1 by default), --target-gamma is the gamma of the displayed values
+// (2.2 by default, the one of video).
+#include "laser.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::map<std::string, std::vector<LaserReading>> read_csv(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not read " + path);
+    }
+    std::map<std::string, std::vector<LaserReading>> readings;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream in(line);
+        std::string colour;
+        LaserReading r;
+        if (in >> colour >> r.drive >> r.light) {
+            readings[colour].push_back(r);
+        }
+    }
+    return readings;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args;
+    double max_power = 1.0;
+    LaserProfile profile;
+    profile.target_gamma = 2.2;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--max-power" && i + 1 < argc) {
+            max_power = std::stod(argv[++i]);
+        } else if (std::string(argv[i]) == "--target-gamma" && i + 1 < argc) {
+            profile.target_gamma = std::stod(argv[++i]);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.size() != 2 || max_power <= 0 || max_power > 1 || profile.target_gamma <= 0) {
+        std::cerr << "Usage: laser_fit <readings.csv> <profile.txt> [--max-power fraction] [--target-gamma gamma]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::vector<LaserReading>> readings = read_csv(args[0]);
+    const char* const colours[3] = {"red", "green", "blue"};
+    for (int c = 0; c < 3; c++) {
+        auto it = readings.find(colours[c]);
+        if (it == readings.end()) {
+            std::cerr << "No readings for " << colours[c] << ", linear curve kept" << std::endl;
+            continue;
+        }
+        LaserCurve& curve = profile.curves[c];
+        curve = LaserCurve::fit(it->second, max_power);
+        std::cout << colours[c] << ": gamma " << curve.gamma << ", black " << curve.black << ", max " << curve.max
+                  << std::endl;
+    }
+    profile.save(args[1]);
+    // Written as it will be read
+    LaserProfile::load(args[1]);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Throughput of the led_strip pixel kernels on the host: the SPI encoder (bit by
+// bit as it was, lookup table, changed pixels only) on a strip of GRB pixels, and
+// the HSV to RGB conversion (float as it was, integer).
+// Usage: led_strip_bench [pixels] [rounds]
+#include "led_strip_pixels.h"
+#include "led_strip_spi_encoder.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// __led_strip_spi_bit of led_strip_spi_dev.c before the lookup table, with its memset
+static void bit_encode(uint8_t* spi, const uint8_t* colors, size_t len) {
+    memset(spi, 0, len * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+    for (size_t i = 0; i < len; i++, spi += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE) {
+        uint8_t data = colors[i];
+        spi[2] |= data & 0x01 ? 0x06 : 0x04;
+        spi[2] |= data & 0x02 ? 0x30 : 0x20;
+        spi[2] |= data & 0x04 ? 0x80 : 0x00;
+        spi[1] |= 0x01;
+        spi[1] |= data & 0x08 ? 0x0C : 0x08;
+        spi[1] |= data & 0x10 ? 0x60 : 0x40;
+        spi[0] |= data & 0x20 ? 0x03 : 0x02;
+        spi[0] |= data & 0x40 ? 0x18 : 0x10;
+        spi[0] |= data & 0x80 ? 0xC0 : 0x80;
+    }
+}
+
+// led_strip_set_pixel_hsv before the integer conversion, for one pixel
+static void float_hsv(const led_strip_hsv_t& hsv, uint8_t* rgb) {
+    uint32_t rgb_max = hsv.value;
+    uint32_t rgb_min = rgb_max * (255 - hsv.saturation) / 255.0f;
+    uint32_t i = hsv.hue / 60;
+    uint32_t diff = hsv.hue % 60;
+    uint32_t rgb_adj = (rgb_max - rgb_min) * diff / 60;
+    uint32_t red, green, blue;
+    switch (i) {
+    case 0: red = rgb_max; green = rgb_min + rgb_adj; blue = rgb_min; break;
+    case 1: red = rgb_max - rgb_adj; green = rgb_max; blue = rgb_min; break;
+    case 2: red = rgb_min; green = rgb_max; blue = rgb_min + rgb_adj; break;
+    case 3: red = rgb_min; green = rgb_max - rgb_adj; blue = rgb_max; break;
+    case 4: red = rgb_min + rgb_adj; green = rgb_min; blue = rgb_max; break;
+    default: red = rgb_max; green = rgb_min; blue = rgb_max - rgb_adj; break;
+    }
+    rgb[0] = static_cast<uint8_t>(red);
+    rgb[1] = static_cast<uint8_t>(green);
+    rgb[2] = static_cast<uint8_t>(blue);
+}
+
+template <typename F>
+static void measure(const char* name, size_t pixels, int rounds, F&& encode) {
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        encode(round);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::setw(28) << std::left << name << std::fixed << std::setprecision(1)
+              << pixels * rounds / seconds / 1e6 << " Mpixel/s, " << seconds / rounds * 1e6 << " us per strip" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t pixels = argc > 1 ? std::stoul(argv[1]) : 10000;
+    int rounds = argc > 2 ? std::stoi(argv[2]) : 200;
+    size_t len = pixels * 3;
+
+    std::mt19937 rng(1);
+    std::vector<uint8_t> colors(len);
+    for (uint8_t& c : colors) {
+        c = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> spi(len * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+    std::vector<uint8_t> shadow(len);
+    volatile uint8_t sink = 0;
+
+    measure("bit by bit", pixels, rounds, [&](int) {
+        bit_encode(spi.data(), colors.data(), len);
+        sink = sink + spi[0];
+    });
+    measure("lookup table", pixels, rounds, [&](int) {
+        led_strip_spi_encode(spi.data(), colors.data(), len);
+        sink = sink + spi[0];
+    });
+    // A preview where 1 pixel in 10 changes between refreshes
+    led_strip_spi_encode_changed(spi.data(), shadow.data(), colors.data(), static_cast<uint32_t>(pixels), 3);
+    measure("changed only (10% changed)", pixels, rounds, [&](int round) {
+        for (size_t i = round % 10; i < pixels; i += 10) {
+            colors[i * 3]++;
+        }
+        led_strip_spi_encode_changed(spi.data(), shadow.data(), colors.data(), static_cast<uint32_t>(pixels), 3);
+        sink = sink + spi[0];
+    });
+
+    // A rainbow, where the sector of the float version is predictable, then random hues. Random saturation and value.
+    std::vector<led_strip_hsv_t> hsv(pixels);
+    std::vector<uint8_t> rgb(len);
+    for (bool rainbow : {true, false}) {
+        const char* hues = rainbow ? "rainbow" : "random";
+        for (size_t i = 0; i < pixels; i++) {
+            uint16_t hue = static_cast<uint16_t>(rainbow ? i * 360 / pixels : rng() % 360);
+            hsv[i] = {hue, static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())};
+        }
+        measure((std::string("HSV float, ") + hues).c_str(), pixels, rounds, [&](int) {
+            for (size_t i = 0; i < pixels; i++) {
+                float_hsv(hsv[i], &rgb[i * 3]);
+            }
+            sink = sink + rgb[0];
+        });
+        measure((std::string("HSV integer, ") + hues).c_str(), pixels, rounds, [&](int) {
+            led_strip_hsv_to_rgb(rgb.data(), hsv.data(), static_cast<uint32_t>(pixels));
+            sink = sink + rgb[0];
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Time of the host quantization levels (levels.hpp) per frame at the projector
+// geometry: histogram, adaptive level choice, application of the map and
+// dithering between its levels (dither.hpp) in its place, and the lookup into
+// the R G B lines of the projector (frame_kernels.hpp) on the geometry of the
+// rig known at compile time and on the same bounds known at run time.
+// Usage: levels_bench [frames]
+#include "dither.hpp"
+#include "frame_kernels.hpp"
+#include "levels.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const size_t PIXELS = 100 * 100;
+
+// Dark gradients with a bright disc and noise, flat areas included
+static std::vector<uint8_t> synthetic_frame(std::mt19937& rng, int t) {
+    std::vector<uint8_t> pixels(PIXELS * 3);
+    for (int y = 0; y < 100; y++) {
+        for (int x = 0; x < 100; x++) {
+            uint8_t* p = &pixels[(y * 100 + x) * 3];
+            double r = std::hypot(x - 50 - 20 * std::sin(t / 7.0), y - 50);
+            p[0] = static_cast<uint8_t>(r < 15 ? 240 : x / 2);
+            p[1] = static_cast<uint8_t>(y < 30 ? 8 : 20 + 20 * std::sin((x + t) / 9.0) + y / 4);
+            p[2] = static_cast<uint8_t>(y / 3 + rng() % 8);
+        }
+    }
+    return pixels;
+}
+
+template <typename F>
+static double us_per_call(int calls, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+        f(i);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::stoi(argv[1]) : 200;
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> input;
+    for (int i = 0; i < 20; i++) {
+        input.push_back(synthetic_frame(rng, i));
+    }
+
+    ChannelHistogram hist;
+    double histogram = us_per_call(frames, [&](int i) {
+        channel_histogram(input[i % input.size()].data(), PIXELS, hist);
+    });
+    AdaptiveLevels levels(8);
+    double update = us_per_call(frames, [&](int i) { levels.update(input[i % input.size()].data(), PIXELS); });
+    std::vector<uint8_t> out(PIXELS * 3);
+    double apply = us_per_call(frames, [&](int i) { levels.map().apply(input[i % input.size()].data(), PIXELS, out.data()); });
+
+    Dither dither;
+    double dithered = us_per_call(frames, [&](int i) {
+        dither.apply(levels.map(), input[i % input.size()].data(), 100, 100, out.data());
+    });
+
+    double rgb = us_per_call(frames, [&](int i) {
+        quantize_rgb(ProjectorGeometry(), levels.map(), input[i % input.size()].data(), 300, out.data());
+    });
+    double rgb_generic = us_per_call(frames, [&](int i) {
+        quantize_rgb(FrameGeometry<>(100, 100), levels.map(), input[i % input.size()].data(), 300, out.data());
+    });
+    double reorder = us_per_call(frames, [&](int i) {
+        reorder_rgb(ProjectorGeometry(), input[i % input.size()].data(), 300, out.data());
+    });
+    double reorder_generic = us_per_call(frames, [&](int i) {
+        reorder_rgb(FrameGeometry<>(100, 100), input[i % input.size()].data(), 300, out.data());
+    });
+
+    std::cout << std::fixed << std::setprecision(1) << "histogram " << histogram << " us, adaptive levels "
+              << update << " us (histogram included), apply " << apply << " us, dither " << dithered << " us per frame" << std::endl;
+    std::cout << "R G B lines: lookup " << rgb << " us (" << rgb_generic << " us generic), reorder " << reorder
+              << " us (" << reorder_generic << " us generic) per frame" << std::endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Sends frames through a pty pair standing in for the host link and reassembles them
+// with the firmware parser, to measure the sustained frame rate of the protocol.
+// Usage: link_loopback [frames]
+#include "frame_link.hpp"
+#include "frame_rx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::stoi(argv[1]) : 200;
+
+    int master = -1;
+    int slave = -1;
+    char name[64];
+    if (openpty(&master, &slave, name, nullptr, nullptr) < 0) {
+        throw std::runtime_error("Could not open a pty pair");
+    }
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    // Firmware side: frames are published then swapped immediately, as if every revolution took one
+    auto fb = std::make_unique<frame_buffer_t>();
+    auto rx = std::make_unique<frame_rx_t>();
+    frame_buffer_init(fb.get());
+    frame_rx_init(rx.get(), fb.get());
+    uint32_t shown = 0;
+    std::thread receiver([&] {
+        std::vector<uint8_t> buf(4096);
+        frame_buffer_stats_t stats = {};
+        // A skipped frame is counted on its first line, keep reading until its END
+        while (rx->frames_completed + rx->frames_incomplete + stats.skipped < static_cast<uint32_t>(frames) || rx->in_frame) {
+            ssize_t n = read(master, buf.data(), buf.size());
+            if (n <= 0) {
+                break;
+            }
+            // Feed packet sized pieces with a revolution in between, like the scan-out would
+            for (ssize_t i = 0; i < n; i += FRAME_PROTO_LINE_SIZE) {
+                frame_rx_feed(rx.get(), buf.data() + i, std::min<ssize_t>(FRAME_PROTO_LINE_SIZE, n - i));
+                if (frame_buffer_swap(fb.get())) {
+                    shown++;
+                }
+            }
+            frame_buffer_get_stats(fb.get(), &stats);
+        }
+    });
+
+    std::vector<uint8_t> rgb(LINES_PER_FRAME * PIXELS_PER_LINE * BYTES_PER_PIXEL);
+    FrameLink link(name);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        for (size_t j = 0; j < rgb.size(); j++) {
+            rgb[j] = static_cast<uint8_t>(i + j);
+        }
+        link.send_frame(rgb);
+    }
+    receiver.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "frames sent: " << frames << std::endl;
+    frame_buffer_stats_t stats;
+    frame_buffer_get_stats(fb.get(), &stats);
+    std::cout << "frames completed: " << rx->frames_completed << " incomplete: " << rx->frames_incomplete
+              << " skipped: " << stats.skipped << " shown: " << shown << std::endl;
+    std::cout << "bad headers: " << rx->bad_headers << " crc errors: " << rx->crc_errors << std::endl;
+    std::cout << "fps: " << frames / seconds << " ("
+              << frames * (LINES_PER_FRAME * (FRAME_PROTO_HEADER_SIZE + FRAME_PROTO_LINE_SIZE) + FRAME_PROTO_HEADER_SIZE) / seconds / 1024
+              << " KB/s)" << std::endl;
+    close(slave);
+    close(master);
+    return 0;
+}
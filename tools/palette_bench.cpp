@@ -0,0 +1,73 @@
+// Time of the host palette builder (palette.hpp) on synthetic frames at the
+// projector geometry: building a palette (scene change) and mapping a frame to
+// it (every frame), for 1 thread up to one per core.
+// Usage: palette_bench [frames]
+#include "palette.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t PIXELS = LINES_PER_FRAME * PIXELS_PER_LINE;
+
+// Gradients, discs and noise: a few thousand distinct colours, like a resized video frame
+static std::vector<uint8_t> synthetic_frame(std::mt19937& rng, int t) {
+    std::vector<uint8_t> rgb(PIXELS * 3);
+    for (int y = 0; y < LINES_PER_FRAME; y++) {
+        for (int x = 0; x < PIXELS_PER_LINE; x++) {
+            uint8_t* p = &rgb[(y * PIXELS_PER_LINE + x) * 3];
+            double r = std::hypot(x - 50 - 20 * std::sin(t / 7.0), y - 50);
+            p[0] = static_cast<uint8_t>(r < 25 ? 230 : x * 2);
+            p[1] = static_cast<uint8_t>(128 + 100 * std::sin((x + t) / 9.0) * std::cos(y / 13.0));
+            p[2] = static_cast<uint8_t>(y * 2 + rng() % 16);
+        }
+    }
+    return rgb;
+}
+
+template <typename F>
+static double ms_per_call(int calls, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+        f(i);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::stoi(argv[1]) : 20;
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> input;
+    for (int i = 0; i < frames; i++) {
+        input.push_back(synthetic_frame(rng, i));
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint8_t> indices(PIXELS);
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        PaletteBuilder builder(threads);
+        std::vector<Rgb> palette;
+        double build = ms_per_call(frames, [&](int i) { palette = builder.build(input[i].data(), PIXELS); });
+        double error = 0;
+        double map = ms_per_call(frames, [&](int i) { error = builder.map(input[i].data(), PIXELS, palette, indices.data()); });
+        std::cout << std::setw(2) << threads << " threads: build " << std::fixed << std::setprecision(2) << build
+                  << " ms, map " << map << " ms per frame, " << palette.size() << " colours, error "
+                  << std::setprecision(1) << error << std::endl;
+    }
+
+    // A whole sequence through the scene palette
+    ScenePalette scene;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::vector<uint8_t>& frame : input) {
+        scene.index(frame.data(), PIXELS, indices);
+    }
+    double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "scene palette: " << std::setprecision(2) << total / frames << " ms per frame, " << scene.rebuilds()
+              << " palettes for " << frames << " frames" << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Time of the resizing of video frames to the projector geometry: cv::resize
+// with its default (bilinear) interpolation as main did, cv::INTER_AREA on
+// OpenCV's threads and on one, and the area downscaler of area_resize.hpp, with
+// its largest difference to cv::INTER_AREA.
+// Usage: resize_bench [frames]
+#include "area_resize.hpp"
+
+#include <opencv2/opencv.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+template <typename F>
+static double us_per_call(int calls, F&& f) {
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) {
+        f();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+static void bench(int frames, cv::Size from, cv::Size to) {
+    cv::Mat src(from, CV_8UC3);
+    cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::GaussianBlur(src, src, cv::Size(0, 0), 3);
+    cv::Mat linear, area, box(to, CV_8UC3);
+    AreaDownscaler downscaler;
+
+    int threads = cv::getNumThreads();
+    double linear_us = us_per_call(frames, [&] { cv::resize(src, linear, to); });
+    double area_us = us_per_call(frames, [&] { cv::resize(src, area, to, 0, 0, cv::INTER_AREA); });
+    cv::setNumThreads(1);
+    double area_one_us = us_per_call(frames, [&] { cv::resize(src, area, to, 0, 0, cv::INTER_AREA); });
+    cv::setNumThreads(threads);
+    double box_us = us_per_call(frames, [&] {
+        downscaler.resize(src.ptr(), src.cols, src.rows, src.step, box.ptr(), box.cols, box.rows);
+    });
+
+    cv::Mat diff;
+    cv::absdiff(area, box, diff);
+    double max_diff;
+    cv::minMaxLoc(diff.reshape(1), nullptr, &max_diff);
+    std::cout << std::fixed << std::setprecision(0) << from.width << "x" << from.height << " to " << to.width << "x"
+              << to.height << ": linear " << linear_us << " us, area " << area_us << " us (" << area_one_us
+              << " us on one thread), box " << box_us << " us, " << std::setprecision(1) << area_one_us / box_us
+              << "x area on one thread, difference to area " << std::setprecision(0) << max_diff << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::stoi(argv[1]) : 100;
+    bench(frames, cv::Size(1920, 1080), cv::Size(100, 100));
+    bench(frames, cv::Size(1280, 720), cv::Size(100, 100));
+    bench(frames, cv::Size(3840, 2160), cv::Size(100, 100));
+    // Integer ratios of their own code
+    bench(frames, cv::Size(1000, 1000), cv::Size(100, 100));
+    bench(frames, cv::Size(800, 800), cv::Size(100, 100));
+    bench(frames, cv::Size(200, 200), cv::Size(100, 100));
+    // Low resolution of the QoS governor
+    bench(frames, cv::Size(1920, 1080), cv::Size(50, 50));
+    return 0;
+}
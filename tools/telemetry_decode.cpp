@@ -0,0 +1,127 @@
+// Decodes the TLM: lines the firmware prints every second (idf.py monitor output on stdin)
+// into readable histograms of motor/mirror jitter, line start latency and line overruns.
+// Usage: idf.py monitor | telemetry_decode [-v]
+#include "telemetry.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<uint8_t> base64_decode(const std::string& text) {
+    std::vector<uint8_t> out;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : text) {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '+') v = 62;
+        else if (c == '/') v = 63;
+        else break;  // Padding or end of the log line (color codes)
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> bits));
+        }
+    }
+    return out;
+}
+
+// Range of microseconds covered by a bucket, as text
+static std::string bucket_range(int hist, int bucket) {
+    std::ostringstream out;
+    if (hist == TELEMETRY_MOTOR_JITTER || hist == TELEMETRY_MIRROR_JITTER) {
+        int k = bucket - TELEMETRY_BUCKETS / 2;
+        if (k == 0) {
+            return "|d|<1us";
+        }
+        int magnitude = k < 0 ? -k : k;
+        if (k < 0) {
+            out << "-" << (1u << magnitude) << "..-" << (1u << (magnitude - 1)) << "us";
+        } else {
+            out << "+" << (1u << (magnitude - 1)) << "..+" << (1u << magnitude) << "us";
+        }
+    } else {
+        if (bucket == 0) {
+            return "0us";
+        }
+        out << (1u << (bucket - 1)) << ".." << (1u << bucket) << "us";
+    }
+    return out.str();
+}
+
+// Upper bound (in us) of the bucket holding the given quantile of the absolute value
+static uint32_t quantile_us(const telemetry_window_t& window, int hist, uint32_t total, double q) {
+    bool signed_hist = hist == TELEMETRY_MOTOR_JITTER || hist == TELEMETRY_MIRROR_JITTER;
+    uint32_t magnitude_counts[TELEMETRY_BUCKETS] = {};
+    for (int b = 0; b < TELEMETRY_BUCKETS; b++) {
+        int k = signed_hist ? std::abs(b - TELEMETRY_BUCKETS / 2) : b;
+        magnitude_counts[k] += window.buckets[hist][b];
+    }
+    uint64_t seen = 0;
+    for (int k = 0; k < TELEMETRY_BUCKETS; k++) {
+        seen += magnitude_counts[k];
+        if (seen >= q * total) {
+            return k == 0 ? 0 : (1u << k);
+        }
+    }
+    return window.max_us[hist];
+}
+
+static const char* hist_names[TELEMETRY_HIST_COUNT] = {
+    "motor jitter", "mirror jitter", "line latency", "line overrun"
+};
+
+int main(int argc, char** argv) {
+    bool verbose = argc > 1 && std::strcmp(argv[1], "-v") == 0;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        size_t pos = line.find("TLM:");
+        if (pos == std::string::npos) {
+            continue;
+        }
+        std::vector<uint8_t> data = base64_decode(line.substr(pos + 4));
+        telemetry_report_t report;
+        if (!telemetry_parse(data.data(), data.size(), &report)) {
+            std::cerr << "Malformed telemetry: " << line << std::endl;
+            continue;
+        }
+
+        std::cout << "#" << report.seq << " window " << report.window_ms << " ms"
+                  << "  motor period " << report.mean_period_us[TELEMETRY_MOTOR] << " us"
+                  << "  mirror period " << report.mean_period_us[TELEMETRY_MIRROR] << " us"
+                  << "  glitches motor " << report.window.glitches[TELEMETRY_MOTOR]
+                  << " mirror " << report.window.glitches[TELEMETRY_MIRROR] << std::endl;
+        for (int h = 0; h < TELEMETRY_HIST_COUNT; h++) {
+            uint32_t total = 0;
+            for (int b = 0; b < TELEMETRY_BUCKETS; b++) {
+                total += report.window.buckets[h][b];
+            }
+            std::cout << "  " << std::left << std::setw(14) << hist_names[h] << std::right
+                      << " n=" << std::setw(7) << total;
+            if (total > 0) {
+                std::cout << "  p50<=" << quantile_us(report.window, h, total, 0.50) << "us"
+                          << "  p99<=" << quantile_us(report.window, h, total, 0.99) << "us"
+                          << "  max=" << report.window.max_us[h] << "us";
+            }
+            std::cout << std::endl;
+            if (verbose) {
+                for (int b = 0; b < TELEMETRY_BUCKETS; b++) {
+                    if (report.window.buckets[h][b] != 0) {
+                        std::cout << "      " << std::setw(16) << bucket_range(h, b) << "  "
+                                  << report.window.buckets[h][b] << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}